@@ -1,300 +1,238 @@
+#include "enigmacore/enigmacore.h"
+#include "enigmacore/keystore.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <string>
-#include <cstdlib>
-#include <fstream>
 #include <vector>
-#include <openssl/rand.h>
-#include <openssl/evp.h>
-#include <openssl/err.h>
-#include <filesystem>
-#include <iomanip>
-#include <sstream>
-#include <chrono>
-
-// Función para manejar errores de OpenSSL
-void handleErrors() {
-    ERR_print_errors_fp(stderr);
-    abort();
-}
-
-// Función para cifrar y descifrar datos usando AES-CTR
-// Esta función toma como entrada los datos que se desean cifrar/descifrar, una clave (key),
-// un vector de inicialización (iv), y genera la salida correspondiente en la variable 'output'.
-// El parámetro 'encrypt' define si la operación es de cifrado (true) o descifrado (false).
-void aesCrypt(const unsigned char *input, int input_len, unsigned char *key, unsigned char *iv, unsigned char *output,
-              bool encrypt) {
-    // Crear y inicializar el contexto de cifrado/descifrado
-    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) handleErrors(); // Manejar errores si la creación del contexto falla
-
-    // Seleccionar el cifrado AES en modo CTR
-    const EVP_CIPHER *cipher = EVP_aes_256_ctr();
-
-    // Inicializar el contexto dependiendo de si se va a cifrar o descifrar
-    if (encrypt) {
-        // Inicialización para cifrado
-        if (1 != EVP_EncryptInit_ex(ctx, cipher, NULL, key, iv)) handleErrors();
-    } else {
-        // Inicialización para descifrado
-        if (1 != EVP_DecryptInit_ex(ctx, cipher, NULL, key, iv)) handleErrors();
-    }
-
-    int len; // Variable para almacenar el tamaño de los datos procesados
-
-    // Actualizar el contexto con los datos de entrada y obtener la salida cifrada/descifrada
-    if (1 != (encrypt
-                  ? EVP_EncryptUpdate(ctx, output, &len, input, input_len) // Cifrar datos
-                  : EVP_DecryptUpdate(ctx, output, &len, input, input_len))) // Descifrar datos
-        handleErrors(); // Manejar errores si la operación falla
-
-    // Liberar el contexto de cifrado/descifrado
-    EVP_CIPHER_CTX_free(ctx);
-}
 
-// Función para formatear el tamaño en bytes a una representación legible
-std::string formatBytes(size_t bytes) {
-    const double KB = 1024.0;
-    const double MB = KB * 1024.0;
-    const double GB = MB * 1024.0;
+// Interfaz de línea de comandos de EnigmaCore: toda la lógica de cifrado vive en libenigmacore
 
-    std::ostringstream oss;
-    if (bytes < KB) {
-        oss << std::fixed << std::setprecision(2) << bytes << " bytes";
-    } else if (bytes < MB) {
-        oss << std::fixed << std::setprecision(2) << bytes / KB << " KB";
-    } else if (bytes < GB) {
-        oss << std::fixed << std::setprecision(2) << bytes / MB << " MB";
-    } else {
-        oss << std::fixed << std::setprecision(2) << bytes / GB << " GB";
-    }
-    return oss.str();
-}
-
-// Función para mostrar la barra de progreso
-void showProgress(size_t current, size_t total, size_t updateInterval = 1024) {
-    static size_t lastUpdate = 0; // Última actualización
-    static auto lastUpdateTime = std::chrono::steady_clock::now(); // Hora de la última actualización
-
-    // Calcula el progreso
-    float progress = (float) current / total;
-    int barWidth = 50;
-    int pos = barWidth * progress;
-
-    // Solo actualiza si se han procesado suficientes bytes o ha pasado suficiente tiempo
-    if (current - lastUpdate >= updateInterval || std::chrono::steady_clock::now() - lastUpdateTime >
-        std::chrono::milliseconds(500)) {
-        std::cout << "\r[" << std::string(pos, '#') << std::string(barWidth - pos, ' ') << "] "
-                << int(progress * 100.0) << "% "
-                << std::flush;
-
-        lastUpdate = current;
-        lastUpdateTime = std::chrono::steady_clock::now();
-    }
-}
-
-std::string formatDuration(double seconds) {
-    std::ostringstream oss;
-
-    if (seconds < 1e-6) {
-        // Menos de 1 microsegundo
-        oss << std::fixed << std::setprecision(2) << seconds * 1e9 << " ns"; // Nanosegundos
-    } else if (seconds < 1e-3) {
-        // Menos de 1 milisegundo
-        oss << std::fixed << std::setprecision(2) << seconds * 1e6 << " µs"; // Microsegundos
-    } else if (seconds < 1.0) {
-        // Menos de 1 segundo
-        oss << std::fixed << std::setprecision(2) << seconds * 1e3 << " ms"; // Milisegundos
-    } else if (seconds < 60.0) {
-        // Menos de 1 minuto
-        oss << std::fixed << std::setprecision(2) << seconds << " s"; // Segundos
-    } else if (seconds < 3600.0) {
-        // Menos de 1 hora
-        int minutes = static_cast<int>(seconds) / 60;
-        int secs = static_cast<int>(seconds) % 60;
-        oss << minutes << " min " << secs << " s"; // Minutos y segundos
-    } else {
-        // 1 hora o más
-        int hours = static_cast<int>(seconds) / 3600;
-        int minutes = (static_cast<int>(seconds) % 3600) / 60;
-        int secs = static_cast<int>(seconds) % 60;
-        oss << hours << " h " << minutes << " min " << secs << " s"; // Horas, minutos y segundos
-    }
-
-    return oss.str();
-}
+// Se activa con Ctrl+C o SIGTERM para terminar el modo watch de forma ordenada
+static std::atomic<bool> stopRequested{false};
 
-// Función para imprimir los resultados del proceso
-void printFormattedResults(size_t originalSize, size_t processedSize, double duration) {
-    std::cout << "\n--- Resumen del Proceso ---" << std::endl;
-    std::cout << "Tamaño del archivo original: " << formatBytes(originalSize) << std::endl; // Tamaño original
-    std::cout << "Tamaño del archivo procesado: " << formatBytes(processedSize) << std::endl; // Tamaño procesado
-    std::cout << "Diferencia de tamaño: " << formatBytes(
-        std::abs(static_cast<long long>(processedSize) - static_cast<long long>(originalSize))) << std::endl;
-    // Diferencia de tamaño
-    std::cout << "Tiempo total: " << formatDuration(duration) << std::endl; // Tiempo total
-    std::cout << "----------------------------\n" << std::endl;
+static void requestStop(int) {
+    stopRequested = true;
 }
 
-// Función para cifrar un archivo
-void encrypt(const std::string &input_path, const std::string &output_path) {
-    // Mostrar las rutas de los archivos de entrada y salida
-    std::cout << "input_path=" << input_path << std::endl;
-    std::cout << "output_path=" << output_path << std::endl;
-
-    // Crear el directorio de salida si no existe
-    std::filesystem::path outputFilePath(output_path);
-    std::filesystem::path outputDir = outputFilePath.parent_path();
-    if (!std::filesystem::exists(outputDir)) {
-        // Si el directorio de salida no existe, intentar crearlo
-        if (!std::filesystem::create_directories(outputDir)) {
-            std::cerr << "❌ [ERROR] No se pudo crear el directorio: " << outputDir << std::endl;
-            return; // Salir si la creación del directorio falla
+int main(int argc, char *argv[]) {
+    // Separa las opciones (--nombre=valor) de los argumentos posicionales
+    std::map<std::string, std::string> options;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            options[arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2)] =
+                    eq == std::string::npos ? "1" : arg.substr(eq + 1);
+        } else {
+            args.push_back(arg);
         }
     }
 
-    // Abrir el archivo de entrada en modo binario
-    std::ifstream inputFile(input_path, std::ios::binary);
-    if (!inputFile) {
-        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
-        return; // Salir si no se puede abrir el archivo de entrada
+    // Perfil de rendimiento: el guardado por autotune y, por encima, las opciones de la línea de comandos
+    enigmacore::TuningProfile profile;
+    std::string config_path = options.count("config") ? options["config"] : enigmacore::defaultTuningPath();
+    if (!enigmacore::loadTuningProfile(config_path, profile) && options.count("config")) {
+        std::cerr << "❌ [ERROR] No se pudo leer el perfil: " << config_path << std::endl;
+        return 1;
     }
-
-    // Crear el archivo de salida en modo binario
-    std::ofstream outputFile(output_path, std::ios::binary);
-    if (!outputFile) {
-        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
-        return; // Salir si no se puede crear el archivo de salida
+    if (options.count("chunk-size")) profile.chunk_size = enigmacore::parseSize(options["chunk-size"]);
+    if (options.count("threads")) profile.threads = std::strtoull(options["threads"].c_str(), nullptr, 10);
+    if (options.count("io")) profile.io = options["io"];
+    if (options.count("max-memory")) profile.max_memory = enigmacore::parseSize(options["max-memory"]);
+    if (options.count("cipher")) profile.cipher = options["cipher"];
+    if (profile.chunk_size == 0 || profile.chunk_size > enigmacore::kMaxChunkSize ||
+        (profile.io != "auto" && profile.io != "stream" && profile.io != "pread" && profile.io != "mmap") ||
+        (profile.cipher != "openssl" && profile.cipher != "kernel") ||
+        (profile.max_memory && profile.max_memory < enigmacore::kMinMaxMemory)) {
+        std::cerr << "❌ [ERROR] Opciones de rendimiento no válidas (--chunk-size hasta "
+                << enigmacore::formatBytes(enigmacore::kMaxChunkSize) << ", --io=auto|stream|pread|mmap, "
+                << "--cipher=openssl|kernel, --max-memory de al menos "
+                << enigmacore::formatBytes(enigmacore::kMinMaxMemory) << ")" << std::endl;
+        return 1;
     }
+    enigmacore::setTuningProfile(profile);
 
-    // Preparar un buffer para leer el archivo en bloques
-    std::vector<unsigned char> buffer(4096);
-    unsigned char key[32], iv[16];
-    // Generar la clave y el vector de inicialización (IV) aleatorios
-    RAND_bytes(key, sizeof(key));
-    RAND_bytes(iv, sizeof(iv));
-    // Guardar la clave y el IV en el archivo de salida (por ejemplo, al principio del archivo)
-    outputFile.write(reinterpret_cast<char*>(key), sizeof(key));
-    outputFile.write(reinterpret_cast<char*>(iv), sizeof(iv));
-
-    size_t totalBytesRead = 0; // Contador de bytes leídos
-    size_t fileSize = std::filesystem::file_size(input_path); // Obtener el tamaño total del archivo
-
-    // Leer el archivo en bloques y cifrar cada bloque
-    while (inputFile.read(reinterpret_cast<char *>(buffer.data()), buffer.size()) || inputFile.gcount() > 0) {
-        std::vector<unsigned char> outputBuffer(inputFile.gcount());
-        // Cifrar los datos leídos en el buffer
-        aesCrypt(buffer.data(), inputFile.gcount(), key, iv, outputBuffer.data(), true);
-        // Escribir los datos cifrados en el archivo de salida
-        outputFile.write(reinterpret_cast<char *>(outputBuffer.data()), inputFile.gcount());
-        totalBytesRead += inputFile.gcount(); // Actualizar el contador de bytes leídos
-
-        // Comentar la siguiente línea para habilitar la barra de progreso opcional
-        // showProgress(totalBytesRead, fileSize);
+    // decrypt-tile recibe las coordenadas de la tesela además de las rutas
+    if (args.size() == 5 && args[0] == "decrypt-tile") {
+        return enigmacore::decryptTile(args[1], std::strtoull(args[2].c_str(), nullptr, 10),
+                                       std::strtoull(args[3].c_str(), nullptr, 10), args[4]) ? 0 : 1;
     }
 
-    // Imprimir un mensaje indicando que el proceso de cifrado ha finalizado
-    std::cout << std::endl;
-    std::cout << "Encrypted image" << std::endl;
-}
-
-
-// Función para descifrar un archivo
-void decrypt(const std::string &input_path, const std::string &output_path) {
-    // Mostrar las rutas de los archivos de entrada y salida
-    std::cout << "input_path=" << input_path << std::endl;
-    std::cout << "output_path=" << output_path << std::endl;
+    // run-jobs escribe los resultados en la salida estándar si no se indica un archivo
+    if ((args.size() == 2 || args.size() == 3) && args[0] == "run-jobs") {
+        enigmacore::BatchOptions batch;
+        if (options.count("keys-dir")) batch.keys_dir = options["keys-dir"];
+        if (options.count("keystore")) batch.keystore = options["keystore"];
+        if (options.count("threads")) batch.threads = std::strtoull(options["threads"].c_str(), nullptr, 10);
+        if (options.count("large-file")) batch.large_file_size = enigmacore::parseSize(options["large-file"]);
+        return enigmacore::runJobs(args[1], args.size() == 3 ? args[2] : "-", batch) ? 0 : 1;
+    }
 
-    // Crear el directorio de salida si no existe
-    std::filesystem::path outputFilePath(output_path);
-    std::filesystem::path outputDir = outputFilePath.parent_path();
-    if (!std::filesystem::exists(outputDir)) {
-        // Si el directorio de salida no existe, intentar crearlo
-        if (!std::filesystem::create_directories(outputDir)) {
-            std::cerr << "❌ [ERROR] No se pudo crear el directorio: " << outputDir << std::endl;
-            return; // Salir si la creación del directorio falla
+    // verify comprueba la integridad de archivos con llave sin escribir nada: verify <rutas...> --keystore=<almacén>
+    if (args.size() >= 2 && args[0] == "verify") {
+        if (!options.count("keystore")) {
+            std::cerr << "❌ [ERROR] verify necesita el almacén de llaves (--keystore)" << std::endl;
+            return 1;
         }
+        enigmacore::Keystore keystore;
+        if (!keystore.open(options["keystore"])) return 1;
+        enigmacore::AuditOptions audit;
+        audit.check_digest = options.count("digest") > 0;
+        if (options.count("threads")) audit.threads = std::strtoull(options["threads"].c_str(), nullptr, 10);
+        return enigmacore::auditFiles(std::vector<std::string>(args.begin() + 1, args.end()), keystore, audit) ? 0 : 1;
     }
 
-    // Abrir el archivo de entrada en modo binario
-    std::ifstream inputFile(input_path, std::ios::binary);
-    if (!inputFile) {
-        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
-        return; // Salir si no se puede abrir el archivo de entrada
+    // Verifica que haya exactamente 3 argumentos posicionales (operación, entrada y salida)
+    if (args.size() != 3) {
+        // Muestra el uso correcto del programa si los argumentos son incorrectos
+        std::cerr << "Uso: " << argv[0] << " <operation> <input_path> <output_path> [opciones]" << std::endl;
+        std::cerr << "     " << argv[0] << " decrypt-tile <input_path> <x> <y> <output_path>" << std::endl;
+        std::cerr << "     " << argv[0] << " run-jobs <manifest.jsonl> [results.jsonl] [opciones]" << std::endl;
+        std::cerr << "     " << argv[0] << " verify <rutas...> --keystore=<almacén> [--digest]" << std::endl;
+        return 1;
     }
 
-    // Crear el archivo de salida en modo binario
-    std::ofstream outputFile(output_path, std::ios::binary);
-    if (!outputFile) {
-        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
-        return; // Salir si no se puede crear el archivo de salida
+    // Asigna los argumentos de la línea de comandos a variables de string para facilidad de uso
+    std::string operation = args[0];
+    std::string input_path = args[1];
+    std::string output_path = args[2];
+
+    // Calibración del perfil de rendimiento en el sistema de archivos de destino
+    if (operation == "autotune") {
+        uint64_t sampleSize = options.count("sample-size") ? enigmacore::parseSize(options["sample-size"])
+                                                           : 256ULL << 20;
+        return enigmacore::autotune(input_path, output_path, sampleSize) ? 0 : 1;
     }
 
-    // Preparar un buffer para leer el archivo en bloques
-    std::vector<unsigned char> buffer(4096);
-    unsigned char key[32], iv[16];
-    // Leer la clave y el IV del archivo cifrado
-    inputFile.read(reinterpret_cast<char*>(key), sizeof(key));
-    inputFile.read(reinterpret_cast<char*>(iv), sizeof(iv));
-
-    size_t totalBytesRead = 0; // Contador de bytes leídos
-    size_t fileSize = std::filesystem::file_size(input_path); // Obtener el tamaño total del archivo
-
-    // Leer el archivo en bloques y descifrar cada bloque
-    while (inputFile.read(reinterpret_cast<char *>(buffer.data()), buffer.size()) || inputFile.gcount() > 0) {
-        std::vector<unsigned char> outputBuffer(inputFile.gcount());
-        // Descifrar los datos leídos en el buffer
-        aesCrypt(buffer.data(), inputFile.gcount(), key, iv, outputBuffer.data(), false);
-        // Escribir los datos descifrados en el archivo de salida
-        outputFile.write(reinterpret_cast<char *>(outputBuffer.data()), inputFile.gcount());
-        totalBytesRead += inputFile.gcount(); // Actualizar el contador de bytes leídos
-
-        // Comentar la siguiente línea para habilitar la barra de progreso opcional
-        // showProgress(totalBytesRead, fileSize);
+    // Generación de llaves en paralelo: keygen <almacén> <número de llaves>
+    if (operation == "keygen") {
+        enigmacore::KeygenOptions keygen;
+        std::string type = options.count("type") ? options["type"] : "rsa";
+        if (type != "rsa" && type != "ec") {
+            std::cerr << "❌ [ERROR] Tipo de llave no válido (--type=rsa|ec): " << type << std::endl;
+            return 1;
+        }
+        keygen.type = type == "ec" ? enigmacore::KeyType::EC : enigmacore::KeyType::RSA;
+        if (options.count("bits")) keygen.rsa_bits = std::atoi(options["bits"].c_str());
+        if (options.count("curve")) keygen.curve = options["curve"];
+        if (options.count("prefix")) keygen.prefix = options["prefix"];
+        if (options.count("threads")) keygen.threads = std::strtoull(options["threads"].c_str(), nullptr, 10);
+        size_t count = std::strtoull(output_path.c_str(), nullptr, 10);
+        return enigmacore::generateKeystore(input_path, count, keygen) ? 0 : 1;
     }
 
-    std::cout << std::endl;
-    std::cout << "Decrypted image" << std::endl;
-}
+    // Restauración de un directorio completo con las claves recuperadas en paralelo
+    if (operation == "restore") {
+        enigmacore::RestoreOptions restore;
+        if (options.count("private-key")) restore.private_key = options["private-key"];
+        if (options.count("keystore")) restore.keystore = options["keystore"];
+        if (options.count("suffix")) restore.suffix = options["suffix"];
+        return enigmacore::restoreFiles(input_path, output_path, restore) ? 0 : 1;
+    }
 
-int main(int argc, char *argv[]) {
-    // Verifica que el número de argumentos sea exactamente 4 (nombre del programa + 3 argumentos)
-    if (argc != 4) {
-        // Muestra el uso correcto del programa si los argumentos son incorrectos
-        std::cerr << "Uso: " << argv[0] << " <operation> <input_path> <output_path>" << std::endl;
-        return 1;
+    // Vigilancia de una carpeta: se ejecuta hasta recibir SIGINT o SIGTERM
+    if (operation == "watch") {
+        enigmacore::WatchOptions watch;
+        if (options.count("threads")) watch.threads = std::strtoull(options["threads"].c_str(), nullptr, 10);
+        if (options.count("debounce")) watch.debounce_ms = std::strtoul(options["debounce"].c_str(), nullptr, 10);
+        if (options.count("delete-originals")) watch.after = enigmacore::WatchOptions::DeleteOriginals;
+        if (options.count("move-originals")) {
+            watch.after = enigmacore::WatchOptions::MoveOriginals;
+            watch.move_dir = options["move-originals"];
+        }
+        watch.stop = &stopRequested;
+        std::signal(SIGINT, requestStop);
+        std::signal(SIGTERM, requestStop);
+        return enigmacore::watchFolder(input_path, output_path, watch) ? 0 : 1;
     }
 
-    // Asigna los argumentos de la línea de comandos a variables de string para facilidad de uso
-    std::string operation = argv[1];
-    std::string input_path = argv[2];
-    std::string output_path = argv[3];
+    // Con --keystore, encrypt y decrypt usan el formato con llave del almacén (--key-id al cifrar)
+    enigmacore::Keystore keystore;
+    bool keyed = options.count("keystore") != 0;
+    if (keyed && !keystore.open(options["keystore"])) return 1;
 
     // Inicia un temporizador para medir la duración de la operación
     auto start = std::chrono::high_resolution_clock::now();
 
     // Verifica qué operación debe realizarse: cifrar o descifrar
+    bool ok;
     if (operation == "encrypt") {
         // Si la operación es "encrypt", llama a la función de cifrado
-        encrypt(input_path, output_path);
+        ok = keyed ? enigmacore::encryptKeyed(input_path, output_path, keystore, options["key-id"])
+                   : enigmacore::encrypt(input_path, output_path);
     } else if (operation == "decrypt") {
         // Si la operación es "decrypt", llama a la función de descifrado
-        decrypt(input_path, output_path);
+        ok = keyed ? enigmacore::decryptKeyed(input_path, output_path, keystore)
+                   : enigmacore::decrypt(input_path, output_path);
+    } else if (operation == "encrypt-incremental") {
+        // Cifrado incremental: solo se reescriben los fragmentos que cambiaron; la clave va envuelta con --key-id
+        if (!keyed) {
+            std::cerr << "❌ [ERROR] encrypt-incremental necesita el almacén de llaves (--keystore y --key-id)"
+                    << std::endl;
+            return 1;
+        }
+        ok = enigmacore::encryptIncremental(input_path, output_path, keystore, options["key-id"]);
+    } else if (operation == "decrypt-incremental") {
+        ok = enigmacore::decryptIncremental(input_path, output_path, keystore);
+    } else if (operation == "encrypt-sparse") {
+        // Cifrado de archivos dispersos: los huecos y bloques a cero no se cifran
+        ok = enigmacore::encryptSparse(input_path, output_path);
+    } else if (operation == "decrypt-sparse") {
+        ok = enigmacore::decryptSparse(input_path, output_path);
+    } else if (operation == "encrypt-selective") {
+        // Cifrado selectivo de JPEG/TIFF: datos de imagen y metadatos sensibles, sin tocar la estructura
+        ok = enigmacore::encryptSelective(input_path, output_path);
+    } else if (operation == "decrypt-selective") {
+        ok = enigmacore::decryptSelective(input_path, output_path);
+    } else if (operation == "encrypt-tiles") {
+        // Cifrado por teselas: cada tesela se puede descifrar por separado con decrypt-tile
+        ok = enigmacore::encryptTiles(input_path, output_path);
+    } else if (operation == "decrypt-tiles") {
+        ok = enigmacore::decryptTiles(input_path, output_path);
+    } else if (operation == "encrypt-sharded") {
+        // Salida en varios fragmentos escritos en paralelo (--shard-size=256M por defecto); la clave va envuelta
+        // con --key-id
+        if (!keyed) {
+            std::cerr << "❌ [ERROR] encrypt-sharded necesita el almacén de llaves (--keystore y --key-id)" << std::endl;
+            return 1;
+        }
+        uint64_t shardSize = options.count("shard-size") ? enigmacore::parseSize(options["shard-size"])
+                                                         : enigmacore::kDefaultShardSize;
+        if (shardSize == 0) {
+            std::cerr << "❌ [ERROR] Tamaño de fragmento no válido (--shard-size, por ejemplo 64M)" << std::endl;
+            return 1;
+        }
+        ok = enigmacore::encryptSharded(input_path, output_path, shardSize, keystore, options["key-id"]);
+    } else if (operation == "decrypt-sharded") {
+        ok = enigmacore::decryptSharded(input_path, output_path, keystore);
+    } else if (operation == "benchmark-selective") {
+        // Comparación de rendimiento selectivo vs. completo; el informe se guarda en output_path
+        ok = enigmacore::benchmarkSelective(input_path, output_path);
     } else {
         // Si la operación no es válida, muestra un mensaje de error y termina el programa
         std::cerr << "Operación no válida: " << operation << std::endl;
         return 1; // Devuelve 1 para indicar un error en la ejecución
     }
+    if (!ok) return 1;
 
     // Detiene el temporizador y calcula la duración de la operación
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> duration = end - start;
 
     // Obtiene el tamaño de los archivos de entrada y salida
-    size_t processedFileSize = std::filesystem::file_size(output_path);
-    size_t originalFileSize = std::filesystem::file_size(input_path);
+    size_t processedFileSize = enigmacore::pathSize(output_path);
+    size_t originalFileSize = enigmacore::pathSize(input_path);
 
-    // Imprime información detallada del proceso (descomentando la siguiente línea)
-    // printFormattedResults(originalFileSize, processedFileSize, duration.count());
+    // Imprime información detallada del proceso con --stats
+    if (options.count("stats")) {
+        enigmacore::printFormattedResults(originalFileSize, processedFileSize, duration.count());
+    }
 
     return 0;
 }
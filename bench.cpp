@@ -0,0 +1,301 @@
+#include "enigmacore/enigmacore.h"
+#include "internal.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <openssl/evp.h>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+// Benchmark de rendimiento del motor AES-256-CTR por nodo NUMA. Compara hilos fijados a su nodo con
+// buffers locales frente a hilos sin fijar con todos los buffers reservados por el hilo principal, y
+// mide la escalabilidad entre nodos. También compara aesCrypt con la dirección elegida en tiempo de
+// ejecución frente a la instanciación por políticas, y el cifrado de archivo a archivo con OpenSSL frente al
+// cifrado en el kernel (AF_ALG con splice).
+
+using namespace enigmacore;
+
+using Clock = std::chrono::steady_clock;
+
+// Tramo que se cifra en cada llamada, como en los segmentos del motor
+const size_t kStep = 1 << 20;
+
+// Resultado de un hilo
+struct WorkerResult {
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// Función para generar una clave aleatoria; si falla, el benchmark termina
+static KeyMaterial randomKey() {
+    KeyMaterial material;
+    if (!generateKey(material)) handleErrors();
+    return material;
+}
+
+// Función para cifrar 'rounds' veces el buffer completo y medir el tiempo
+static WorkerResult runWorker(unsigned char *buffer, size_t size, int rounds, const KeyMaterial &material) {
+    WorkerResult result;
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t offset = 0; offset < size; offset += kStep) {
+            size_t len = std::min(kStep, size - offset);
+            if (!aesCtrAt(buffer + offset, len, material.key, material.iv, offset, buffer + offset)) handleErrors();
+        }
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.bytes = static_cast<uint64_t>(size) * rounds;
+    return result;
+}
+
+// Referencia: aesCrypt con la dirección en tiempo de ejecución, como era antes de las políticas (un contexto
+// nuevo en cada llamada y la dirección comprobada en la inicialización y en cada actualización)
+static void runtimeAesCrypt(const unsigned char *input, int input_len, const unsigned char *key,
+                            const unsigned char *iv, unsigned char *output, bool encrypt) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) handleErrors();
+    if (1 != (encrypt ? EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, iv)
+                      : EVP_DecryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, iv))) handleErrors();
+    int len;
+    if (1 != (encrypt ? EVP_EncryptUpdate(ctx, output, &len, input, input_len)
+                      : EVP_DecryptUpdate(ctx, output, &len, input, input_len))) handleErrors();
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+// Función para medir el rendimiento en GB/s de 'crypt' procesando el buffer en bloques de 'chunk' bytes
+template <class Crypt>
+static double chunkThroughput(unsigned char *buffer, size_t size, size_t chunk, int rounds, Crypt crypt) {
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t offset = 0; offset < size; offset += chunk) crypt(buffer + offset, std::min(chunk, size - offset));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return seconds > 0 ? static_cast<double>(size) * rounds / seconds / 1e9 : 0;
+}
+
+// Resultado de cifrar un archivo con encrypt()
+struct FileRun {
+    bool ok = false;
+    double seconds = 0;
+    double cpuSeconds = 0; // usuario y sistema de todos los hilos; el cifrado en el kernel cuenta como sistema
+};
+
+// Función para obtener la CPU consumida por el proceso hasta ahora, en segundos
+static double processCpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Función para cifrar 'input' con el motor 'cipher' y 'threads' hilos, midiendo el tiempo y la CPU
+static FileRun runFileEncrypt(const std::string &input, const std::string &output, const std::string &cipher,
+                              size_t threads) {
+    TuningProfile profile = tuningProfile();
+    profile.cipher = cipher;
+    profile.io = "pread";
+    profile.threads = threads;
+    setTuningProfile(profile);
+
+    FileRun run;
+    double cpuStart = processCpuSeconds();
+    auto start = Clock::now();
+    run.ok = encrypt(input, output);
+    run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    run.cpuSeconds = processCpuSeconds() - cpuStart;
+    return run;
+}
+
+// Función para mostrar el rendimiento y la CPU por GB de una pasada
+static void printFileRun(const char *name, const FileRun &run, uint64_t size) {
+    double gigabytes = size / 1e9;
+    std::cout << name << ": " << gigabytes / run.seconds << " GB/s, CPU " << run.cpuSeconds / gigabytes << " s/GB ("
+            << 100 * run.cpuSeconds / run.seconds << "% de un núcleo)" << std::endl;
+}
+
+// Función para ejecutar un hilo por CPU de los nodos indicados. Con 'local' cada hilo se fija a su nodo y
+// reserva su propio buffer; si no, el hilo principal reserva todos los buffers y los hilos no se fijan.
+// Devuelve los resultados por nodo (bytes sumados y el tiempo del hilo más lento).
+static std::map<int, WorkerResult> runNodes(const std::vector<NumaNode> &nodes, size_t threadsPerNode,
+                                            size_t bufferSize, int rounds, bool local) {
+    KeyMaterial material = randomKey();
+    std::vector<std::pair<int, const NumaNode *> > workers;
+    for (const NumaNode &node: nodes) {
+        size_t count = threadsPerNode ? threadsPerNode : node.cpus.size();
+        for (size_t i = 0; i < count; ++i) workers.emplace_back(node.id, &node);
+    }
+
+    // Buffers del hilo principal para el caso sin NUMA
+    std::vector<std::unique_ptr<unsigned char[]> > shared;
+    if (!local) {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            shared.emplace_back(new unsigned char[bufferSize]);
+            std::memset(shared.back().get(), 0, bufferSize);
+        }
+    }
+
+    std::vector<WorkerResult> results(workers.size());
+    std::atomic<size_t> ready{0};
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers.size(); ++w) {
+        threads.emplace_back([&, w] {
+            unsigned char *buffer;
+            if (local) {
+                pinCurrentThread(workers[w].second->cpus);
+                buffer = workerBuffer(bufferSize);
+            } else {
+                buffer = shared[w].get();
+            }
+            // Todos los hilos empiezan a la vez
+            ++ready;
+            while (ready < workers.size()) std::this_thread::yield();
+            results[w] = runWorker(buffer, bufferSize, rounds, material);
+        });
+    }
+    for (std::thread &thread: threads) thread.join();
+
+    std::map<int, WorkerResult> perNode;
+    for (size_t w = 0; w < workers.size(); ++w) {
+        WorkerResult &node = perNode[workers[w].first];
+        node.bytes += results[w].bytes;
+        node.seconds = std::max(node.seconds, results[w].seconds);
+    }
+    return perNode;
+}
+
+// Función para calcular el rendimiento total en GB/s
+static double totalThroughput(const std::map<int, WorkerResult> &perNode) {
+    uint64_t bytes = 0;
+    double seconds = 0;
+    for (const auto &node: perNode) {
+        bytes += node.second.bytes;
+        seconds = std::max(seconds, node.second.seconds);
+    }
+    return seconds > 0 ? bytes / seconds / 1e9 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Opciones: --buffer=64M por hilo, --rounds=8 pasadas, --threads=N hilos por nodo (por defecto uno por CPU)
+    // y --chunk=16K, el bloque de la comparación del pipeline; --file=256M es el tamaño del archivo de la
+    // comparación de OpenSSL con el kernel
+    std::map<std::string, std::string> options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos) {
+            std::cerr << "Uso: " << argv[0] << " [--buffer=64M] [--rounds=8] [--threads=N] [--chunk=16K]"
+                    << " [--file=256M]" << std::endl;
+            return 1;
+        }
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    size_t bufferSize = options.count("buffer") ? parseSize(options["buffer"]) : 64ULL << 20;
+    int rounds = options.count("rounds") ? std::atoi(options["rounds"].c_str()) : 8;
+    size_t threadsPerNode = options.count("threads") ? std::strtoull(options["threads"].c_str(), nullptr, 10) : 0;
+    size_t chunkSize = options.count("chunk") ? parseSize(options["chunk"]) : 16 << 10;
+    uint64_t fileSize = options.count("file") ? parseSize(options["file"]) : 256ULL << 20;
+    if (bufferSize == 0 || rounds <= 0 || chunkSize == 0 || chunkSize > (1ULL << 30) || fileSize == 0) {
+        std::cerr << "❌ [ERROR] --buffer, --rounds, --chunk y --file deben ser mayores que cero (--chunk hasta 1G)"
+                << std::endl;
+        return 1;
+    }
+
+    const std::vector<NumaNode> &nodes = numaNodes();
+    std::cout << "nodos NUMA: " << nodes.size() << std::endl;
+    for (const NumaNode &node: nodes) {
+        std::cout << "  nodo " << node.id << ": " << node.cpus.size() << " CPU" << std::endl;
+    }
+    std::cout << "buffer por hilo: " << formatBytes(bufferSize) << ", pasadas: " << rounds << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    // Hilos fijados y buffers locales a cada nodo
+    std::map<int, WorkerResult> local = runNodes(nodes, threadsPerNode, bufferSize, rounds, true);
+    std::cout << "\n--- NUMA (hilos fijados, buffers locales) ---" << std::endl;
+    for (const auto &node: local) {
+        std::cout << "nodo " << node.first << ": " << node.second.bytes / node.second.seconds / 1e9 << " GB/s"
+                << std::endl;
+    }
+    double localTotal = totalThroughput(local);
+    std::cout << "total: " << localTotal << " GB/s" << std::endl;
+
+    // Mismos hilos sin fijar y con los buffers reservados por el hilo principal
+    double scatteredTotal = totalThroughput(runNodes(nodes, threadsPerNode, bufferSize, rounds, false));
+    std::cout << "\n--- Sin NUMA (hilos libres, buffers del hilo principal) ---" << std::endl;
+    std::cout << "total: " << scatteredTotal << " GB/s" << std::endl;
+    std::cout << "mejora NUMA: " << localTotal / scatteredTotal << "x" << std::endl;
+
+    // Escalabilidad: todos los nodos frente a uno solo
+    if (nodes.size() > 1) {
+        double singleNode = totalThroughput(runNodes({nodes[0]}, threadsPerNode, bufferSize, rounds, true));
+        std::cout << "\n--- Escalabilidad ---" << std::endl;
+        std::cout << "un nodo: " << singleNode << " GB/s" << std::endl;
+        std::cout << nodes.size() << " nodos: " << localTotal << " GB/s (" << localTotal / singleNode << "x, ideal "
+                << nodes.size() << "x)" << std::endl;
+    }
+
+    // Pipeline: el mismo cifrado por bloques con la dirección en tiempo de ejecución y por políticas
+    {
+        KeyMaterial material = randomKey();
+        std::vector<unsigned char> buffer(bufferSize);
+        double runtime = chunkThroughput(buffer.data(), bufferSize, chunkSize, rounds,
+                                         [&](unsigned char *data, size_t len) {
+                                             runtimeAesCrypt(data, static_cast<int>(len), material.key,
+                                                             material.iv, data, true);
+                                         });
+        double policy = chunkThroughput(buffer.data(), bufferSize, chunkSize, rounds,
+                                        [&](unsigned char *data, size_t len) {
+                                            if (!aesCrypt<Encrypt>(data, len, material.key, material.iv, data))
+                                                handleErrors();
+                                        });
+        std::cout << "\n--- Pipeline (un hilo, bloques de " << formatBytes(chunkSize) << ") ---" << std::endl;
+        std::cout << "dirección en tiempo de ejecución: " << runtime << " GB/s" << std::endl;
+        std::cout << "políticas: " << policy << " GB/s" << std::endl;
+        std::cout << "mejora: " << policy / runtime << "x" << std::endl;
+    }
+
+    // Archivo a archivo: OpenSSL en el proceso frente a AF_ALG con splice, con un hilo y con todos
+    {
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        std::string input = (directory / "enigmacore_bench.bin").string();
+        std::string output = (directory / "enigmacore_bench.enc").string();
+        {
+            // Datos aleatorios: el keystream de una clave cualquiera sobre ceros
+            KeyMaterial material = randomKey();
+            std::vector<unsigned char> block(4 << 20);
+            std::ofstream file(input, std::ios::binary | std::ios::trunc);
+            for (uint64_t offset = 0; offset < fileSize && file; offset += block.size()) {
+                size_t len = static_cast<size_t>(std::min<uint64_t>(block.size(), fileSize - offset));
+                std::fill(block.begin(), block.end(), 0);
+                if (!aesCtrAt(block.data(), len, material.key, material.iv, offset, block.data())) handleErrors();
+                file.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(len));
+            }
+        }
+        setVerbose(false);
+        TuningProfile original = tuningProfile();
+        bool kernel = kernelCryptoAvailable();
+        std::cout << "\n--- Archivo a archivo (" << formatBytes(fileSize) << ", en caché) ---" << std::endl;
+        if (!kernel) std::cout << "cifrado en el kernel no disponible (AF_ALG o ctr(aes)): solo OpenSSL" << std::endl;
+        std::vector<size_t> threadCounts = {1};
+        if (workerCount(0) > 1) threadCounts.push_back(workerCount(0));
+        for (size_t threads: threadCounts) {
+            std::cout << threads << (threads == 1 ? " hilo" : " hilos") << ":" << std::endl;
+            // Una pasada previa deja la entrada en la caché de páginas
+            runFileEncrypt(input, output, "openssl", threads);
+            printFileRun("  OpenSSL", runFileEncrypt(input, output, "openssl", threads), fileSize);
+            if (kernel) printFileRun("  kernel ", runFileEncrypt(input, output, "kernel", threads), fileSize);
+        }
+        setTuningProfile(original);
+        std::error_code ec;
+        std::filesystem::remove(input, ec);
+        std::filesystem::remove(output, ec);
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#ifndef ENIGMACORE_ASYNC_H
+#define ENIGMACORE_ASYNC_H
+
+// API asíncrona de libenigmacore: los trabajos se encolan en un ejecutor con un número fijo de hilos y
+// quien llama recibe un Job con el que puede esperar el resultado, consultar el progreso o cancelarlo.
+// Cada trabajo se ejecuta entero en un hilo del ejecutor, también los archivos grandes que encrypt() procesaría
+// por segmentos en paralelo: el ejecutor fija cuántos hilos trabajan.
+// Si quien incluye la cabecera compila con C++20 (corrutinas), un Job también se puede esperar con co_await; la
+// corrutina se reanuda en el hilo del ejecutor que terminó el trabajo. La biblioteca se compila con C++17 y
+// esta parte solo está en la cabecera.
+
+#include "enigmacore/enigmacore.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define ENIGMACORE_HAVE_COROUTINES 1
+#endif
+#endif
+
+namespace enigmacore {
+
+// Conjunto fijo de hilos que ejecuta las tareas en orden de llegada
+class Executor {
+public:
+    // Con 'threads' = 0 se usa un hilo por núcleo
+    explicit Executor(size_t threads = 0);
+
+    // Espera a que terminen las tareas encoladas y detiene los hilos
+    ~Executor();
+
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    // Encola una tarea
+    void post(std::function<void()> task);
+
+    size_t threadCount() const { return threads_.size(); }
+
+private:
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()> > queue_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+};
+
+// Estado de un trabajo
+enum class JobStatus {
+    Pending,
+    Running,
+    Succeeded,
+    Failed,
+    Cancelled
+};
+
+struct JobState;
+
+// Referencia compartida a un trabajo encolado; copiarla no duplica el trabajo. Un Job construido por defecto no
+// tiene trabajo y se comporta como uno que ya falló.
+class Job {
+public:
+    Job() = default;
+
+    // false si el Job no tiene trabajo asociado
+    bool valid() const { return state_ != nullptr; }
+
+    // Pide cancelar el trabajo: si aún no empezó no se ejecuta, y si está en curso se detiene
+    // en el siguiente aviso de progreso
+    void cancel();
+
+    JobStatus status() const;
+
+    // Bytes procesados y total conocido hasta ahora
+    uint64_t processedBytes() const;
+    uint64_t totalBytes() const;
+
+    // Progreso entre 0 y 1
+    double progress() const;
+
+    // Resultado del trabajo (true si terminó con éxito); get() bloquea hasta que termine
+    std::shared_future<bool> future() const;
+
+    // Bloquea hasta que el trabajo termine y devuelve su resultado
+    bool wait() const;
+
+    // Registra 'callback' para cuando el trabajo termine. Devuelve false, sin registrarlo,
+    // si el trabajo ya había terminado.
+    bool continueWith(std::function<void()> callback) const;
+
+#ifdef ENIGMACORE_HAVE_COROUTINES
+    // Permite 'bool ok = co_await job;'
+    struct Awaiter;
+    Awaiter operator co_await() const;
+#endif
+
+private:
+    friend Job submit(Executor &executor, std::function<bool(const ProgressCallback &progress)> task);
+
+    explicit Job(std::shared_ptr<JobState> state) : state_(std::move(state)) {
+    }
+
+    std::shared_ptr<JobState> state_;
+};
+
+#ifdef ENIGMACORE_HAVE_COROUTINES
+struct Job::Awaiter {
+    Job job;
+
+    bool await_ready() const {
+        JobStatus current = job.status();
+        return current != JobStatus::Pending && current != JobStatus::Running;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) const {
+        return job.continueWith([handle] { handle.resume(); });
+    }
+
+    bool await_resume() const { return job.wait(); }
+};
+
+inline Job::Awaiter Job::operator co_await() const {
+    return Awaiter{*this};
+}
+#endif
+
+// Encola una tarea genérica. La tarea recibe la función de progreso que debe llamar periódicamente;
+// si esa función devuelve false el trabajo fue cancelado y la tarea debe terminar. Una excepción que salga de
+// la tarea se muestra y el trabajo falla.
+Job submit(Executor &executor, std::function<bool(const ProgressCallback &progress)> task);
+
+// Versiones asíncronas de encrypt() y decrypt() con progreso y cancelación
+Job encryptAsync(Executor &executor, const std::string &input_path, const std::string &output_path);
+Job decryptAsync(Executor &executor, const std::string &input_path, const std::string &output_path);
+
+} // namespace enigmacore
+
+#endif // ENIGMACORE_ASYNC_H
@@ -0,0 +1,284 @@
+#ifndef ENIGMACORE_ENIGMACORE_H
+#define ENIGMACORE_ENIGMACORE_H
+
+// API de C++ de libenigmacore: cifrado AES-256-CTR de buffers, flujos incrementales y archivos.
+// Las funciones de buffer y de flujo no copian los datos: trabajan sobre las vistas que entrega
+// quien llama y admiten que la entrada y la salida sean el mismo buffer.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+namespace enigmacore {
+
+// Vista de solo lectura sobre bytes contiguos (equivalente a std::span<const unsigned char>)
+struct ByteSpan {
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+
+    ByteSpan() = default;
+
+    ByteSpan(const unsigned char *data, size_t size) : data(data), size(size) {
+    }
+
+    ByteSpan(const std::vector<unsigned char> &bytes) : data(bytes.data()), size(bytes.size()) {
+    }
+
+    const unsigned char *begin() const { return data; }
+    const unsigned char *end() const { return data + size; }
+};
+
+// Vista modificable sobre bytes contiguos (equivalente a std::span<unsigned char>)
+struct MutableByteSpan {
+    unsigned char *data = nullptr;
+    size_t size = 0;
+
+    MutableByteSpan() = default;
+
+    MutableByteSpan(unsigned char *data, size_t size) : data(data), size(size) {
+    }
+
+    MutableByteSpan(std::vector<unsigned char> &bytes) : data(bytes.data()), size(bytes.size()) {
+    }
+
+    operator ByteSpan() const { return {data, size}; }
+    unsigned char *begin() const { return data; }
+    unsigned char *end() const { return data + size; }
+};
+
+// Clave AES-256 y vector de inicialización de un archivo o mensaje
+struct KeyMaterial {
+    unsigned char key[32];
+    unsigned char iv[16];
+};
+
+// ------------------------------------------------------------------------
+// Cifrado de buffers
+// ------------------------------------------------------------------------
+
+// Las funciones de cifrado de buffers devuelven false si falla OpenSSL o el generador aleatorio; no terminan el
+// proceso.
+
+// Función para generar una clave y un IV aleatorios
+bool generateKey(KeyMaterial &material);
+
+// Función para cifrar y descifrar datos usando AES-CTR; el keystream empieza en 'iv' en cada llamada
+bool aesCrypt(const unsigned char *input, int input_len, unsigned char *key, unsigned char *iv,
+              unsigned char *output, bool encrypt);
+
+// Función para cifrar/descifrar con AES-CTR a partir de una posición arbitraria del flujo
+bool aesCtrAt(const unsigned char *input, size_t input_len, const unsigned char *key, const unsigned char *iv,
+              uint64_t offset, unsigned char *output);
+
+// Cifrado de un buffer completo en una sola llamada. 'output' debe tener al menos el tamaño de
+// 'input' y puede ser el mismo buffer. 'offset' es la posición del buffer dentro del flujo.
+// Devuelve false si 'output' es demasiado pequeño o si falla el cifrado.
+bool encryptBuffer(const KeyMaterial &material, ByteSpan input, MutableByteSpan output, uint64_t offset = 0);
+
+// Descifrado de un buffer completo (en CTR es la misma operación que el cifrado)
+bool decryptBuffer(const KeyMaterial &material, ByteSpan input, MutableByteSpan output, uint64_t offset = 0);
+
+// Flujo incremental de AES-256-CTR: cada llamada a update() continúa el keystream donde lo
+// dejó la anterior, así que los datos pueden llegar en trozos de cualquier tamaño.
+class CtrStream {
+public:
+    explicit CtrStream(const KeyMaterial &material, uint64_t offset = 0);
+    ~CtrStream();
+
+    CtrStream(const CtrStream &) = delete;
+    CtrStream &operator=(const CtrStream &) = delete;
+    CtrStream(CtrStream &&other) noexcept;
+    CtrStream &operator=(CtrStream &&other) noexcept;
+
+    // false si no se pudo preparar el contexto de OpenSSL; update() falla en ese caso
+    bool ready() const { return ctx_ != nullptr; }
+
+    // Procesa 'input' y escribe el resultado en 'output' (del mismo tamaño o mayor)
+    bool update(ByteSpan input, MutableByteSpan output);
+
+    // Posición actual dentro del flujo
+    uint64_t position() const { return position_; }
+
+private:
+    EVP_CIPHER_CTX *ctx_ = nullptr;
+    uint64_t position_ = 0;
+};
+
+// ------------------------------------------------------------------------
+// Archivos
+// ------------------------------------------------------------------------
+// Todas las funciones muestran los errores por stderr y devuelven false si la operación falla.
+
+// Función que recibe los bytes procesados y el total; si devuelve false la operación se cancela
+using ProgressCallback = std::function<bool(uint64_t processed, uint64_t total)>;
+
+// Formato básico: clave (32) | IV (16) | texto cifrado. Si se cancela desde 'progress' se borra la salida parcial.
+bool encrypt(const std::string &input_path, const std::string &output_path,
+             const ProgressCallback &progress = nullptr);
+bool decrypt(const std::string &input_path, const std::string &output_path,
+             const ProgressCallback &progress = nullptr);
+
+// Formato RSA: clave e IV cifrados con la llave pública RSA (OAEP) | texto cifrado
+bool encryptAESKeyAndIV(const std::string &public_key_path, unsigned char *aes_key, unsigned char *iv,
+                        std::ofstream &outputFile);
+bool decryptAESKeyAndIV(const std::string &private_key_path, unsigned char *aes_key, unsigned char *iv,
+                        std::ifstream &inputFile);
+// Comprueba, descifrando en memoria, que 'encrypted_path' corresponde a 'original_path'. Con
+// 'private_key_path' vacío se espera el formato básico y si no el formato RSA.
+bool verify(const std::string &encrypted_path, const std::string &original_path,
+            const std::string &private_key_path = "");
+
+bool encryptRSA(const std::string &input_path, const std::string &output_path,
+                const std::string &public_key_path);
+bool decryptRSA(const std::string &input_path, const std::string &output_path,
+                const std::string &private_key_path);
+
+// Almacén de claves (keystore.h): el cifrado incremental y la salida fragmentada guardan en su manifiesto la
+// clave envuelta con una de sus llaves
+class Keystore;
+
+// Cifrado incremental con fragmentación definida por contenido (directorio con manifiesto). La clave del archivo
+// se envuelve con la llave 'key_id' del almacén; al repetir el cifrado se recupera con el mismo almacén. Si el
+// descifrado falla se borra la salida.
+bool encryptIncremental(const std::string &input_path, const std::string &output_dir, const Keystore &keystore,
+                        const std::string &key_id);
+bool decryptIncremental(const std::string &input_dir, const std::string &output_path, const Keystore &keystore);
+
+// Archivos dispersos: los huecos y bloques a cero no se cifran
+bool encryptSparse(const std::string &input_path, const std::string &output_path);
+bool decryptSparse(const std::string &input_path, const std::string &output_path);
+
+// Cifrado selectivo de imágenes JPEG y TIFF/TIFF-EP
+bool encryptSelective(const std::string &input_path, const std::string &output_path);
+bool decryptSelective(const std::string &input_path, const std::string &output_path);
+bool benchmarkSelective(const std::string &input_path, const std::string &output_path);
+
+// Cifrado de imágenes por teselas descifrables por separado
+bool encryptTiles(const std::string &input_path, const std::string &output_path);
+bool decryptTile(const std::string &input_path, uint64_t tx, uint64_t ty, const std::string &output_path);
+bool decryptTiles(const std::string &input_path, const std::string &output_path);
+
+// Salida fragmentada en varios archivos escritos y leídos en paralelo. La clave y el IV se envuelven con la
+// llave 'key_id' del almacén. 'shard_size' debe ser mayor que cero; si el cifrado falla se borran los fragmentos.
+const uint64_t kDefaultShardSize = 256ULL << 20; // 256 MB por fragmento
+bool encryptSharded(const std::string &input_path, const std::string &output_dir, uint64_t shard_size,
+                    const Keystore &keystore, const std::string &key_id);
+bool decryptSharded(const std::string &input_dir, const std::string &output_path, const Keystore &keystore);
+
+// Ejecución por lotes: cada línea del manifiesto JSONL es un trabajo, por ejemplo
+//   {"id": "a1", "op": "encrypt", "input": "in.bin", "output": "out.enc", "key_id": "cliente1"}
+// Las operaciones son "encrypt", "decrypt" y "verify" (con "original" en lugar de "output"). Con "key_id"
+// se usa el formato RSA con las llaves '<keys_dir>/<key_id>.pub.pem' y '<keys_dir>/<key_id>.pem', o, si
+// se indica 'keystore', el formato con llave de ese almacén (ver keystore.h).
+// Por cada trabajo se escribe una línea JSON en 'results_path' ("-" para la salida estándar).
+struct BatchOptions {
+    std::string keys_dir = ".";
+    std::string keystore; // almacén de claves en el que buscar "key_id" (vacío = llaves PEM de keys_dir)
+    size_t threads = 0; // 0 = un hilo por núcleo
+    uint64_t large_file_size = 64ULL << 20; // a partir de este tamaño el trabajo va a la cola de archivos grandes
+};
+
+// Devuelve false si no se pudo leer el manifiesto, si algún trabajo falló o si no se pudieron escribir los
+// resultados (en ese caso no se lanzan más trabajos)
+bool runJobs(const std::string &manifest_path, const std::string &results_path, const BatchOptions &options);
+
+// Restauración en bloque: descifra todos los archivos de 'input_dir' (recorrido recursivo) en 'output_dir' con la
+// misma ruta relativa y sin 'suffix'. Las claves se recuperan en paralelo con la llave privada RSA
+// ('private_key', formato RSA) o con el almacén ('keystore', formato con llave), y sin ninguna de las dos se
+// espera el formato básico. Devuelve false si algún archivo falló.
+struct RestoreOptions {
+    std::string private_key;
+    std::string keystore;
+    std::string suffix = ".enc";
+    size_t threads = 0; // hilos de desenvoltura de claves (0 = los del perfil o uno por CPU)
+};
+
+bool restoreFiles(const std::string &input_dir, const std::string &output_dir, const RestoreOptions &options);
+
+// Carpeta vigilada: cada archivo que termina de escribirse en 'input_dir' (o se mueve a ella) se cifra en
+// '<output_dir>/<nombre>.enc'. Los archivos ocultos se ignoran porque suelen ser copias en curso.
+struct WatchOptions {
+    enum AfterSuccess { KeepOriginals, DeleteOriginals, MoveOriginals };
+
+    size_t threads = 0; // 0 = un hilo por núcleo
+    unsigned debounce_ms = 500; // tiempo sin eventos antes de dar un archivo por terminado
+    AfterSuccess after = KeepOriginals; // qué hacer con el original tras cifrarlo y verificarlo
+    std::string move_dir; // destino de los originales con MoveOriginals
+    const std::atomic<bool> *stop = nullptr; // la vigilancia termina cuando pasa a true
+};
+
+// Vigila la carpeta hasta que 'options.stop' pase a true; devuelve false si no se pudo vigilar
+bool watchFolder(const std::string &input_dir, const std::string &output_dir, const WatchOptions &options);
+
+// Perfil de rendimiento: tamaño de los bloques de E/S, número de hilos y forma de leer/escribir los
+// archivos. Lo calcula 'autotune' para cada equipo y se guarda en un archivo de configuración.
+struct TuningProfile {
+    size_t chunk_size = 1 << 20; // bytes por lectura/escritura y tamaño de los segmentos en paralelo
+    size_t threads = 0; // 0 = un hilo por CPU
+    std::string io = "auto"; // "stream" (secuencial), "pread", "mmap" o "auto" (paralelo desde 64 MB)
+    uint64_t max_memory = 0; // límite de memoria para buffers, bloques en vuelo e hilos (0 = sin límite)
+    std::string cipher = "openssl"; // "openssl" o "kernel" (AF_ALG con splice; si no está disponible, OpenSSL)
+};
+
+// Límite de memoria más pequeño que se acepta
+const uint64_t kMinMaxMemory = 4ULL << 20;
+
+// Tamaño de bloque más grande que se acepta (chunk_size)
+const uint64_t kMaxChunkSize = 1ULL << 30;
+
+// Funciones para fijar y consultar el perfil que usan encrypt/decrypt y los modos en paralelo
+void setTuningProfile(const TuningProfile &profile);
+TuningProfile tuningProfile();
+
+// Ruta por defecto del perfil: $ENIGMACORE_CONFIG o ~/.config/enigmacore/tuning.conf
+std::string defaultTuningPath();
+
+// Funciones para leer y guardar el perfil (formato 'clave=valor'); loadTuningProfile devuelve false sin
+// mensaje si el archivo no existe, y con mensaje si no es válido
+bool loadTuningProfile(const std::string &path, TuningProfile &profile);
+bool saveTuningProfile(const std::string &path, const TuningProfile &profile);
+
+// Calibra tamaños de bloque, hilos y modos de E/S con un archivo de prueba de 'sample_size' bytes en
+// 'directory' (el sistema de archivos de destino) y guarda el perfil ganador en 'config_path'. Cada candidato
+// se mide con su perfil sin cambiar el activo; las mediciones se muestran según setVerbose().
+bool autotune(const std::string &directory, const std::string &config_path, uint64_t sample_size);
+
+// ------------------------------------------------------------------------
+// Utilidades
+// ------------------------------------------------------------------------
+
+// Función para activar o desactivar los mensajes informativos por la salida estándar (los errores se
+// muestran siempre)
+void setVerbose(bool verbose);
+
+// Función para formatear el tamaño en bytes a una representación legible
+std::string formatBytes(size_t bytes);
+
+// Función para formatear una duración en segundos
+std::string formatDuration(double seconds);
+
+// Función para mostrar la barra de progreso
+void showProgress(size_t current, size_t total, size_t updateInterval = 1024);
+
+// Función para imprimir los resultados del proceso
+void printFormattedResults(size_t originalSize, size_t processedSize, double duration);
+
+// Función para obtener el pico de memoria residente (RSS) del proceso en bytes
+uint64_t peakRss();
+
+// Función para obtener el tamaño de una ruta: el tamaño del archivo o la suma de los archivos de un directorio
+size_t pathSize(const std::string &path);
+
+// Función para interpretar un tamaño con sufijo opcional K, M o G (por ejemplo "64M"). Devuelve 0 si el texto
+// no es un tamaño válido o no cabe en 64 bits.
+uint64_t parseSize(const std::string &text);
+
+} // namespace enigmacore
+
+#endif // ENIGMACORE_ENIGMACORE_H
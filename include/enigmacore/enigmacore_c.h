@@ -0,0 +1,53 @@
+#ifndef ENIGMACORE_ENIGMACORE_C_H
+#define ENIGMACORE_ENIGMACORE_C_H
+
+/*
+ * ABI de C de libenigmacore para extensiones y otros lenguajes (por ejemplo la extensión de PHP).
+ * Los buffers pertenecen a quien llama: la biblioteca no copia ni reserva memoria para los datos,
+ * y 'in' y 'out' pueden apuntar al mismo buffer. Todas las funciones devuelven 0 si la operación
+ * tiene éxito y -1 si falla; ninguna termina el proceso.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ENIGMACORE_KEY_SIZE 32
+#define ENIGMACORE_IV_SIZE 16
+
+/* Flujo incremental de AES-256-CTR (opaco) */
+typedef struct enigmacore_stream enigmacore_stream;
+
+/* Genera una clave y un IV aleatorios */
+int enigmacore_generate_key(unsigned char key[ENIGMACORE_KEY_SIZE], unsigned char iv[ENIGMACORE_IV_SIZE]);
+
+/* Cifra/descifra 'len' bytes situados en la posición 'offset' del flujo (en CTR es la misma operación) */
+int enigmacore_crypt_buffer(const unsigned char key[ENIGMACORE_KEY_SIZE], const unsigned char iv[ENIGMACORE_IV_SIZE],
+                            uint64_t offset, const unsigned char *in, unsigned char *out, size_t len);
+
+/* Crea un flujo situado en 'offset'; devuelve NULL si falla */
+enigmacore_stream *enigmacore_stream_new(const unsigned char key[ENIGMACORE_KEY_SIZE],
+                                         const unsigned char iv[ENIGMACORE_IV_SIZE], uint64_t offset);
+
+/* Procesa el siguiente tramo del flujo */
+int enigmacore_stream_update(enigmacore_stream *stream, const unsigned char *in, unsigned char *out, size_t len);
+
+/* Libera el flujo (admite NULL) */
+void enigmacore_stream_free(enigmacore_stream *stream);
+
+/* Cifra/descifra un archivo con el formato básico: clave (32) | IV (16) | texto cifrado */
+int enigmacore_encrypt_file(const char *input_path, const char *output_path);
+int enigmacore_decrypt_file(const char *input_path, const char *output_path);
+
+/* Activa (distinto de 0) o desactiva los mensajes informativos por la salida estándar; los errores siempre se
+ * muestran por stderr */
+void enigmacore_set_verbose(int verbose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ENIGMACORE_ENIGMACORE_C_H */
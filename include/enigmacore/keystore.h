@@ -0,0 +1,104 @@
+#ifndef ENIGMACORE_KEYSTORE_H
+#define ENIGMACORE_KEYSTORE_H
+
+// Almacén de claves de libenigmacore: miles de pares de llaves RSA o EC en un único archivo indexado. El
+// archivo se proyecta en memoria con mmap y cada llave se busca por su identificador en una tabla hash,
+// sin abrir ni interpretar archivos PEM en cada operación.
+
+#include "enigmacore/enigmacore.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef struct evp_pkey_st EVP_PKEY;
+
+namespace enigmacore {
+
+// Tipo de par de llaves
+enum class KeyType : uint8_t {
+    RSA = 1,
+    EC = 2
+};
+
+// Opciones de generación de llaves. Los identificadores son '<prefix><n>', con n de 0 a count - 1.
+struct KeygenOptions {
+    KeyType type = KeyType::RSA;
+    int rsa_bits = 2048;
+    std::string curve = "P-256"; // curva de las llaves EC
+    std::string prefix = "key-";
+    size_t threads = 0; // 0 = un hilo por núcleo
+};
+
+// Genera 'count' pares de llaves en paralelo y los guarda en el almacén 'path' (con permisos 0600: las
+// llaves privadas no van cifradas)
+bool generateKeystore(const std::string &path, size_t count, const KeygenOptions &options);
+
+// Llave de un almacén: las vistas apuntan a la proyección del archivo y valen mientras siga abierto
+struct KeystoreEntry {
+    KeyType type;
+    ByteSpan public_der; // SubjectPublicKeyInfo en DER
+    ByteSpan private_der; // llave privada en DER
+};
+
+// Almacén abierto en solo lectura; las búsquedas se pueden hacer desde varios hilos a la vez
+class Keystore {
+public:
+    Keystore();
+    ~Keystore();
+
+    Keystore(const Keystore &) = delete;
+    Keystore &operator=(const Keystore &) = delete;
+
+    // Proyecta el almacén y comprueba su cabecera; muestra el error y devuelve false si no es válido
+    bool open(const std::string &path);
+
+    // Busca una llave por su identificador
+    bool find(const std::string &key_id, KeystoreEntry &entry) const;
+
+    // Número de llaves del almacén
+    uint64_t size() const { return count_; }
+
+private:
+    // Llaves ya interpretadas, por identificador
+    struct KeyCache;
+    friend EVP_PKEY *cachedKey(const Keystore &keystore, const std::string &key_id, const KeystoreEntry &entry);
+
+    const unsigned char *data_ = nullptr;
+    size_t mappedSize_ = 0;
+    uint64_t count_ = 0;
+    uint64_t slots_ = 0;
+    std::unique_ptr<KeyCache> keys_;
+};
+
+// Formato con llave del almacén: la cabecera guarda el identificador de la llave y la clave AES y el IV
+// envueltos con ella (RSA-OAEP o ECIES), de modo que para descifrar basta con el almacén. Los datos van en
+// fragmentos cifrados y autenticados con AES-256-GCM, seguidos del resumen SHA-256 del contenido original
+// también cifrado. decryptKeyed borra la salida si algún fragmento no se autentica. Cada llave se interpreta
+// una sola vez, la primera vez que se usa, y el almacén la conserva mientras siga abierto.
+bool encryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore,
+                  const std::string &key_id);
+bool decryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore);
+
+// Función para comprobar un archivo con llave del almacén frente a su original, sin escribir nada
+bool verifyKeyed(const std::string &encrypted_path, const std::string &original_path, const Keystore &keystore);
+
+// Función para comprobar en memoria, sin el original y sin escribir nada, que un archivo con llave está
+// íntegro: cabecera, envoltura de la clave y autenticación de cada fragmento. Con 'check_digest' también se
+// compara el resumen del contenido descifrado con el guardado en el archivo.
+bool verifyIntegrity(const std::string &encrypted_path, const Keystore &keystore, bool check_digest = false);
+
+// Auditoría de muchos archivos (los directorios se recorren de forma recursiva) con verifyIntegrity,
+// en paralelo entre archivos y entre los fragmentos de cada archivo
+struct AuditOptions {
+    bool check_digest = false;
+    size_t threads = 0; // 0 = los del perfil o uno por CPU
+};
+
+// Devuelve false si algún archivo no se pudo comprobar o no está íntegro
+bool auditFiles(const std::vector<std::string> &paths, const Keystore &keystore, const AuditOptions &options);
+
+} // namespace enigmacore
+
+#endif // ENIGMACORE_KEYSTORE_H
@@ -0,0 +1,168 @@
+#include "enigmacore/async.h"
+#include "internal.h"
+
+namespace enigmacore {
+
+// Estado compartido entre el Job que tiene quien llama y la tarea encolada en el ejecutor
+struct JobState {
+    std::mutex mutex;
+    JobStatus status = JobStatus::Pending;
+    std::atomic<bool> cancelRequested{false};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> total{0};
+    std::promise<bool> promise;
+    std::shared_future<bool> result = promise.get_future().share();
+    std::vector<std::function<void()> > continuations;
+
+    // Función para fijar el estado final, publicar el resultado y lanzar las continuaciones
+    void finish(JobStatus finalStatus) {
+        std::vector<std::function<void()> > pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            status = finalStatus;
+            promise.set_value(finalStatus == JobStatus::Succeeded);
+            pending.swap(continuations);
+        }
+        for (std::function<void()> &callback: pending) callback();
+    }
+};
+
+Executor::Executor(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; ++i) threads_.emplace_back([this] { run(); });
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (std::thread &thread: threads_) thread.join();
+}
+
+void Executor::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(task));
+    }
+    ready_.notify_one();
+}
+
+// Bucle de cada hilo: toma tareas hasta que se detiene el ejecutor y la cola queda vacía
+void Executor::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        // Una excepción que saliera del hilo terminaría el proceso: se muestra y el hilo sigue con la cola
+        try {
+            task();
+        } catch (const std::exception &e) {
+            std::cerr << "❌ [ERROR] " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "❌ [ERROR] Error desconocido en una tarea del ejecutor" << std::endl;
+        }
+    }
+}
+
+void Job::cancel() {
+    if (state_) state_->cancelRequested = true;
+}
+
+JobStatus Job::status() const {
+    if (!state_) return JobStatus::Failed;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->status;
+}
+
+uint64_t Job::processedBytes() const {
+    return state_ ? state_->processed.load() : 0;
+}
+
+uint64_t Job::totalBytes() const {
+    return state_ ? state_->total.load() : 0;
+}
+
+double Job::progress() const {
+    if (!state_) return 0.0;
+    uint64_t total = state_->total;
+    if (status() == JobStatus::Succeeded) return 1.0;
+    return total ? static_cast<double>(state_->processed) / total : 0.0;
+}
+
+std::shared_future<bool> Job::future() const {
+    if (state_) return state_->result;
+    // Sin trabajo, un resultado ya disponible (false)
+    std::promise<bool> failed;
+    failed.set_value(false);
+    return failed.get_future().share();
+}
+
+bool Job::wait() const {
+    return state_ && state_->result.get();
+}
+
+bool Job::continueWith(std::function<void()> callback) const {
+    if (!state_) return false;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->status != JobStatus::Pending && state_->status != JobStatus::Running) return false;
+    state_->continuations.push_back(std::move(callback));
+    return true;
+}
+
+Job submit(Executor &executor, std::function<bool(const ProgressCallback &progress)> task) {
+    std::shared_ptr<JobState> state = std::make_shared<JobState>();
+    executor.post([state, task = std::move(task)] {
+        // Un trabajo cancelado antes de empezar no se ejecuta
+        if (state->cancelRequested) {
+            state->finish(JobStatus::Cancelled);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->status = JobStatus::Running;
+        }
+
+        // La tarea publica su avance aquí y consulta si se pidió cancelar
+        ProgressCallback progress = [state](uint64_t processed, uint64_t total) {
+            state->processed = processed;
+            state->total = total;
+            return !state->cancelRequested;
+        };
+
+        // Las operaciones del trabajo se ejecutan en este hilo, sin lanzar hilos propios: el ejecutor decide
+        // cuántos trabajos avanzan a la vez
+        WorkerLimit limit(1);
+        bool ok = false;
+        try {
+            ok = task(progress);
+        } catch (const std::exception &e) {
+            std::cerr << "❌ [ERROR] " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "❌ [ERROR] Error desconocido en un trabajo" << std::endl;
+        }
+        state->finish(ok ? JobStatus::Succeeded
+                         : state->cancelRequested ? JobStatus::Cancelled : JobStatus::Failed);
+    });
+    return Job(state);
+}
+
+Job encryptAsync(Executor &executor, const std::string &input_path, const std::string &output_path) {
+    return submit(executor, [input_path, output_path](const ProgressCallback &progress) {
+        return encrypt(input_path, output_path, progress);
+    });
+}
+
+Job decryptAsync(Executor &executor, const std::string &input_path, const std::string &output_path) {
+    return submit(executor, [input_path, output_path](const ProgressCallback &progress) {
+        return decrypt(input_path, output_path, progress);
+    });
+}
+
+} // namespace enigmacore
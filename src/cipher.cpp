@@ -0,0 +1,178 @@
+#include "internal.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace enigmacore {
+
+// Función para manejar errores de OpenSSL en las herramientas de línea de comandos
+void handleErrors() {
+    ERR_print_errors_fp(stderr);
+    abort();
+}
+
+bool opensslFailed() {
+    ERR_print_errors_fp(stderr);
+    std::cerr << "❌ [ERROR] Falló una operación de OpenSSL" << std::endl;
+    return false;
+}
+
+// Contexto AES-256-CTR de un hilo. Solo se reutiliza la reserva del contexto: cada llamada prepara la clave y al
+// terminar se reinicia el contexto, lo que borra la clave expandida, así que no queda material de ninguna clave en
+// la memoria del hilo entre llamadas.
+struct ThreadCtrContext {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+
+    ~ThreadCtrContext() { EVP_CIPHER_CTX_free(ctx); }
+};
+
+// Reinicia el contexto del hilo al salir de aesCrypt, también cuando falla
+struct CtrContextReset {
+    EVP_CIPHER_CTX *ctx;
+
+    ~CtrContextReset() { EVP_CIPHER_CTX_reset(ctx); }
+};
+
+// Función para cifrar o descifrar datos usando AES-CTR, con la dirección fijada en tiempo de compilación.
+// Cada hilo reutiliza la reserva de su contexto entre llamadas, pero la clave se prepara en cada una.
+template <class Direction>
+bool aesCrypt(const unsigned char *input, size_t input_len, const unsigned char *key, const unsigned char *iv,
+              unsigned char *output) {
+    thread_local ThreadCtrContext context;
+    EVP_CIPHER_CTX *ctx = context.ctx;
+    if (!ctx) return opensslFailed();
+    CtrContextReset reset{ctx};
+    if (1 != EVP_CipherInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, iv, Direction::encrypting ? 1 : 0)) {
+        return opensslFailed();
+    }
+
+    // Procesar por tramos para no desbordar el 'int' de EVP
+    const size_t maxStep = 1 << 30;
+    int len;
+    for (size_t done = 0; done < input_len; done += maxStep) {
+        int step = static_cast<int>(std::min(maxStep, input_len - done));
+        if constexpr (Direction::encrypting) {
+            if (1 != EVP_EncryptUpdate(ctx, output + done, &len, input + done, step)) return opensslFailed();
+        } else {
+            if (1 != EVP_DecryptUpdate(ctx, output + done, &len, input + done, step)) return opensslFailed();
+        }
+    }
+    return true;
+}
+
+template bool aesCrypt<Encrypt>(const unsigned char *, size_t, const unsigned char *, const unsigned char *,
+                                unsigned char *);
+template bool aesCrypt<Decrypt>(const unsigned char *, size_t, const unsigned char *, const unsigned char *,
+                                unsigned char *);
+
+// Función para cifrar y descifrar datos usando AES-CTR
+// Esta función toma como entrada los datos que se desean cifrar/descifrar, una clave (key),
+// un vector de inicialización (iv), y genera la salida correspondiente en la variable 'output'.
+// El parámetro 'encrypt' define si la operación es de cifrado (true) o descifrado (false); se comprueba
+// una sola vez para elegir la instanciación.
+bool aesCrypt(const unsigned char *input, int input_len, unsigned char *key, unsigned char *iv, unsigned char *output,
+              bool encrypt) {
+    size_t len = input_len > 0 ? static_cast<size_t>(input_len) : 0;
+    return encrypt ? aesCrypt<Encrypt>(input, len, key, iv, output) : aesCrypt<Decrypt>(input, len, key, iv, output);
+}
+
+// Función para crear un contexto AES-256-CTR situado en la posición 'offset' del flujo; devuelve nullptr si falla
+static EVP_CIPHER_CTX *newCtrContext(const unsigned char *key, const unsigned char *iv, uint64_t offset) {
+    // Sumar el número de bloque al IV (entero de 128 bits big-endian)
+    unsigned char counter[16];
+    std::memcpy(counter, iv, sizeof(counter));
+    uint64_t carry = offset / 16;
+    for (int i = 15; i >= 0 && carry; --i) {
+        uint64_t sum = counter[i] + (carry & 0xff);
+        counter[i] = static_cast<unsigned char>(sum);
+        carry = (carry >> 8) + (sum >> 8);
+    }
+
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) return nullptr;
+    int len;
+    // En CTR cifrar y descifrar es la misma operación. Se descarta el inicio del bloque cuando la posición no
+    // está alineada.
+    unsigned char skip[16] = {0};
+    if (1 != EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, counter) ||
+        (offset % 16 && 1 != EVP_EncryptUpdate(ctx, skip, &len, skip, static_cast<int>(offset % 16)))) {
+        EVP_CIPHER_CTX_free(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+// Función para procesar 'input_len' bytes con un contexto CTR ya inicializado
+static bool ctrUpdate(EVP_CIPHER_CTX *ctx, const unsigned char *input, size_t input_len, unsigned char *output) {
+    // Procesar por tramos para no desbordar el 'int' de EVP
+    const size_t maxStep = 1 << 30;
+    int len;
+    for (size_t done = 0; done < input_len; done += maxStep) {
+        int step = static_cast<int>(std::min(maxStep, input_len - done));
+        if (1 != EVP_EncryptUpdate(ctx, output + done, &len, input + done, step)) return false;
+    }
+    return true;
+}
+
+// Función para cifrar/descifrar con AES-CTR a partir de una posición arbitraria del flujo.
+// El contador se adelanta 'offset / 16' bloques desde 'iv' y se descartan los 'offset % 16'
+// primeros bytes del keystream, de modo que cualquier tramo se puede procesar por separado.
+bool aesCtrAt(const unsigned char *input, size_t input_len, const unsigned char *key, const unsigned char *iv,
+              uint64_t offset, unsigned char *output) {
+    EVP_CIPHER_CTX *ctx = newCtrContext(key, iv, offset);
+    bool ok = ctx && ctrUpdate(ctx, input, input_len, output);
+    EVP_CIPHER_CTX_free(ctx);
+    return ok || opensslFailed();
+}
+
+bool randomBytes(unsigned char *data, size_t len) {
+    if (len > static_cast<size_t>(INT_MAX) || 1 != RAND_bytes(data, static_cast<int>(len))) {
+        std::cerr << "❌ [ERROR] No se pudo generar una clave aleatoria" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool generateKey(KeyMaterial &material) {
+    return randomBytes(material.key, sizeof(material.key)) && randomBytes(material.iv, sizeof(material.iv));
+}
+
+bool encryptBuffer(const KeyMaterial &material, ByteSpan input, MutableByteSpan output, uint64_t offset) {
+    if (output.size < input.size) return false;
+    return aesCtrAt(input.data, input.size, material.key, material.iv, offset, output.data);
+}
+
+bool decryptBuffer(const KeyMaterial &material, ByteSpan input, MutableByteSpan output, uint64_t offset) {
+    return encryptBuffer(material, input, output, offset);
+}
+
+CtrStream::CtrStream(const KeyMaterial &material, uint64_t offset)
+    : ctx_(newCtrContext(material.key, material.iv, offset)), position_(offset) {
+}
+
+CtrStream::~CtrStream() {
+    EVP_CIPHER_CTX_free(ctx_);
+}
+
+CtrStream::CtrStream(CtrStream &&other) noexcept : ctx_(other.ctx_), position_(other.position_) {
+    other.ctx_ = nullptr;
+}
+
+CtrStream &CtrStream::operator=(CtrStream &&other) noexcept {
+    std::swap(ctx_, other.ctx_);
+    std::swap(position_, other.position_);
+    return *this;
+}
+
+bool CtrStream::update(ByteSpan input, MutableByteSpan output) {
+    if (!ctx_ || output.size < input.size) return false;
+    if (!ctrUpdate(ctx_, input.data, input.size, output.data)) return opensslFailed();
+    position_ += input.size;
+    return true;
+}
+
+} // namespace enigmacore
@@ -0,0 +1,82 @@
+#include "enigmacore/enigmacore_c.h"
+#include "internal.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+using namespace enigmacore;
+
+struct enigmacore_stream {
+    CtrStream stream;
+};
+
+// Función para construir el material de clave a partir de los punteros de la ABI de C
+static KeyMaterial toKeyMaterial(const unsigned char *key, const unsigned char *iv) {
+    KeyMaterial material;
+    std::memcpy(material.key, key, sizeof(material.key));
+    std::memcpy(material.iv, iv, sizeof(material.iv));
+    return material;
+}
+
+extern "C" {
+
+int enigmacore_generate_key(unsigned char key[ENIGMACORE_KEY_SIZE], unsigned char iv[ENIGMACORE_IV_SIZE]) {
+    if (!key || !iv) return -1;
+    KeyMaterial material;
+    if (!generateKey(material)) return -1;
+    std::memcpy(key, material.key, sizeof(material.key));
+    std::memcpy(iv, material.iv, sizeof(material.iv));
+    return 0;
+}
+
+int enigmacore_crypt_buffer(const unsigned char key[ENIGMACORE_KEY_SIZE], const unsigned char iv[ENIGMACORE_IV_SIZE],
+                            uint64_t offset, const unsigned char *in, unsigned char *out, size_t len) {
+    if (!key || !iv || (len && (!in || !out))) return -1;
+    return aesCtrAt(in, len, key, iv, offset, out) ? 0 : -1;
+}
+
+enigmacore_stream *enigmacore_stream_new(const unsigned char key[ENIGMACORE_KEY_SIZE],
+                                         const unsigned char iv[ENIGMACORE_IV_SIZE], uint64_t offset) {
+    if (!key || !iv) return nullptr;
+    CtrStream stream(toKeyMaterial(key, iv), offset);
+    if (!stream.ready()) return nullptr;
+    return new(std::nothrow) enigmacore_stream{std::move(stream)};
+}
+
+int enigmacore_stream_update(enigmacore_stream *stream, const unsigned char *in, unsigned char *out, size_t len) {
+    if (!stream || (len && (!in || !out))) return -1;
+    return stream->stream.update({in, len}, {out, len}) ? 0 : -1;
+}
+
+void enigmacore_stream_free(enigmacore_stream *stream) {
+    delete stream;
+}
+
+int enigmacore_encrypt_file(const char *input_path, const char *output_path) {
+    if (!input_path || !output_path) return -1;
+    // Las excepciones no deben cruzar la frontera de C
+    try {
+        return encrypt(input_path, output_path) ? 0 : -1;
+    } catch (const std::exception &e) {
+        std::cerr << "❌ [ERROR] " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int enigmacore_decrypt_file(const char *input_path, const char *output_path) {
+    if (!input_path || !output_path) return -1;
+    // Las excepciones no deben cruzar la frontera de C
+    try {
+        return decrypt(input_path, output_path) ? 0 : -1;
+    } catch (const std::exception &e) {
+        std::cerr << "❌ [ERROR] " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+void enigmacore_set_verbose(int verbose) {
+    setVerbose(verbose != 0);
+}
+
+} // extern "C"
@@ -0,0 +1,617 @@
+#include "internal.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace enigmacore {
+
+// Función para mostrar las rutas (con 'verbose'), crear el directorio de salida y abrir ambos archivos en modo
+// binario
+static bool openFiles(const std::string &input_path, const std::string &output_path, std::ifstream &inputFile,
+                      std::ofstream &outputFile, bool verbose) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (verbose) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    // Crear el directorio de salida si no existe
+    std::filesystem::path outputFilePath(output_path);
+    std::filesystem::path outputDir = outputFilePath.parent_path();
+    if (!outputDir.empty() && !std::filesystem::exists(outputDir)) {
+        // Si el directorio de salida no existe, intentar crearlo
+        if (!std::filesystem::create_directories(outputDir)) {
+            std::cerr << "❌ [ERROR] No se pudo crear el directorio: " << outputDir << std::endl;
+            return false; // Salir si la creación del directorio falla
+        }
+    }
+
+    // Abrir el archivo de entrada en modo binario
+    inputFile.open(input_path, std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        return false; // Salir si no se puede abrir el archivo de entrada
+    }
+
+    // Crear el archivo de salida en modo binario
+    outputFile.open(output_path, std::ios::binary);
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false; // Salir si no se puede crear el archivo de salida
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Motor de archivos por políticas
+// ------------------------------------------------------------------------
+// El motor se compone en tiempo de compilación con cuatro políticas:
+//   - cifrado: el keystream de cada posición de los datos (LegacyKeystream en los formatos básico y RSA)
+//   - E/S: bloques secuenciales, o segmentos en paralelo leídos con pread (PreadIO) o desde mmap (MmapIO)
+//     y, con cipher=kernel, de archivo a archivo con splice a través de AF_ALG (cryptKernel)
+//   - cabecera: cómo se guardan la clave y el IV delante de los datos (BasicHeader, RsaHeader)
+//   - dirección: Encrypt o Decrypt
+// cryptData y cryptFile eligen la instanciación una sola vez por archivo, así que los bucles no comprueban en
+// cada bloque el modo de E/S, la dirección ni si hay que informar del progreso. Con las opciones de CMake
+// ENIGMACORE_IO_SEGMENTS, ENIGMACORE_IO_MMAP y ENIGMACORE_KERNEL_CRYPTO se pueden quitar los modos que no se usen.
+
+// Keystream del formato básico. El contador vuelve a empezar en 'iv' cada 4096 bytes, así que el
+// keystream de cualquier posición es el del byte 'posición % 4096' y basta con calcularlo una vez.
+// Esto permite leer y escribir en bloques de cualquier tamaño sin cambiar el formato.
+class LegacyKeystream {
+public:
+    static constexpr size_t period = 4096;
+
+    LegacyKeystream(const unsigned char *key, const unsigned char *iv) {
+        std::memset(bytes_, 0, sizeof(bytes_));
+        ready_ = aesCrypt<Encrypt>(bytes_, sizeof(bytes_), key, iv, bytes_);
+    }
+
+    // false si OpenSSL no pudo calcular el keystream
+    bool ready() const { return ready_; }
+
+    // Función para cifrar/descifrar 'len' bytes situados en la posición 'position' de los datos
+    void apply(const unsigned char *input, unsigned char *output, size_t len, uint64_t position) const {
+        size_t offset = static_cast<size_t>(position % sizeof(bytes_));
+        for (size_t done = 0; done < len;) {
+            size_t step = std::min(sizeof(bytes_) - offset, len - done);
+            xorBytes(input + done, bytes_ + offset, output + done, step);
+            done += step;
+            offset = 0;
+        }
+    }
+
+private:
+    static void xorBytes(const unsigned char *a, const unsigned char *b, unsigned char *out, size_t len) {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t x, y;
+            std::memcpy(&x, a + i, 8);
+            std::memcpy(&y, b + i, 8);
+            x ^= y;
+            std::memcpy(out + i, &x, 8);
+        }
+        for (; i < len; ++i) out[i] = a[i] ^ b[i];
+    }
+
+    unsigned char bytes_[period];
+    bool ready_ = false;
+};
+
+// Función para cifrar/descifrar el resto de 'inputFile' de forma secuencial en bloques de 'chunkSize' bytes.
+// Con 'Reporting' se informa del progreso. Devuelve false si falla la lectura o la escritura, o si 'progress'
+// pide cancelar la operación ('cancelled').
+template <bool Reporting, class Cipher>
+static bool cryptBlocks(std::ifstream &inputFile, std::ofstream &outputFile, const Cipher &cipher,
+                        size_t chunkSize, const ProgressCallback &progress, bool &cancelled) {
+    cancelled = false;
+    // Preparar un buffer para leer el archivo en bloques
+    MemoryReservation reservation(chunkSize);
+    std::vector<unsigned char> buffer(chunkSize);
+    size_t totalBytesRead = 0; // Contador de bytes leídos
+    size_t lastReported = 0;
+
+    // Bytes que quedan por procesar desde la posición actual
+    uint64_t fileSize = 0;
+    if constexpr (Reporting) {
+        std::streampos current = inputFile.tellg();
+        inputFile.seekg(0, std::ios::end);
+        fileSize = static_cast<uint64_t>(inputFile.tellg() - current);
+        inputFile.seekg(current);
+        if (!progress(0, fileSize)) {
+            cancelled = true;
+            return false;
+        }
+    }
+
+    // Leer el archivo en bloques y cifrar/descifrar cada bloque
+    while (inputFile.read(reinterpret_cast<char *>(buffer.data()), buffer.size()) || inputFile.gcount() > 0) {
+        cipher.apply(buffer.data(), buffer.data(), inputFile.gcount(), totalBytesRead);
+        // Escribir los datos procesados en el archivo de salida
+        if (!outputFile.write(reinterpret_cast<char *>(buffer.data()), inputFile.gcount())) return false;
+        totalBytesRead += inputFile.gcount(); // Actualizar el contador de bytes leídos
+
+        // Informar cada 1 MB para no pagar la llamada en cada bloque
+        if constexpr (Reporting) {
+            if (totalBytesRead - lastReported >= (1 << 20) || totalBytesRead == fileSize) {
+                lastReported = totalBytesRead;
+                if (!progress(totalBytesRead, fileSize)) {
+                    cancelled = true;
+                    return false;
+                }
+            }
+        }
+
+        // Comentar la siguiente línea para habilitar la barra de progreso opcional
+        // showProgress(totalBytesRead, fileSize);
+    }
+    // El bucle también termina si falla la lectura
+    return !inputFile.bad();
+}
+
+#ifdef ENIGMA_HAVE_SEGMENTED_IO
+// Políticas de E/S por segmentos: 'process' deja en 'buffer' los 'len' bytes que empiezan en 'inputOffset'
+// del archivo de entrada ya procesados con el keystream de la posición 'position'
+
+// Lectura con pread: cada hilo lee su segmento en su buffer y lo procesa en el sitio
+class PreadIO {
+public:
+    explicit PreadIO(int fd) : fd_(fd) {
+    }
+
+    template <class Cipher>
+    bool process(const Cipher &cipher, unsigned char *buffer, size_t len, uint64_t inputOffset,
+                 uint64_t position) const {
+        if (!preadAll(fd_, buffer, len, inputOffset)) return false;
+        cipher.apply(buffer, buffer, len, position);
+        return true;
+    }
+
+private:
+    int fd_;
+};
+
+#ifdef ENIGMA_HAVE_MMAP_IO
+// Lectura con mmap: los datos se leen directamente de la caché de páginas, sin copiarlos antes a un buffer
+class MmapIO {
+public:
+    MmapIO(int fd, uint64_t size) : size_(static_cast<size_t>(size)) {
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, size_, MADV_SEQUENTIAL);
+            mapped_ = static_cast<const unsigned char *>(map);
+        }
+    }
+
+    ~MmapIO() {
+        if (mapped_) munmap(const_cast<unsigned char *>(mapped_), size_);
+    }
+
+    MmapIO(const MmapIO &) = delete;
+    MmapIO &operator=(const MmapIO &) = delete;
+
+    // Si el archivo no se pudo proyectar se usa PreadIO
+    bool mapped() const { return mapped_ != nullptr; }
+
+    template <class Cipher>
+    bool process(const Cipher &cipher, unsigned char *buffer, size_t len, uint64_t inputOffset,
+                 uint64_t position) const {
+        cipher.apply(mapped_ + inputOffset, buffer, len, position);
+        return true;
+    }
+
+private:
+    const unsigned char *mapped_ = nullptr;
+    size_t size_;
+};
+#endif
+
+// Función para cifrar/descifrar 'length' bytes en segmentos de 'segmentSize' repartidos entre los nodos
+// NUMA. Cada hilo obtiene sus segmentos con la política 'IO', los escribe con pwrite y usa su propio buffer,
+// local a su nodo. El resultado es idéntico al del procesamiento secuencial.
+template <class IO, bool Reporting, class Cipher>
+static void cryptSegments(const IO &io, int out, uint64_t inputOffset, uint64_t outputOffset, uint64_t length,
+                          const Cipher &cipher, size_t segmentSize, size_t threads, const ProgressCallback &progress,
+                          std::atomic<bool> &failed, std::atomic<bool> &stop) {
+    std::atomic<uint64_t> done{0};
+    std::mutex progressMutex;
+    size_t segments = static_cast<size_t>((length + segmentSize - 1) / segmentSize);
+    if (!parallelForNodes(segments, threads, [&](size_t index) {
+        // Tras una cancelación los segmentos que quedan se saltan sin contar como fallo
+        if (stop) return true;
+        uint64_t offset = static_cast<uint64_t>(index) * segmentSize;
+        size_t len = static_cast<size_t>(std::min<uint64_t>(segmentSize, length - offset));
+        unsigned char *buffer = workerBuffer(segmentSize);
+        if (!io.process(cipher, buffer, len, inputOffset + offset, offset) ||
+            !pwriteAll(out, buffer, len, outputOffset + offset)) {
+            return false;
+        }
+        if constexpr (Reporting) {
+            uint64_t processed = done += len;
+            std::lock_guard<std::mutex> lock(progressMutex);
+            if (!progress(processed, length)) stop = true;
+        }
+        return true;
+    }, segmentSize)) {
+        failed = true;
+    }
+}
+
+// Función para elegir la instanciación de cryptSegments según haya que informar del progreso o no
+template <class IO, class Cipher>
+static void cryptSegmentsWith(const IO &io, int out, uint64_t inputOffset, uint64_t outputOffset, uint64_t length,
+                              const Cipher &cipher, size_t segmentSize, size_t threads,
+                              const ProgressCallback &progress, std::atomic<bool> &failed, std::atomic<bool> &stop) {
+    if (progress) {
+        cryptSegments<IO, true>(io, out, inputOffset, outputOffset, length, cipher, segmentSize, threads, progress,
+                                failed, stop);
+    } else {
+        cryptSegments<IO, false>(io, out, inputOffset, outputOffset, length, cipher, segmentSize, threads, progress,
+                                 failed, stop);
+    }
+}
+
+// Función para abrir los archivos y procesar los datos por segmentos, leídos desde mmap si se pide y el
+// archivo se puede proyectar, o con pread
+template <class Cipher>
+static bool cryptSegmented(const std::string &input_path, uint64_t inputOffset, const std::string &output_path,
+                           uint64_t outputOffset, uint64_t length, const Cipher &cipher, size_t segmentSize,
+                           size_t threads, bool useMmap, const ProgressCallback &progress, bool &cancelled) {
+    cancelled = false;
+    int in = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+    int out = open(output_path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (in < 0 || out < 0 || ftruncate(out, static_cast<off_t>(outputOffset + length)) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo preparar el archivo de salida: " << output_path << std::endl;
+        if (in >= 0) close(in);
+        if (out >= 0) close(out);
+        return false;
+    }
+
+    std::atomic<bool> failed{false};
+    std::atomic<bool> stop{false};
+    if (progress && !progress(0, length)) stop = true;
+
+    bool processed = stop;
+#ifdef ENIGMA_HAVE_MMAP_IO
+    if (useMmap && !processed) {
+        MmapIO io(in, inputOffset + length);
+        if (io.mapped()) {
+            cryptSegmentsWith(io, out, inputOffset, outputOffset, length, cipher, segmentSize, threads, progress,
+                              failed, stop);
+            processed = true;
+        }
+    }
+#else
+    (void) useMmap;
+#endif
+    if (!processed) {
+        cryptSegmentsWith(PreadIO(in), out, inputOffset, outputOffset, length, cipher, segmentSize, threads,
+                          progress, failed, stop);
+    }
+    close(in);
+    if (close(out) != 0) failed = true;
+
+    if (failed) std::cerr << "❌ [ERROR] Error de lectura/escritura procesando: " << input_path << std::endl;
+    cancelled = stop && !failed;
+    return !failed && !stop;
+}
+#endif
+
+#ifdef ENIGMA_HAVE_KERNEL_CRYPTO
+// Backend del kernel: cada hilo lleva sus segmentos de la entrada a la salida con splice a través de un
+// socket AF_ALG, sin copiarlos a la memoria del proceso. Los segmentos empiezan en un límite del periodo del
+// keystream, así que cada petición al kernel cifra un periodo desde 'iv'. Devuelve false sin mostrar errores si
+// el kernel no tiene el algoritmo o no admite splice con estos archivos: entonces se usa OpenSSL, que reescribe
+// la salida entera.
+static bool cryptKernel(const std::string &input_path, uint64_t inputOffset, const std::string &output_path,
+                        uint64_t outputOffset, uint64_t length, const unsigned char *key, const unsigned char *iv,
+                        size_t segmentSize, size_t threads) {
+    KernelCtr kernel(key);
+    if (!kernel.ready()) return false;
+    int in = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+    int out = open(output_path.c_str(), O_WRONLY | O_CLOEXEC);
+    std::atomic<bool> failed{in < 0 || out < 0 || ftruncate(out, static_cast<off_t>(outputOffset + length)) != 0};
+
+    const size_t period = LegacyKeystream::period;
+    segmentSize = (segmentSize + period - 1) / period * period;
+    size_t segments = static_cast<size_t>((length + segmentSize - 1) / segmentSize);
+    if (!failed) {
+        if (!parallelForNodes(segments, threads, [&](size_t index) {
+            uint64_t offset = static_cast<uint64_t>(index) * segmentSize;
+            uint64_t len = std::min<uint64_t>(segmentSize, length - offset);
+            return kernel.crypt(in, inputOffset + offset, out, outputOffset + offset, len, iv, period);
+        })) {
+            failed = true;
+        }
+    }
+    if (in >= 0) close(in);
+    if (out >= 0 && close(out) != 0) failed = true;
+    return !failed;
+}
+#endif
+
+bool kernelCryptoAvailable() {
+#ifdef ENIGMA_HAVE_KERNEL_CRYPTO
+    unsigned char key[32] = {0};
+    return KernelCtr(key).ready();
+#else
+    return false;
+#endif
+}
+
+bool ioBackendAvailable(const std::string &io) {
+#ifdef ENIGMA_HAVE_SEGMENTED_IO
+    const bool preadBuilt = true;
+#else
+    const bool preadBuilt = false;
+#endif
+#ifdef ENIGMA_HAVE_MMAP_IO
+    const bool mmapBuilt = true;
+#else
+    const bool mmapBuilt = false;
+#endif
+    if (io == "pread") return preadBuilt;
+    if (io == "mmap") return mmapBuilt;
+    return true;
+}
+
+// Función para procesar los datos que siguen a la cabecera con el perfil de rendimiento 'profile'
+// (tamaño de bloque, hilos y modo de E/S). Si falla o se cancela, se borra la salida parcial.
+static bool cryptData(std::ifstream &inputFile, const std::string &input_path, std::ofstream &outputFile,
+                      const std::string &output_path, const unsigned char *key, const unsigned char *iv,
+                      const ProgressCallback &progress, bool verbose, const TuningProfile &profile) {
+    size_t chunkSize = budgetedChunk(profile.chunk_size);
+    LegacyKeystream keystream(key, iv);
+    std::error_code ec;
+    if (!keystream.ready()) {
+        outputFile.close();
+        std::filesystem::remove(output_path, ec);
+        return false;
+    }
+#if defined(ENIGMA_HAVE_KERNEL_CRYPTO) || defined(ENIGMA_HAVE_SEGMENTED_IO)
+    // Posiciones y tamaño de los datos, solo para los modos que trabajan con descriptores
+    uint64_t inputOffset = static_cast<uint64_t>(inputFile.tellg());
+    uint64_t outputOffset = static_cast<uint64_t>(outputFile.tellp());
+    uint64_t inputSize = std::filesystem::file_size(input_path, ec);
+    uint64_t length = !ec && inputSize > inputOffset ? inputSize - inputOffset : 0;
+#endif
+#ifdef ENIGMA_HAVE_KERNEL_CRYPTO
+    // Con cipher=kernel los trabajos de archivo a archivo se cifran en el kernel; con informe de progreso, o si el
+    // kernel no puede, se sigue con OpenSSL
+    if (profile.cipher == "kernel" && !progress && length > 0 && outputFile.flush() &&
+        cryptKernel(input_path, inputOffset, output_path, outputOffset, length, key, iv, chunkSize, profile.threads)) {
+        outputFile.close();
+        if (outputFile) return true;
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        std::filesystem::remove(output_path, ec);
+        return false;
+    }
+#endif
+    bool ok = false;
+    bool cancelled = false;
+    bool segmented = false;
+#ifdef ENIGMA_HAVE_SEGMENTED_IO
+    if (length > 0 && (profile.io == "pread" || profile.io == "mmap" ||
+                       (profile.io == "auto" && length >= kParallelFileSize))) {
+        // Las páginas proyectadas con mmap cuentan en la memoria residente del proceso: con límite de
+        // memoria se lee con pread
+        bool useMmap = profile.io == "mmap" && !memoryBudget();
+        // Al cerrar se escribe la cabecera
+        outputFile.close();
+        if (!outputFile) {
+            std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        } else {
+            ok = cryptSegmented(input_path, inputOffset, output_path, outputOffset, length, keystream, chunkSize,
+                                profile.threads, useMmap, progress, cancelled);
+        }
+        segmented = true;
+    }
+#endif
+    // Sin el modo por segmentos compilado, todo se procesa por bloques secuenciales
+    if (!segmented) {
+        ok = progress ? cryptBlocks<true>(inputFile, outputFile, keystream, chunkSize, progress, cancelled)
+                      : cryptBlocks<false>(inputFile, outputFile, keystream, chunkSize, progress, cancelled);
+        // Al cerrar se escribe lo que quede en el buffer, que también puede fallar (por ejemplo, disco lleno)
+        if (ok) {
+            outputFile.close();
+            ok = static_cast<bool>(outputFile);
+        }
+        if (!ok && !cancelled) {
+            std::cerr << "❌ [ERROR] Error de lectura/escritura procesando: " << input_path << std::endl;
+        }
+    }
+
+    if (!ok) {
+        // Descartar la salida parcial
+        outputFile.close();
+        std::filesystem::remove(output_path, ec);
+        if (cancelled && verbose) std::cout << "Cancelled: " << output_path << std::endl;
+    }
+    return ok;
+}
+
+// Políticas de cabecera: 'write' guarda la clave y el IV al cifrar y 'read' los recupera al descifrar
+
+// Formato básico: la clave y el IV en claro
+struct BasicHeader {
+    bool write(std::ofstream &outputFile, unsigned char *key, unsigned char *iv) const {
+        // Guardar la clave y el IV en el archivo de salida (por ejemplo, al principio del archivo)
+        outputFile.write(reinterpret_cast<char *>(key), 32);
+        outputFile.write(reinterpret_cast<char *>(iv), 16);
+        return static_cast<bool>(outputFile);
+    }
+
+    bool read(std::ifstream &inputFile, unsigned char *key, unsigned char *iv, const std::string &path) const {
+        // Leer la clave y el IV del archivo cifrado
+        if (!inputFile.read(reinterpret_cast<char *>(key), 32) ||
+            !inputFile.read(reinterpret_cast<char *>(iv), 16)) {
+            std::cerr << "❌ [ERROR] Archivo cifrado incompleto: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Formato RSA: la clave y el IV cifrados con la llave pública (al cifrar) o la privada (al descifrar)
+struct RsaHeader {
+    const std::string &key_path;
+
+    bool write(std::ofstream &outputFile, unsigned char *key, unsigned char *iv) const {
+        return encryptAESKeyAndIV(key_path, key, iv, outputFile);
+    }
+
+    bool read(std::ifstream &inputFile, unsigned char *key, unsigned char *iv, const std::string &) const {
+        return decryptAESKeyAndIV(key_path, key, iv, inputFile);
+    }
+};
+
+// Función para cifrar o descifrar un archivo completo con la cabecera 'Header' y el perfil 'profile'. Al cifrar
+// se genera una clave nueva y se escribe la cabecera; al descifrar se lee.
+template <class Direction, class Header>
+static bool cryptFile(const std::string &input_path, const std::string &output_path, const Header &header,
+                      const ProgressCallback &progress, bool verbose, const TuningProfile &profile) {
+    std::ifstream inputFile;
+    std::ofstream outputFile;
+    if (!openFiles(input_path, output_path, inputFile, outputFile, verbose)) return false;
+
+    unsigned char key[32], iv[16];
+    if constexpr (Direction::encrypting) {
+        // Generar la clave y el vector de inicialización (IV) aleatorios
+        if (!randomBytes(key, sizeof(key)) || !randomBytes(iv, sizeof(iv))) return false;
+        if (!header.write(outputFile, key, iv)) return false;
+    } else {
+        if (!header.read(inputFile, key, iv, input_path)) return false;
+    }
+
+    if (!cryptData(inputFile, input_path, outputFile, output_path, key, iv, progress, verbose, profile)) return false;
+
+    // Imprimir un mensaje indicando que el proceso ha finalizado
+    if (verbose) {
+        std::cout << std::endl;
+        std::cout << (Direction::encrypting ? "Encrypted image" : "Decrypted image") << std::endl;
+    }
+    return true;
+}
+
+// Función para cifrar un archivo
+bool encrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress) {
+    return encrypt(input_path, output_path, progress, isVerbose());
+}
+
+bool encrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose) {
+    return cryptFile<Encrypt>(input_path, output_path, BasicHeader(), progress, verbose, tuningProfile());
+}
+
+bool encrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose, const TuningProfile &profile) {
+    return cryptFile<Encrypt>(input_path, output_path, BasicHeader(), progress, verbose, profile);
+}
+
+// Función para descifrar un archivo
+bool decrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress) {
+    return decrypt(input_path, output_path, progress, isVerbose());
+}
+
+bool decrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose) {
+    return cryptFile<Decrypt>(input_path, output_path, BasicHeader(), progress, verbose, tuningProfile());
+}
+
+bool decrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose, const TuningProfile &profile) {
+    return cryptFile<Decrypt>(input_path, output_path, BasicHeader(), progress, verbose, profile);
+}
+
+// Función para descifrar en memoria el resto de 'inputFile' y compararlo con 'originalFile', bloque a bloque
+bool compareDecrypted(std::ifstream &inputFile, std::ifstream &originalFile, unsigned char *key, unsigned char *iv,
+                      const std::string &encrypted_path) {
+    LegacyKeystream keystream(key, iv);
+    if (!keystream.ready()) return false;
+    size_t chunkSize = budgetedChunk(tuningProfile().chunk_size);
+    MemoryReservation reservation(2 * static_cast<uint64_t>(chunkSize));
+    std::vector<unsigned char> buffer(chunkSize);
+    std::vector<unsigned char> expected(chunkSize);
+    uint64_t position = 0;
+    while (inputFile.read(reinterpret_cast<char *>(buffer.data()), buffer.size()) || inputFile.gcount() > 0) {
+        std::streamsize count = inputFile.gcount();
+        keystream.apply(buffer.data(), buffer.data(), count, position);
+        position += count;
+        originalFile.read(reinterpret_cast<char *>(expected.data()), count);
+        if (originalFile.gcount() != count || !std::equal(buffer.begin(), buffer.begin() + count, expected.begin())) {
+            std::cerr << "❌ [ERROR] El contenido descifrado no coincide con el original: " << encrypted_path
+                    << std::endl;
+            return false;
+        }
+    }
+    // El original no debe tener bytes de más
+    if (originalFile.peek() != std::ifstream::traits_type::eof()) {
+        std::cerr << "❌ [ERROR] El contenido descifrado no coincide con el original: " << encrypted_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Función para comprobar un archivo cifrado descifrándolo en memoria y comparándolo con el original
+bool verify(const std::string &encrypted_path, const std::string &original_path,
+            const std::string &private_key_path) {
+    std::ifstream inputFile(encrypted_path, std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << encrypted_path << std::endl;
+        return false;
+    }
+    std::ifstream originalFile(original_path, std::ios::binary);
+    if (!originalFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << original_path << std::endl;
+        return false;
+    }
+
+    unsigned char key[32], iv[16];
+    bool headerRead = private_key_path.empty()
+                          ? BasicHeader().read(inputFile, key, iv, encrypted_path)
+                          : RsaHeader{private_key_path}.read(inputFile, key, iv, encrypted_path);
+    if (!headerRead) return false;
+
+    return compareDecrypted(inputFile, originalFile, key, iv, encrypted_path);
+}
+
+// Función para cifrar un archivo guardando la clave y el IV cifrados con la llave pública RSA
+bool encryptRSA(const std::string &input_path, const std::string &output_path,
+                const std::string &public_key_path) {
+    return encryptRSA(input_path, output_path, public_key_path, isVerbose());
+}
+
+bool encryptRSA(const std::string &input_path, const std::string &output_path, const std::string &public_key_path,
+                bool verbose) {
+    return cryptFile<Encrypt>(input_path, output_path, RsaHeader{public_key_path}, nullptr, verbose,
+                              tuningProfile());
+}
+
+// Función para descifrar un archivo cuya clave está cifrada con RSA
+bool decryptRSA(const std::string &input_path, const std::string &output_path,
+                const std::string &private_key_path) {
+    return decryptRSA(input_path, output_path, private_key_path, isVerbose());
+}
+
+bool decryptRSA(const std::string &input_path, const std::string &output_path, const std::string &private_key_path,
+                bool verbose) {
+    return cryptFile<Decrypt>(input_path, output_path, RsaHeader{private_key_path}, nullptr, verbose,
+                              tuningProfile());
+}
+
+// Función para descifrar los datos de un archivo a partir de 'data_offset', con la clave y el IV ya recuperados
+bool decryptPayload(const std::string &input_path, uint64_t data_offset, const std::string &output_path,
+                    unsigned char *key, unsigned char *iv, bool verbose) {
+    std::ifstream inputFile;
+    std::ofstream outputFile;
+    if (!openFiles(input_path, output_path, inputFile, outputFile, verbose)) return false;
+    inputFile.seekg(static_cast<std::streamoff>(data_offset));
+    return cryptData(inputFile, input_path, outputFile, output_path, key, iv, nullptr, verbose, tuningProfile());
+}
+
+} // namespace enigmacore
@@ -0,0 +1,352 @@
+#include "internal.h"
+
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace enigmacore {
+
+// ----------------------------------------------------------------------------
+// Cifrado incremental con fragmentación definida por contenido (FastCDC)
+// ----------------------------------------------------------------------------
+// La entrada se divide en fragmentos cuyos límites dependen del contenido, de modo que una
+// edición local solo cambia los fragmentos cercanos. Cada fragmento se cifra de forma
+// determinista con la clave del archivo (el IV sale del HMAC del fragmento) y se guarda en
+// <salida>/chunks con su identificador como nombre. El manifiesto enumera los fragmentos en
+// orden; al volver a cifrar solo se escriben los fragmentos que no estaban en el manifiesto anterior.
+// La clave del archivo va envuelta en el manifiesto con una llave del almacén.
+
+const size_t kCdcMinSize = 16 * 1024;  // Tamaño mínimo de fragmento
+const size_t kCdcAvgSize = 64 * 1024;  // Tamaño medio esperado de fragmento
+const size_t kCdcMaxSize = 256 * 1024; // Tamaño máximo de fragmento
+// Máscaras de corte de FastCDC (bits altos del hash gear): más exigente antes del tamaño
+// medio y más permisiva después ("normalized chunking", nivel 2)
+const uint64_t kCdcMaskS = ((1ULL << 18) - 1) << (64 - 18);
+const uint64_t kCdcMaskL = ((1ULL << 14) - 1) << (64 - 14);
+const char kCdcManifestName[] = "manifest.txt";
+const char kCdcManifestMagic[] = "ENIGMACORE-CDC 2";
+
+// Tabla "gear" de FastCDC. Se genera con splitmix64 a partir de una semilla fija: forma parte
+// del formato, cambiarla movería todos los límites de fragmento. La inicialización de la variable estática es
+// segura aunque varios hilos cifren a la vez
+struct GearTable {
+    uint64_t values[256];
+};
+
+static const uint64_t *gearTable() {
+    static const GearTable table = [] {
+        GearTable generated;
+        uint64_t state = 0x456e69676d61434fULL;
+        for (uint64_t &value: generated.values) {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            value = z ^ (z >> 31);
+        }
+        return generated;
+    }();
+    return table.values;
+}
+
+// Función para encontrar el siguiente punto de corte dentro de 'data' (devuelve la longitud del fragmento)
+static size_t fastcdcCut(const unsigned char *data, size_t len) {
+    if (len <= kCdcMinSize) return len;
+    const uint64_t *gear = gearTable();
+    size_t normal = std::min(len, kCdcAvgSize);
+    size_t limit = std::min(len, kCdcMaxSize);
+    uint64_t hash = 0;
+    size_t i = kCdcMinSize;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & kCdcMaskS)) return i + 1;
+    }
+    for (; i < limit; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & kCdcMaskL)) return i + 1;
+    }
+    return limit;
+}
+
+// Fragmento registrado en el manifiesto
+struct CdcChunk {
+    std::string id; // HMAC-SHA256 del texto plano en hexadecimal
+    size_t size;    // Tamaño del fragmento en bytes
+};
+
+// Manifiesto de un archivo cifrado de forma incremental
+struct CdcManifest {
+    std::string keyId;
+    std::vector<unsigned char> wrapped; // clave envuelta con la llave
+    unsigned char key[32];
+    size_t size = 0;
+    std::vector<CdcChunk> chunks;
+};
+
+// Función para leer el manifiesto; devuelve false si no existe o está dañado. La clave queda por desenvolver.
+static bool readCdcManifest(const std::filesystem::path &path, CdcManifest &manifest) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    if (!std::getline(file, line) || line != kCdcManifestMagic) return false;
+
+    // El identificador de la llave ocupa el resto de la línea
+    std::string field, value;
+    if (!(file >> field >> std::ws) || field != "key-id" || !std::getline(file, manifest.keyId)) return false;
+    if (!(file >> field >> value) || field != "wrapped-key") return false;
+    manifest.wrapped.resize(value.size() / 2);
+    if (!fromHex(value, manifest.wrapped.data(), manifest.wrapped.size())) return false;
+    if (!(file >> field >> manifest.size) || field != "size") return false;
+
+    CdcChunk chunk;
+    while (file >> field >> chunk.id >> chunk.size) {
+        if (field != "chunk" || chunk.id.size() != 64) return false;
+        manifest.chunks.push_back(chunk);
+    }
+    return file.eof();
+}
+
+// Función para escribir el manifiesto (primero en un temporal y luego se renombra)
+static bool writeCdcManifest(const std::filesystem::path &path, const CdcManifest &manifest) {
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) return false;
+        file << kCdcManifestMagic << "\n";
+        file << "key-id " << manifest.keyId << "\n";
+        file << "wrapped-key " << toHex(manifest.wrapped.data(), manifest.wrapped.size()) << "\n";
+        file << "size " << manifest.size << "\n";
+        for (const CdcChunk &chunk: manifest.chunks) {
+            file << "chunk " << chunk.id << " " << chunk.size << "\n";
+        }
+        file.close();
+        if (!file) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+// Ruta del fragmento dentro del almacén (dos niveles para no llenar un solo directorio)
+static std::filesystem::path cdcChunkPath(const std::filesystem::path &dir, const std::string &id) {
+    return dir / "chunks" / id.substr(0, 2) / (id + ".bin");
+}
+
+// Funciones para envolver y recuperar la clave del manifiesto con el almacén. El formato no usa IV (el de cada
+// fragmento sale de su HMAC), así que se envuelve uno a cero.
+static bool wrapCdcKey(const Keystore &keystore, CdcManifest &manifest) {
+    unsigned char iv[16] = {0};
+    return wrapWithKeystore(keystore, manifest.keyId, manifest.key, iv, manifest.wrapped);
+}
+
+static bool unwrapCdcKey(const Keystore &keystore, CdcManifest &manifest, const std::string &path) {
+    unsigned char iv[16];
+    return unwrapWithKeystore(keystore, manifest.keyId, manifest.wrapped, manifest.key, iv, path);
+}
+
+// Función para cifrar un archivo de forma incremental en el directorio 'output_dir'
+bool encryptIncremental(const std::string &input_path, const std::string &output_dir, const Keystore &keystore,
+                        const std::string &key_id) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_dir << std::endl;
+    }
+
+    // Abrir el archivo de entrada en modo binario
+    std::ifstream inputFile(input_path, std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        return false;
+    }
+
+    std::filesystem::path outputDir(output_dir);
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir / "chunks", ec);
+    if (ec) {
+        std::cerr << "❌ [ERROR] No se pudo crear el directorio: " << outputDir << std::endl;
+        return false;
+    }
+
+    // Reutilizar la clave del manifiesto anterior; sin ella el cifrado no sería determinista
+    std::filesystem::path manifestPath = outputDir / kCdcManifestName;
+    CdcManifest previous;
+    bool hasPrevious = readCdcManifest(manifestPath, previous);
+    if (!hasPrevious && std::filesystem::exists(manifestPath)) {
+        std::cerr << "❌ [ERROR] El manifiesto existente está dañado: " << manifestPath << std::endl;
+        return false;
+    }
+
+    if (hasPrevious && !unwrapCdcKey(keystore, previous, manifestPath.string())) return false;
+
+    // El identificador va en una línea del manifiesto
+    if (key_id.find_first_of("\r\n") != std::string::npos) {
+        std::cerr << "❌ [ERROR] Identificador de llave no válido: " << key_id << std::endl;
+        return false;
+    }
+    CdcManifest manifest;
+    manifest.keyId = key_id;
+    if (hasPrevious) {
+        std::memcpy(manifest.key, previous.key, sizeof(manifest.key));
+    } else if (!randomBytes(manifest.key, sizeof(manifest.key))) {
+        return false;
+    }
+    // La clave se vuelve a envolver en cada pasada, con la llave indicada ahora
+    if (!wrapCdcKey(keystore, manifest)) return false;
+
+    std::unordered_set<std::string> known; // Fragmentos ya presentes en el almacén
+    for (const CdcChunk &chunk: previous.chunks) known.insert(chunk.id);
+
+    MemoryReservation reservation(2 * kCdcMaxSize);
+    std::vector<unsigned char> buffer(kCdcMaxSize);
+    std::vector<unsigned char> outputBuffer(kCdcMaxSize);
+    size_t available = 0; // Bytes pendientes de fragmentar en 'buffer'
+    bool eof = false;
+    size_t chunksWritten = 0, bytesWritten = 0;
+
+    while (true) {
+        // Rellenar el buffer para que el cortador vea siempre hasta el tamaño máximo
+        while (!eof && available < buffer.size()) {
+            inputFile.read(reinterpret_cast<char *>(buffer.data() + available), buffer.size() - available);
+            available += inputFile.gcount();
+            if (!inputFile) eof = true;
+        }
+        if (available == 0) break;
+
+        size_t len = fastcdcCut(buffer.data(), available);
+
+        // Identificador del fragmento: HMAC-SHA256 del texto plano con la clave del archivo
+        unsigned char mac[32];
+        unsigned int macLen = sizeof(mac);
+        if (!HMAC(EVP_sha256(), manifest.key, sizeof(manifest.key), buffer.data(), len, mac, &macLen)) {
+            return opensslFailed();
+        }
+        std::string id = toHex(mac, sizeof(mac));
+
+        std::filesystem::path chunkPath = cdcChunkPath(outputDir, id);
+        bool present = known.count(id) && std::filesystem::file_size(chunkPath, ec) == len && !ec;
+        if (!present) {
+            // Cifrar el fragmento con un IV derivado de su contenido
+            if (!aesCrypt<Encrypt>(buffer.data(), len, manifest.key, mac, outputBuffer.data())) return false;
+            std::filesystem::create_directories(chunkPath.parent_path(), ec);
+            std::ofstream chunkFile(chunkPath, std::ios::binary | std::ios::trunc);
+            chunkFile.write(reinterpret_cast<char *>(outputBuffer.data()), len);
+            chunkFile.close();
+            if (!chunkFile) {
+                // Se borra: si tuviera el tamaño esperado se daría por bueno en la siguiente pasada
+                std::cerr << "❌ [ERROR] No se pudo escribir el fragmento: " << chunkPath << std::endl;
+                std::filesystem::remove(chunkPath, ec);
+                return false;
+            }
+            known.insert(id);
+            ++chunksWritten;
+            bytesWritten += len;
+        }
+
+        manifest.chunks.push_back({id, len});
+        manifest.size += len;
+
+        // Mover los bytes restantes al inicio del buffer
+        std::memmove(buffer.data(), buffer.data() + len, available - len);
+        available -= len;
+    }
+
+    if (!writeCdcManifest(manifestPath, manifest)) {
+        std::cerr << "❌ [ERROR] No se pudo escribir el manifiesto: " << manifestPath << std::endl;
+        return false;
+    }
+
+    // Eliminar los fragmentos que ya no pertenecen al archivo
+    std::unordered_set<std::string> referenced;
+    for (const CdcChunk &chunk: manifest.chunks) referenced.insert(chunk.id);
+    for (const CdcChunk &chunk: previous.chunks) {
+        if (!referenced.count(chunk.id)) std::filesystem::remove(cdcChunkPath(outputDir, chunk.id), ec);
+    }
+
+    if (isVerbose()) {
+        std::cout << "Fragmentos: " << manifest.chunks.size() << ", reescritos: " << chunksWritten
+                << " (" << formatBytes(bytesWritten) << ")" << std::endl;
+        std::cout << "Encrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para reconstruir un archivo cifrado de forma incremental
+bool decryptIncremental(const std::string &input_dir, const std::string &output_path, const Keystore &keystore) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_dir << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    std::filesystem::path inputDir(input_dir);
+    CdcManifest manifest;
+    if (!readCdcManifest(inputDir / kCdcManifestName, manifest)) {
+        std::cerr << "❌ [ERROR] No se pudo leer el manifiesto en: " << input_dir << std::endl;
+        return false;
+    }
+    if (!unwrapCdcKey(keystore, manifest, input_dir)) return false;
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    std::ofstream outputFile(output_path, std::ios::binary);
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+    // Si falla un fragmento se borra la salida: nunca queda un archivo reconstruido a medias
+    auto discard = [&] {
+        outputFile.close();
+        std::error_code ec;
+        std::filesystem::remove(output_path, ec);
+        return false;
+    };
+
+    MemoryReservation reservation(2 * kCdcMaxSize);
+    std::vector<unsigned char> buffer(kCdcMaxSize);
+    std::vector<unsigned char> outputBuffer(kCdcMaxSize);
+    for (const CdcChunk &chunk: manifest.chunks) {
+        unsigned char mac[32];
+        std::filesystem::path chunkPath = cdcChunkPath(inputDir, chunk.id);
+        std::ifstream chunkFile(chunkPath, std::ios::binary);
+        if (chunk.size > buffer.size() || !fromHex(chunk.id, mac, sizeof(mac)) || !chunkFile ||
+            !chunkFile.read(reinterpret_cast<char *>(buffer.data()), chunk.size)) {
+            std::cerr << "❌ [ERROR] No se pudo leer el fragmento: " << chunkPath << std::endl;
+            return discard();
+        }
+
+        if (!aesCrypt<Decrypt>(buffer.data(), chunk.size, manifest.key, mac, outputBuffer.data())) return discard();
+
+        // Comprobar que el fragmento descifrado corresponde a su identificador
+        unsigned char check[32];
+        unsigned int checkLen = sizeof(check);
+        if (!HMAC(EVP_sha256(), manifest.key, sizeof(manifest.key), outputBuffer.data(), chunk.size, check,
+                  &checkLen)) {
+            opensslFailed();
+            return discard();
+        }
+        if (std::memcmp(check, mac, sizeof(mac)) != 0) {
+            std::cerr << "❌ [ERROR] El fragmento está dañado: " << chunkPath << std::endl;
+            return discard();
+        }
+
+        outputFile.write(reinterpret_cast<char *>(outputBuffer.data()), chunk.size);
+    }
+    outputFile.close();
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        return discard();
+    }
+
+    if (isVerbose()) {
+        std::cout << std::endl;
+        std::cout << "Decrypted image" << std::endl;
+    }
+    return true;
+}
+
+} // namespace enigmacore
@@ -0,0 +1,287 @@
+#ifndef ENIGMACORE_INTERNAL_H
+#define ENIGMACORE_INTERNAL_H
+
+// Utilidades compartidas entre los módulos de libenigmacore (no forman parte de la API pública)
+
+#include "enigmacore/enigmacore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct evp_pkey_st EVP_PKEY;
+typedef struct evp_pkey_ctx_st EVP_PKEY_CTX;
+
+namespace enigmacore {
+
+// Función para manejar errores de OpenSSL en las herramientas de línea de comandos (termina el proceso). La
+// biblioteca no la usa: sus funciones muestran el error con opensslFailed() y devuelven false.
+void handleErrors();
+bool opensslFailed();
+
+// Función para llenar 'data' con bytes aleatorios de RAND_bytes; si el generador falla muestra el error y
+// devuelve false
+bool randomBytes(unsigned char *data, size_t len);
+
+// Políticas de dirección: se eligen en tiempo de compilación, así que cada instanciación del motor procesa sus
+// bloques sin comprobar si cifra o descifra
+struct Encrypt {
+    static constexpr bool encrypting = true;
+};
+
+struct Decrypt {
+    static constexpr bool encrypting = false;
+};
+
+// AES-256-CTR con el keystream empezando en 'iv' y la dirección fijada por la política (instanciada para
+// Encrypt y Decrypt); devuelve false si falla OpenSSL
+template <class Direction>
+bool aesCrypt(const unsigned char *input, size_t input_len, const unsigned char *key, const unsigned char *iv,
+              unsigned char *output);
+
+// Función para saber si se deben mostrar los mensajes informativos
+bool isVerbose();
+
+// Variantes de las operaciones de archivo que reciben si deben mostrar los mensajes informativos. Las versiones
+// públicas pasan isVerbose(); los modos por lotes (run-jobs, watch, restore, autotune) las llaman en silencio sin
+// cambiar el ajuste global, que otros hilos pueden estar usando.
+bool encrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose);
+bool decrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose);
+
+// Variantes con un perfil de rendimiento explícito en lugar del activo: autotune mide así cada candidato sin
+// cambiar el perfil que usan las demás operaciones. El límite de memoria es el del perfil activo, porque lo
+// comparten todas las operaciones del proceso.
+bool encrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose, const TuningProfile &profile);
+bool decrypt(const std::string &input_path, const std::string &output_path, const ProgressCallback &progress,
+             bool verbose, const TuningProfile &profile);
+bool encryptRSA(const std::string &input_path, const std::string &output_path, const std::string &public_key_path,
+                bool verbose);
+bool decryptRSA(const std::string &input_path, const std::string &output_path, const std::string &private_key_path,
+                bool verbose);
+
+// Funciones para escribir/leer enteros de 64 bits en little-endian en los contenedores
+void writeU64(std::ostream &out, uint64_t value);
+bool readU64(std::istream &in, uint64_t &value);
+
+// Función para convertir bytes a texto hexadecimal
+std::string toHex(const unsigned char *data, size_t len);
+
+// Función para convertir texto hexadecimal a bytes; devuelve false si el texto no es válido
+bool fromHex(const std::string &hex, unsigned char *out, size_t len);
+
+// Función para leer un archivo completo en memoria
+bool readWholeFile(const std::string &path, std::vector<unsigned char> &data);
+
+// Función para escribir todo el buffer en una posición del descriptor
+bool pwriteAll(int fd, const unsigned char *data, size_t len, uint64_t offset);
+
+// Función para leer exactamente 'len' bytes de una posición del descriptor
+bool preadAll(int fd, unsigned char *data, size_t len, uint64_t offset);
+
+// Función para crear el directorio que contendrá 'path' si no existe
+void createParentDirectory(const std::string &path);
+
+// Región de bytes de un archivo
+struct ByteRegion {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// A partir de este tamaño, con el modo de E/S "auto", los datos de un archivo se procesan por segmentos en paralelo
+const uint64_t kParallelFileSize = 64ULL << 20;
+
+// Función para saber si el modo de E/S ("pread" o "mmap") se incluyó al compilar (opciones ENIGMACORE_IO_*)
+bool ioBackendAvailable(const std::string &io);
+
+// Función para saber si se puede cifrar en el kernel: compilado con ENIGMACORE_KERNEL_CRYPTO y con AF_ALG y
+// "ctr(aes)" disponibles en el kernel en uso
+bool kernelCryptoAvailable();
+
+#ifdef ENIGMA_HAVE_KERNEL_CRYPTO
+// AES-256-CTR en el kernel con AF_ALG ("ctr(aes)"): los datos van de un descriptor a otro con splice a través
+// del socket de operación, sin pasar por la memoria del proceso
+class KernelCtr {
+public:
+    // Prepara el algoritmo con la clave; ready() es false si el kernel no tiene AF_ALG o "ctr(aes)"
+    explicit KernelCtr(const unsigned char *key);
+    ~KernelCtr();
+
+    KernelCtr(const KernelCtr &) = delete;
+    KernelCtr &operator=(const KernelCtr &) = delete;
+
+    bool ready() const { return tfm_ >= 0; }
+
+    // Procesa 'len' bytes de 'in' desde 'input_offset' y los escribe en 'out' desde 'output_offset'. El
+    // keystream vuelve a empezar en 'iv' cada 'period' bytes, como en el formato básico. Se puede llamar desde
+    // varios hilos a la vez; devuelve false, sin mostrar errores, si el kernel no admite la operación.
+    bool crypt(int in, uint64_t input_offset, int out, uint64_t output_offset, uint64_t len,
+               const unsigned char *iv, size_t period) const;
+
+private:
+    int tfm_ = -1;
+};
+#endif
+
+// Nodo NUMA con las CPU que el proceso puede usar
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// Función para obtener los nodos NUMA (uno solo si el sistema no expone la topología)
+const std::vector<NumaNode> &numaNodes();
+
+// Función para fijar el hilo actual a un conjunto de CPU
+bool pinCurrentThread(const std::vector<int> &cpus);
+
+// Función para obtener el buffer de trabajo del hilo actual, de al menos 'size' bytes y local a su nodo.
+// En las tareas de parallelForNodes ya está preparado con 'workerBytes' y cuenta en el límite de memoria hasta
+// que termina la llamada; si una tarea pide más y no hay sitio no espera: lanza una excepción.
+unsigned char *workerBuffer(size_t size);
+
+// Función para obtener el número de hilos de trabajo: 'threads' o, si es 0, los del perfil de rendimiento
+// o las CPU disponibles
+size_t workerCount(size_t threads);
+
+// Límite de hilos de trabajo para el hilo actual mientras vive el objeto: workerCount() no pasa de 'limit'. Lo
+// fijan los hilos que ya forman parte de un conjunto (un ejecutor, los carriles de un lote) para que las
+// operaciones que ejecutan no lancen más hilos por su cuenta; con 1 las tareas se ejecutan en el propio hilo.
+class WorkerLimit {
+public:
+    explicit WorkerLimit(size_t limit);
+    ~WorkerLimit();
+    WorkerLimit(const WorkerLimit &) = delete;
+    WorkerLimit &operator=(const WorkerLimit &) = delete;
+
+private:
+    size_t previous_;
+};
+
+// Función para ejecutar 'task(i)' para i en [0, count) con hilos fijados a cada nodo NUMA. Cada nodo
+// recibe un tramo contiguo de índices, así que los segmentos vecinos de un archivo se procesan en el mismo nodo.
+// Los hilos salen de un conjunto persistente por nodo que se reutiliza entre llamadas, y quien llama trabaja
+// como uno más en el tramo del primer nodo.
+// Con un solo trabajador (por ejemplo, bajo un WorkerLimit de 1) las tareas se ejecutan en el hilo de quien llama.
+// Con 'workerBytes' (memoria de cada hilo) no se lanzan más hilos de los que caben en el límite de memoria, y
+// cada hilo prepara su buffer antes de tomar índices, siempre dentro del límite. Quien llama espera a tener el
+// suyo, y los ayudantes que no tienen sitio sin esperar no trabajan y los demás se reparten su parte. Una
+// llamada anidada (desde una tarea) usa el buffer y la reserva de la exterior en el mismo hilo, así que esa
+// tarea no debe conservar datos en su workerBuffer() durante la llamada.
+// Si una tarea devuelve false o lanza una excepción (que se muestra; por ejemplo, sin memoria para el buffer
+// del hilo) no se reparten más índices y devuelve false.
+bool parallelForNodes(size_t count, size_t threads, const std::function<bool(size_t)> &task,
+                      uint64_t workerBytes = 0);
+
+// Función para ejecutar 'task(i)' para i en [0, count) repartido entre los núcleos disponibles
+template<typename Task>
+bool parallelFor(size_t count, Task task, uint64_t workerBytes = 0) {
+    return parallelForNodes(count, 0, task, workerBytes);
+}
+
+// Función para obtener el límite de memoria del perfil activo (0 = sin límite)
+uint64_t memoryBudget();
+
+// Reserva de 'bytes' del límite de memoria mientras vive el objeto. Si no hay sitio espera a que otras
+// operaciones liberen el suyo (contrapresión); sin límite no hace nada. Con 'timeout' espera como mucho ese
+// tiempo y, si sigue sin sitio, no reserva nada y acquired() es false.
+class MemoryReservation {
+public:
+    explicit MemoryReservation(uint64_t bytes);
+    MemoryReservation(uint64_t bytes, std::chrono::milliseconds timeout);
+    ~MemoryReservation();
+    MemoryReservation(const MemoryReservation &) = delete;
+    MemoryReservation &operator=(const MemoryReservation &) = delete;
+
+    bool acquired() const { return acquired_; }
+
+private:
+    uint64_t bytes_;
+    bool acquired_ = true;
+};
+
+// Llave 'key_id' del almacén (la de 'entry') ya interpretada: se interpreta la primera vez que se pide y el
+// almacén la conserva hasta que se cierra. Devuelve nullptr si la llave no es válida.
+class Keystore;
+struct KeystoreEntry;
+enum class KeyType : uint8_t;
+EVP_PKEY *cachedKey(const Keystore &keystore, const std::string &key_id, const KeystoreEntry &entry);
+
+// Funciones para envolver la clave AES y el IV con una llave del almacén (RSA-OAEP o ECIES) y para
+// recuperarlos; devuelven false si la envoltura no corresponde a la llave
+bool wrapDataKey(EVP_PKEY *pkey, KeyType type, const unsigned char *key, const unsigned char *iv,
+                 std::vector<unsigned char> &wrapped);
+bool unwrapDataKey(EVP_PKEY *pkey, KeyType type, const unsigned char *wrapped, size_t len, unsigned char *key,
+                   unsigned char *iv);
+
+// Funciones para envolver la clave AES y el IV con la llave 'key_id' del almacén y para recuperarlos; muestran
+// el error (para 'path' al recuperarlos)
+bool wrapWithKeystore(const Keystore &keystore, const std::string &key_id, const unsigned char *key,
+                      const unsigned char *iv, std::vector<unsigned char> &wrapped);
+bool unwrapWithKeystore(const Keystore &keystore, const std::string &key_id,
+                        const std::vector<unsigned char> &wrapped, unsigned char *key, unsigned char *iv,
+                        const std::string &path);
+
+// Cabecera de un archivo con llave del almacén: los datos van en fragmentos de 'chunkSize' bytes autenticados
+// con AES-256-GCM
+struct KeyedHeader {
+    std::string keyId;
+    std::vector<unsigned char> wrapped; // clave AES e IV envueltos con la llave
+    uint64_t chunkSize = 0;
+    uint64_t plainSize = 0; // tamaño del contenido original
+    uint64_t dataOffset = 0; // posición de los datos cifrados
+};
+
+// Funciones del formato con llave: leer la cabecera, recuperar con el almacén la clave AES y el IV, y descifrar
+// los datos de un archivo cuya clave ya se recuperó (muestran el error para 'path')
+bool readKeyedHeader(std::istream &inputFile, KeyedHeader &header, const std::string &path);
+bool unwrapKeyed(const Keystore &keystore, const KeyedHeader &header, unsigned char *key, unsigned char *iv,
+                 const std::string &path);
+bool decryptKeyedPayload(const std::string &input_path, const KeyedHeader &header, const std::string &output_path,
+                         const unsigned char *key, const unsigned char *iv);
+
+// Variantes de encryptKeyed()/decryptKeyed() con los mensajes informativos según 'verbose'
+bool encryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore,
+                  const std::string &key_id, bool verbose);
+bool decryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore,
+                  bool verbose);
+
+// Funciones del formato RSA por partes: leer la llave privada una vez, crear un contexto OAEP (uno por hilo)
+// y desenvolver la clave y el IV de una cabecera ya leída (dos bloques de 'block_size' bytes)
+EVP_PKEY *readPrivateKey(const std::string &private_key_path);
+EVP_PKEY_CTX *newUnwrapContext(EVP_PKEY *evp_pkey);
+bool unwrapAESKeyAndIV(EVP_PKEY_CTX *ctx, size_t block_size, const unsigned char *wrapped, unsigned char *aes_key,
+                       unsigned char *iv);
+
+// Función para descifrar en memoria el resto de 'inputFile' con el flujo de claves del formato básico y
+// compararlo con 'originalFile'
+bool compareDecrypted(std::ifstream &inputFile, std::ifstream &originalFile, unsigned char *key, unsigned char *iv,
+                      const std::string &encrypted_path);
+
+// Función para descifrar los datos de un archivo a partir de 'data_offset' con la clave y el IV ya recuperados;
+// si falla se borra la salida
+bool decryptPayload(const std::string &input_path, uint64_t data_offset, const std::string &output_path,
+                    unsigned char *key, unsigned char *iv, bool verbose);
+
+// Función para ajustar un tamaño de bloque al límite de memoria
+size_t budgetedChunk(size_t chunk);
+
+// Función para limitar el número de hilos a los que caben en el límite con 'bytesPerWorker' cada uno
+size_t budgetedWorkers(size_t workers, uint64_t bytesPerWorker);
+
+// Función para comprobar que una operación que necesita 'bytes' en memoria cabe en el límite; si no,
+// muestra el error para 'path'
+bool fitsMemoryBudget(uint64_t bytes, const std::string &path);
+
+} // namespace enigmacore
+
+#endif // ENIGMACORE_INTERNAL_H
@@ -0,0 +1,427 @@
+#include "enigmacore/async.h"
+#include "enigmacore/keystore.h"
+#include "internal.h"
+
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace enigmacore {
+
+// ------------------------------------------------------------------------
+// Lector de JSON para las líneas del manifiesto
+// ------------------------------------------------------------------------
+// Cada línea es un objeto plano: claves de texto con valores de texto, número, true/false o null.
+
+// Función para añadir un punto de código Unicode a 'out' en UTF-8
+static void appendUtf8(std::string &out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xc0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xe0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    }
+}
+
+static void skipSpaces(const std::string &text, size_t &pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+}
+
+// Función para leer 4 dígitos hexadecimales de un escape \uXXXX
+static bool readHex4(const std::string &text, size_t &pos, uint32_t &code) {
+    if (pos + 4 > text.size()) return false;
+    code = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = text[pos++];
+        code <<= 4;
+        if (c >= '0' && c <= '9') code |= c - '0';
+        else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+// Función para leer una cadena JSON; 'pos' apunta a las comillas de apertura
+static bool parseJsonString(const std::string &text, size_t &pos, std::string &out) {
+    if (pos >= text.size() || text[pos] != '"') return false;
+    ++pos;
+    out.clear();
+    while (pos < text.size()) {
+        char c = text[pos++];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (pos >= text.size()) return false;
+        char escape = text[pos++];
+        switch (escape) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!readHex4(text, pos, code)) return false;
+                // Pares sustitutos de UTF-16
+                if (code >= 0xd800 && code < 0xdc00) {
+                    uint32_t low;
+                    if (text.compare(pos, 2, "\\u") != 0) return false;
+                    pos += 2;
+                    if (!readHex4(text, pos, low) || low < 0xdc00 || low >= 0xe000) return false;
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+// Función para interpretar una línea del manifiesto; en caso de error deja la causa en 'error'
+static bool parseJsonObject(const std::string &text, std::map<std::string, std::string> &fields,
+                            std::string &error) {
+    size_t pos = 0;
+    skipSpaces(text, pos);
+    if (pos >= text.size() || text[pos] != '{') {
+        error = "se esperaba un objeto JSON";
+        return false;
+    }
+    ++pos;
+    skipSpaces(text, pos);
+    if (pos < text.size() && text[pos] == '}') return true;
+
+    while (pos < text.size()) {
+        std::string key, value;
+        skipSpaces(text, pos);
+        if (!parseJsonString(text, pos, key)) {
+            error = "clave no válida";
+            return false;
+        }
+        skipSpaces(text, pos);
+        if (pos >= text.size() || text[pos] != ':') {
+            error = "se esperaba ':' tras \"" + key + "\"";
+            return false;
+        }
+        ++pos;
+        skipSpaces(text, pos);
+        if (pos < text.size() && text[pos] == '"') {
+            if (!parseJsonString(text, pos, value)) {
+                error = "texto no válido en \"" + key + "\"";
+                return false;
+            }
+            fields[key] = value;
+        } else {
+            // Número, true, false o null: se guarda el texto tal cual (null se ignora)
+            size_t start = pos;
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '}' &&
+                   !std::isspace(static_cast<unsigned char>(text[pos])))
+                ++pos;
+            value = text.substr(start, pos - start);
+            if (value.empty() || value[0] == '{' || value[0] == '[') {
+                error = "valor no admitido en \"" + key + "\"";
+                return false;
+            }
+            if (value != "null") fields[key] = value;
+        }
+        skipSpaces(text, pos);
+        if (pos < text.size() && text[pos] == ',') {
+            ++pos;
+            continue;
+        }
+        if (pos < text.size() && text[pos] == '}') {
+            ++pos;
+            skipSpaces(text, pos);
+            if (pos != text.size()) {
+                error = "texto sobrante tras el objeto";
+                return false;
+            }
+            return true;
+        }
+        error = "se esperaba ',' o '}'";
+        return false;
+    }
+    error = "objeto incompleto";
+    return false;
+}
+
+// Función para escribir una cadena como texto JSON
+static std::string jsonQuote(const std::string &text) {
+    std::string out = "\"";
+    for (unsigned char c: text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out + "\"";
+}
+
+// ------------------------------------------------------------------------
+// Ejecución de los trabajos
+// ------------------------------------------------------------------------
+
+// Resultado de un trabajo, tal como se escribe en la línea JSONL
+struct BatchResult {
+    size_t line = 0;
+    std::map<std::string, std::string> fields;
+    bool ok = false;
+    std::string error;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    double queueMs = 0;
+    double runMs = 0;
+};
+
+// Función para componer la línea JSONL de un resultado
+static std::string formatResult(const BatchResult &result) {
+    std::ostringstream line;
+    line << "{\"line\":" << result.line;
+    for (const char *name: {"id", "op", "input", "output", "original", "key_id"}) {
+        auto it = result.fields.find(name);
+        if (it != result.fields.end()) line << ",\"" << name << "\":" << jsonQuote(it->second);
+    }
+    line << ",\"status\":\"" << (result.ok ? "ok" : "error") << "\"";
+    line << ",\"bytes_in\":" << result.bytesIn << ",\"bytes_out\":" << result.bytesOut;
+    line << std::fixed << std::setprecision(3) << ",\"queue_ms\":" << result.queueMs << ",\"ms\":" << result.runMs;
+    if (!result.ok) line << ",\"error\":" << jsonQuote(result.error);
+    line << "}";
+    return line.str();
+}
+
+// Función para obtener un campo del trabajo o una cadena vacía
+static std::string field(const std::map<std::string, std::string> &fields, const char *name) {
+    auto it = fields.find(name);
+    return it == fields.end() ? std::string() : it->second;
+}
+
+// Función para ejecutar un trabajo ya validado y rellenar su resultado. Los trabajos no muestran mensajes
+// informativos: mezclarían miles de líneas con los resultados.
+static void runJob(BatchResult &result, const BatchOptions &options, const Keystore &keystore) {
+    const std::string op = field(result.fields, "op");
+    const std::string input = field(result.fields, "input");
+    const std::string keyId = field(result.fields, "key_id");
+    std::string publicKey, privateKey;
+    if (!keyId.empty()) {
+        publicKey = (std::filesystem::path(options.keys_dir) / (keyId + ".pub.pem")).string();
+        privateKey = (std::filesystem::path(options.keys_dir) / (keyId + ".pem")).string();
+    }
+
+    result.bytesIn = pathSize(input);
+    try {
+        if (!keyId.empty() && !options.keystore.empty()) {
+            // Llaves del almacén, que se abrió una sola vez para todos los trabajos
+            const std::string output = field(result.fields, op == "verify" ? "original" : "output");
+            if (op == "encrypt") result.ok = encryptKeyed(input, output, keystore, keyId, false);
+            else if (op == "decrypt") result.ok = decryptKeyed(input, output, keystore, false);
+            else result.ok = verifyKeyed(input, output, keystore);
+            if (op != "verify") result.bytesOut = pathSize(output);
+        } else if (op == "encrypt") {
+            const std::string output = field(result.fields, "output");
+            result.ok = keyId.empty() ? encrypt(input, output, nullptr, false)
+                                      : encryptRSA(input, output, publicKey, false);
+            result.bytesOut = pathSize(output);
+        } else if (op == "decrypt") {
+            const std::string output = field(result.fields, "output");
+            result.ok = keyId.empty() ? decrypt(input, output, nullptr, false)
+                                      : decryptRSA(input, output, privateKey, false);
+            result.bytesOut = pathSize(output);
+        } else {
+            result.ok = verify(input, field(result.fields, "original"), privateKey);
+        }
+        if (!result.ok) result.error = op + " falló (ver stderr)";
+    } catch (const std::exception &e) {
+        result.ok = false;
+        result.error = e.what();
+    }
+}
+
+// Función para comprobar que el trabajo tiene los campos que necesita su operación
+static bool validateJob(const std::map<std::string, std::string> &fields, std::string &error) {
+    const std::string op = field(fields, "op");
+    if (op != "encrypt" && op != "decrypt" && op != "verify") {
+        error = "operación no válida: \"" + op + "\"";
+        return false;
+    }
+    if (field(fields, "input").empty()) {
+        error = "falta \"input\"";
+        return false;
+    }
+    const char *target = op == "verify" ? "original" : "output";
+    if (field(fields, target).empty()) {
+        error = std::string("falta \"") + target + "\"";
+        return false;
+    }
+    const std::string keyId = field(fields, "key_id");
+    if (keyId.find('/') != std::string::npos || keyId.find('\\') != std::string::npos || keyId == "..") {
+        error = "\"key_id\" no válido: " + keyId;
+        return false;
+    }
+    return true;
+}
+
+// Función para ejecutar los trabajos de un manifiesto JSONL. El manifiesto se lee línea a línea, de modo
+// que puede tener cualquier tamaño: como mucho hay unos pocos trabajos por hilo esperando en las colas.
+// Los archivos grandes van a una cola propia con menos hilos, para que no acaparen el conjunto de hilos
+// mientras esperan los archivos pequeños.
+bool runJobs(const std::string &manifest_path, const std::string &results_path, const BatchOptions &options) {
+    std::ifstream manifest(manifest_path);
+    if (!manifest) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el manifiesto: " << manifest_path << std::endl;
+        return false;
+    }
+
+    Keystore keystore;
+    if (!options.keystore.empty() && !keystore.open(options.keystore)) return false;
+
+    std::ofstream resultsFile;
+    std::ostream *results = &std::cout;
+    if (results_path != "-") {
+        createParentDirectory(results_path);
+        resultsFile.open(results_path);
+        if (!resultsFile) {
+            std::cerr << "❌ [ERROR] No se pudo crear el archivo de resultados: " << results_path << std::endl;
+            return false;
+        }
+        results = &resultsFile;
+    }
+
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    // Con límite de memoria, cada trabajo en curso necesita al menos dos bloques (los de verify); las
+    // colas se dimensionan a partir de los hilos que caben
+    threads = budgetedWorkers(threads, 2 * static_cast<uint64_t>(budgetedChunk(tuningProfile().chunk_size)));
+    size_t largeThreads = std::max<size_t>(1, threads / 4);
+    size_t smallThreads = std::max<size_t>(1, threads - largeThreads);
+    // Hilos de cada operación: los archivos pequeños se procesan en el propio hilo de su cola, y los grandes se
+    // reparten los hilos entre los que hay en curso. Sin límite cada trabajo lanzaría un hilo por CPU.
+    const size_t largeWorkers = std::max<size_t>(1, threads / largeThreads);
+
+    // Cada cola tiene su propio tope de trabajos pendientes: los archivos grandes esperando no ocupan los
+    // puestos de los pequeños
+    struct Lane {
+        size_t threads;
+        size_t workers;
+        size_t maxInFlight;
+        size_t inFlight;
+    };
+    Lane smallLane = {smallThreads, 1, smallThreads * 4, 0};
+    Lane largeLane = {largeThreads, largeWorkers, largeThreads * 4, 0};
+
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    size_t jobs = 0;
+    size_t failed = 0;
+    bool writeFailed = false;
+
+    // Escribe un resultado; se llama desde los hilos de trabajo
+    auto report = [&](const BatchResult &result) {
+        std::string line = formatResult(result);
+        std::lock_guard<std::mutex> lock(mutex);
+        *results << line << '\n';
+        if (!*results) writeFailed = true;
+        if (!result.ok) ++failed;
+    };
+    auto resultsFailed = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writeFailed;
+    };
+
+    {
+        // Los ejecutores se destruyen antes que el estado compartido, esperando a los trabajos encolados
+        Executor smallFiles(smallLane.threads);
+        Executor largeFiles(largeLane.threads);
+
+        std::string text;
+        size_t lineNumber = 0;
+        // Si no se pueden escribir los resultados no se lanzan más trabajos
+        while (!resultsFailed() && std::getline(manifest, text)) {
+            ++lineNumber;
+            if (text.find_first_not_of(" \t\r") == std::string::npos) continue; // línea vacía
+            ++jobs;
+
+            BatchResult result;
+            result.line = lineNumber;
+            if (!parseJsonObject(text, result.fields, result.error) || !validateJob(result.fields, result.error)) {
+                report(result);
+                continue;
+            }
+
+            // Limitar los trabajos pendientes de la cola para no cargar el manifiesto entero en memoria
+            bool large = pathSize(field(result.fields, "input")) >= options.large_file_size;
+            Lane &lane = large ? largeLane : smallLane;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotFree.wait(lock, [&] { return lane.inFlight < lane.maxInFlight; });
+                ++lane.inFlight;
+            }
+
+            auto queued = std::chrono::steady_clock::now();
+            (large ? largeFiles : smallFiles).post([&, &lane = lane, queued, result]() mutable {
+                auto start = std::chrono::steady_clock::now();
+                {
+                    WorkerLimit limit(lane.workers);
+                    runJob(result, options, keystore);
+                }
+                auto end = std::chrono::steady_clock::now();
+                result.queueMs = std::chrono::duration<double, std::milli>(start - queued).count();
+                result.runMs = std::chrono::duration<double, std::milli>(end - start).count();
+                report(result);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --lane.inFlight;
+                }
+                // Quien lee el manifiesto puede estar esperando en cualquiera de las dos colas
+                slotFree.notify_all();
+            });
+        }
+    }
+    results->flush();
+    if (resultsFile.is_open()) resultsFile.close();
+    if (writeFailed || !*results) {
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de resultados: " << results_path << std::endl;
+        return false;
+    }
+
+    // El resumen no se mezcla con los resultados cuando estos van a la salida estándar
+    if (isVerbose() && results != &std::cout) {
+        std::cout << "Jobs: " << jobs << ", failed: " << failed << ", peak RSS: " << formatBytes(peakRss())
+                << std::endl;
+    }
+    return failed == 0;
+}
+
+} // namespace enigmacore
@@ -0,0 +1,133 @@
+#include "internal.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/if_alg.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef SOL_ALG
+#define SOL_ALG 279
+#endif
+
+namespace enigmacore {
+
+// Tamaño de los pipes entre el archivo, el socket de operación y la salida
+const int kKernelPipeSize = 1 << 20;
+
+KernelCtr::KernelCtr(const unsigned char *key) {
+    tfm_ = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (tfm_ < 0) return;
+    sockaddr_alg addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.salg_family = AF_ALG;
+    std::strcpy(reinterpret_cast<char *>(addr.salg_type), "skcipher");
+    std::strcpy(reinterpret_cast<char *>(addr.salg_name), "ctr(aes)");
+    // Sin el algoritmo en el kernel (o sin AF_ALG) falla el bind o la clave y ready() es false
+    if (bind(tfm_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        setsockopt(tfm_, SOL_ALG, ALG_SET_KEY, key, 32) != 0) {
+        close(tfm_);
+        tfm_ = -1;
+    }
+}
+
+KernelCtr::~KernelCtr() {
+    if (tfm_ >= 0) close(tfm_);
+}
+
+// Socket de operación y pipes de un hilo, que se cierran al terminar
+struct KernelOperation {
+    int op = -1;
+    int toKernel[2] = {-1, -1};
+    int fromKernel[2] = {-1, -1};
+
+    ~KernelOperation() {
+        for (int fd: {op, toKernel[0], toKernel[1], fromKernel[0], fromKernel[1]}) {
+            if (fd >= 0) close(fd);
+        }
+    }
+};
+
+// Función para mover exactamente 'len' bytes con splice. Los pipes no bloquean: si uno se llena o se vacía
+// antes de tiempo la operación falla (y se vuelve a OpenSSL) en lugar de quedarse esperando.
+static bool spliceAll(int from, loff_t *fromOffset, int to, loff_t *toOffset, size_t len) {
+    while (len > 0) {
+        ssize_t moved = splice(from, fromOffset, to, toOffset, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (moved < 0 && errno == EINTR) continue;
+        if (moved <= 0) return false;
+        len -= static_cast<size_t>(moved);
+    }
+    return true;
+}
+
+// Función para empezar una petición en el socket de operación: la operación y el IV van en los mensajes de
+// control, y MSG_MORE indica que los datos llegan después con splice. En CTR cifrar y descifrar es la misma
+// operación.
+static bool startRequest(int op, const unsigned char *iv) {
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(af_alg_iv) + 16)];
+    std::memset(control, 0, sizeof(control));
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_OP;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
+    uint32_t operation = ALG_OP_ENCRYPT;
+    std::memcpy(CMSG_DATA(cmsg), &operation, sizeof(operation));
+
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_IV;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(af_alg_iv) + 16);
+    af_alg_iv *algIv = reinterpret_cast<af_alg_iv *>(CMSG_DATA(cmsg));
+    algIv->ivlen = 16;
+    std::memcpy(algIv->iv, iv, 16);
+
+    return sendmsg(op, &msg, MSG_MORE) == 0;
+}
+
+// Cada periodo cuesta un sendmsg y dos splice, porque el formato vuelve a empezar el contador cada 4 KB: con
+// AES-NI, OpenSSL en el proceso es más rápido. Este camino solo compensa si el kernel tiene registrado un
+// acelerador de cifrado (que AES-NI no es) o si los datos no deben pasar por la memoria del proceso.
+bool KernelCtr::crypt(int in, uint64_t input_offset, int out, uint64_t output_offset, uint64_t len,
+                      const unsigned char *iv, size_t period) const {
+    KernelOperation operation;
+    operation.op = accept4(tfm_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (operation.op < 0 || pipe2(operation.toKernel, O_CLOEXEC) != 0 ||
+        pipe2(operation.fromKernel, O_CLOEXEC) != 0) {
+        return false;
+    }
+    // Pipes más grandes para mover más datos por llamada; si el sistema no lo permite se usan los de 64 KB
+    fcntl(operation.toKernel[1], F_SETPIPE_SZ, kKernelPipeSize);
+    fcntl(operation.fromKernel[1], F_SETPIPE_SZ, kKernelPipeSize);
+    int capacity = std::min(fcntl(operation.toKernel[1], F_GETPIPE_SZ),
+                            fcntl(operation.fromKernel[1], F_GETPIPE_SZ));
+    // Se usa la mitad de la capacidad: los datos que no empiezan en un límite de página ocupan una página más
+    size_t batchSize = capacity > 0 ? static_cast<size_t>(capacity) / 2 / period * period : 0;
+    if (batchSize == 0) return false;
+
+    loff_t inputOffset = static_cast<loff_t>(input_offset);
+    loff_t outputOffset = static_cast<loff_t>(output_offset);
+    for (uint64_t done = 0; done < len;) {
+        size_t batch = static_cast<size_t>(std::min<uint64_t>(batchSize, len - done));
+        if (!spliceAll(in, &inputOffset, operation.toKernel[1], nullptr, batch)) return false;
+        // Una petición por periodo, porque el keystream vuelve a empezar en 'iv'
+        for (size_t sent = 0; sent < batch; sent += period) {
+            size_t step = std::min(period, batch - sent);
+            if (!startRequest(operation.op, iv) ||
+                !spliceAll(operation.toKernel[0], nullptr, operation.op, nullptr, step) ||
+                !spliceAll(operation.op, nullptr, operation.fromKernel[1], nullptr, step)) {
+                return false;
+            }
+        }
+        if (!spliceAll(operation.fromKernel[0], nullptr, out, &outputOffset, batch)) return false;
+        done += batch;
+    }
+    return true;
+}
+
+} // namespace enigmacore
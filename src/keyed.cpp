@@ -0,0 +1,519 @@
+#include "enigmacore/async.h"
+#include "enigmacore/keystore.h"
+#include "internal.h"
+
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <openssl/evp.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace enigmacore {
+
+// Formato con llave del almacén (enteros de 64 bits en little-endian):
+//   magic | longitud del id | id | longitud de la envoltura | envoltura | tamaño de fragmento | tamaño original |
+//   por fragmento: datos cifrados con AES-256-GCM y etiqueta (16) | resumen del contenido cifrado (32) y etiqueta (16)
+// El nonce de cada fragmento son los 4 primeros bytes del IV y su índice, y los datos asociados llevan los
+// tamaños y el índice: un fragmento no se puede mover, quitar ni añadir sin que falle la autenticación.
+const char kKeyedMagic[8] = {'E', 'N', 'I', 'G', 'K', 'E', 'Y', '2'};
+const uint64_t kMaxKeyIdSize = 1024;
+const uint64_t kMaxWrappedSize = 64 * 1024;
+// Tamaños de fragmento que se escriben y se aceptan al leer: los del perfil, entre 4 KB y kMaxChunkSize
+const uint64_t kMinKeyedChunkSize = 4096;
+const size_t kTagSize = 16;
+const size_t kDigestSize = 32;
+const unsigned char kChunkKind = 0;
+const unsigned char kDigestKind = 1;
+
+// Resumen SHA-256 de un fragmento
+struct ChunkDigest {
+    unsigned char bytes[kDigestSize];
+};
+
+bool readKeyedHeader(std::istream &inputFile, KeyedHeader &header, const std::string &path) {
+    char magic[sizeof(kKeyedMagic)];
+    uint64_t idLen = 0, wrappedLen = 0;
+    if (!inputFile.read(magic, sizeof(magic)) || std::memcmp(magic, kKeyedMagic, sizeof(magic)) != 0 ||
+        !readU64(inputFile, idLen) || idLen > kMaxKeyIdSize) {
+        std::cerr << "❌ [ERROR] El archivo no tiene el formato con llave del almacén: " << path << std::endl;
+        return false;
+    }
+    header.keyId.assign(static_cast<size_t>(idLen), '\0');
+    if (!inputFile.read(&header.keyId[0], static_cast<std::streamsize>(idLen)) || !readU64(inputFile, wrappedLen) ||
+        wrappedLen > kMaxWrappedSize) {
+        std::cerr << "❌ [ERROR] Archivo cifrado incompleto: " << path << std::endl;
+        return false;
+    }
+    header.wrapped.resize(static_cast<size_t>(wrappedLen));
+    if (!inputFile.read(reinterpret_cast<char *>(header.wrapped.data()), static_cast<std::streamsize>(wrappedLen)) ||
+        !readU64(inputFile, header.chunkSize) || !readU64(inputFile, header.plainSize)) {
+        std::cerr << "❌ [ERROR] Archivo cifrado incompleto: " << path << std::endl;
+        return false;
+    }
+    if (header.chunkSize < kMinKeyedChunkSize || header.chunkSize > kMaxChunkSize) {
+        std::cerr << "❌ [ERROR] Tamaño de fragmento no válido en la cabecera: " << path << std::endl;
+        return false;
+    }
+    header.dataOffset = static_cast<uint64_t>(inputFile.tellg());
+    return true;
+}
+
+bool wrapWithKeystore(const Keystore &keystore, const std::string &key_id, const unsigned char *key,
+                      const unsigned char *iv, std::vector<unsigned char> &wrapped) {
+    KeystoreEntry entry;
+    if (!keystore.find(key_id, entry)) {
+        std::cerr << "❌ [ERROR] La llave no está en el almacén: " << key_id << std::endl;
+        return false;
+    }
+    EVP_PKEY *pkey = cachedKey(keystore, key_id, entry);
+    if (!pkey || !wrapDataKey(pkey, entry.type, key, iv, wrapped)) {
+        std::cerr << "❌ [ERROR] Error encriptando la clave AES con la llave: " << key_id << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool unwrapWithKeystore(const Keystore &keystore, const std::string &key_id,
+                        const std::vector<unsigned char> &wrapped, unsigned char *key, unsigned char *iv,
+                        const std::string &path) {
+    KeystoreEntry entry;
+    if (!keystore.find(key_id, entry)) {
+        std::cerr << "❌ [ERROR] La llave no está en el almacén: " << key_id << std::endl;
+        return false;
+    }
+    EVP_PKEY *pkey = cachedKey(keystore, key_id, entry);
+    if (!pkey || !unwrapDataKey(pkey, entry.type, wrapped.data(), wrapped.size(), key, iv)) {
+        std::cerr << "❌ [ERROR] No se pudo desencriptar la clave AES con la llave " << key_id << ": " << path
+                << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool unwrapKeyed(const Keystore &keystore, const KeyedHeader &header, unsigned char *key, unsigned char *iv,
+                 const std::string &path) {
+    return unwrapWithKeystore(keystore, header.keyId, header.wrapped, key, iv, path);
+}
+
+// Función para leer la cabecera de un archivo con llave y recuperar la clave AES y el IV con el almacén
+static bool openKeyed(const std::string &path, const Keystore &keystore, KeyedHeader &header, unsigned char *key,
+                      unsigned char *iv) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << path << std::endl;
+        return false;
+    }
+    return readKeyedHeader(file, header, path) && unwrapKeyed(keystore, header, key, iv, path);
+}
+
+// ------------------------------------------------------------------------
+// Fragmentos autenticados
+// ------------------------------------------------------------------------
+
+static uint64_t chunkCount(const KeyedHeader &header) {
+    return header.plainSize / header.chunkSize + (header.plainSize % header.chunkSize != 0);
+}
+
+static size_t chunkLength(const KeyedHeader &header, uint64_t index) {
+    return static_cast<size_t>(std::min(header.chunkSize, header.plainSize - index * header.chunkSize));
+}
+
+static uint64_t chunkOffset(const KeyedHeader &header, uint64_t index) {
+    return header.dataOffset + index * (header.chunkSize + kTagSize);
+}
+
+// Posición del resumen cifrado, tras el último fragmento
+static uint64_t digestOffset(const KeyedHeader &header) {
+    return header.dataOffset + header.plainSize + chunkCount(header) * kTagSize;
+}
+
+// Función para comprobar que un archivo de 'fileSize' bytes tiene exactamente los fragmentos y el resumen que
+// anuncia su cabecera. Los tamaños de la cabecera no están autenticados: se comprueban sin desbordar antes de
+// usarlos para reservar memoria o repartir fragmentos.
+static bool chunksFitFile(const KeyedHeader &header, uint64_t fileSize) {
+    if (header.plainSize > fileSize || header.dataOffset > fileSize - header.plainSize) return false;
+    uint64_t rest = fileSize - header.plainSize - header.dataOffset;
+    uint64_t count = chunkCount(header);
+    return count <= rest / kTagSize && rest - count * kTagSize == kDigestSize + kTagSize;
+}
+
+// Función para cifrar o descifrar con AES-256-GCM el fragmento 'index' (o el resumen, según 'kind'). Al
+// descifrar, 'tag' es la etiqueta guardada y devuelve false si los datos no son auténticos. 'len' nunca pasa de
+// header.chunkSize, que readKeyedHeader y encryptKeyed limitan a kMaxChunkSize: cabe en el int de OpenSSL.
+static_assert(kMaxChunkSize <= static_cast<uint64_t>(INT_MAX), "un fragmento debe caber en un int");
+static bool gcmChunk(bool encrypting, const KeyedHeader &header, const unsigned char *key, const unsigned char *iv,
+                     uint64_t index, unsigned char kind, const unsigned char *in, size_t len, unsigned char *out,
+                     unsigned char *tag) {
+    // Un contexto por hilo, reutilizado entre fragmentos
+    thread_local std::unique_ptr<EVP_CIPHER_CTX, void (*)(EVP_CIPHER_CTX *)> holder(EVP_CIPHER_CTX_new(),
+                                                                                      EVP_CIPHER_CTX_free);
+    EVP_CIPHER_CTX *ctx = holder.get();
+
+    unsigned char nonce[12];
+    std::memcpy(nonce, iv, 4);
+    for (int i = 0; i < 8; ++i) nonce[4 + i] = static_cast<unsigned char>(index >> (56 - 8 * i));
+    unsigned char aad[3 * 8 + 1];
+    for (int i = 0; i < 8; ++i) {
+        aad[i] = static_cast<unsigned char>(header.chunkSize >> (8 * i));
+        aad[8 + i] = static_cast<unsigned char>(header.plainSize >> (8 * i));
+        aad[16 + i] = static_cast<unsigned char>(index >> (8 * i));
+    }
+    aad[24] = kind;
+
+    int outLen = 0;
+    unsigned char final[16];
+    bool ok = ctx && EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, nonce, encrypting ? 1 : 0) == 1 &&
+              EVP_CipherUpdate(ctx, nullptr, &outLen, aad, sizeof(aad)) == 1 &&
+              (len == 0 || EVP_CipherUpdate(ctx, out, &outLen, in, static_cast<int>(len)) == 1);
+    if (ok && !encrypting) ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, kTagSize, tag) == 1;
+    ok = ok && EVP_CipherFinal_ex(ctx, final, &outLen) == 1;
+    if (ok && encrypting) ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, kTagSize, tag) == 1;
+    return ok;
+}
+
+// Función para calcular el resumen del contenido: SHA-256 de los resúmenes de los fragmentos, de modo que
+// cada fragmento se puede resumir en paralelo
+static bool contentDigest(const std::vector<ChunkDigest> &digests, unsigned char *out) {
+    return EVP_Digest(digests.data(), digests.size() * sizeof(ChunkDigest), out, nullptr, EVP_sha256(), nullptr) == 1;
+}
+
+// Función para ejecutar 'task(index, buffer)' para cada fragmento. El buffer tiene sitio para dos fragmentos y
+// una etiqueta. Los archivos grandes se reparten entre 'threads' hilos (0 = los del perfil); los pequeños,
+// o con 'threads' = 1, se procesan en el hilo que llama.
+static bool forEachChunk(const KeyedHeader &header, size_t threads,
+                         const std::function<bool(uint64_t, unsigned char *)> &task) {
+    uint64_t count = chunkCount(header);
+    size_t bufferSize = 2 * static_cast<size_t>(std::min(header.chunkSize, header.plainSize)) + kTagSize;
+    if (threads == 1 || count < 2 || header.plainSize < kParallelFileSize) {
+        MemoryReservation reservation(bufferSize);
+        std::vector<unsigned char> buffer(bufferSize);
+        for (uint64_t index = 0; index < count; ++index) {
+            if (!task(index, buffer.data())) return false;
+        }
+        return true;
+    }
+    return parallelForNodes(static_cast<size_t>(count), threads, [&](size_t index) {
+        return task(index, workerBuffer(bufferSize));
+    }, bufferSize);
+}
+
+// Función para descifrar y autenticar los fragmentos de un archivo v2 sin escribir nada: 'visit' (opcional)
+// recibe cada fragmento ya autenticado. El resumen guardado siempre se autentica, y con 'checkDigest' además
+// se compara con el del contenido descifrado.
+static bool openChunks(const std::string &path, const KeyedHeader &header, const unsigned char *key,
+                       const unsigned char *iv, size_t threads, bool checkDigest,
+                       const std::function<bool(uint64_t, const unsigned char *, size_t)> &visit) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << path << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    // El tamaño delata un archivo truncado o con datos de más antes de leer nada
+    if (!chunksFitFile(header, static_cast<uint64_t>(st.st_size))) {
+        std::cerr << "❌ [ERROR] El tamaño del archivo cifrado no coincide con su cabecera: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<ChunkDigest> digests(checkDigest ? static_cast<size_t>(chunkCount(header)) : 0);
+    std::atomic<bool> forged{false};
+    bool ok = forEachChunk(header, threads, [&](uint64_t index, unsigned char *buffer) {
+        size_t len = chunkLength(header, index);
+        unsigned char *sealed = buffer;
+        unsigned char *plain = buffer + len + kTagSize;
+        if (!preadAll(fd, sealed, len + kTagSize, chunkOffset(header, index))) return false;
+        if (!gcmChunk(false, header, key, iv, index, kChunkKind, sealed, len, plain, sealed + len)) {
+            forged = true;
+            return false;
+        }
+        if (checkDigest && EVP_Digest(plain, len, digests[index].bytes, nullptr, EVP_sha256(), nullptr) != 1) {
+            return false;
+        }
+        return !visit || visit(index, plain, len);
+    });
+
+    unsigned char sealed[kDigestSize + kTagSize], stored[kDigestSize], computed[kDigestSize];
+    bool digestRead = ok && preadAll(fd, sealed, sizeof(sealed), digestOffset(header));
+    close(fd);
+    if (digestRead && !gcmChunk(false, header, key, iv, chunkCount(header), kDigestKind, sealed, kDigestSize, stored,
+                                sealed + kDigestSize)) {
+        forged = true;
+    }
+    if (forged) {
+        std::cerr << "❌ [ERROR] El archivo cifrado está dañado o fue modificado: " << path << std::endl;
+        return false;
+    }
+    if (!ok || !digestRead) {
+        // Los errores de la comparación con el original ya se mostraron
+        if (!visit) std::cerr << "❌ [ERROR] Error de lectura procesando: " << path << std::endl;
+        return false;
+    }
+    if (checkDigest && (!contentDigest(digests, computed) || std::memcmp(computed, stored, kDigestSize) != 0)) {
+        std::cerr << "❌ [ERROR] El resumen del contenido descifrado no coincide: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool decryptKeyedPayload(const std::string &input_path, const KeyedHeader &header, const std::string &output_path,
+                         const unsigned char *key, const unsigned char *iv) {
+    // El tamaño de la salida viene de la cabecera: se comprueba contra el archivo antes de crearla
+    struct stat st;
+    if (stat(input_path.c_str(), &st) != 0 || !chunksFitFile(header, static_cast<uint64_t>(st.st_size))) {
+        std::cerr << "❌ [ERROR] El tamaño del archivo cifrado no coincide con su cabecera: " << input_path
+                << std::endl;
+        return false;
+    }
+    createParentDirectory(output_path);
+    int out = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0 || ftruncate(out, static_cast<off_t>(header.plainSize)) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        if (out >= 0) close(out);
+        return false;
+    }
+    bool ok = openChunks(input_path, header, key, iv, 0, false,
+                         [&](uint64_t index, const unsigned char *plain, size_t len) {
+                             if (pwriteAll(out, plain, len, index * header.chunkSize)) return true;
+                             std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path
+                                     << std::endl;
+                             return false;
+                         });
+    if (close(out) != 0) ok = false;
+    if (!ok) {
+        // Nunca se deja un descifrado a medias ni con datos sin autenticar
+        std::error_code ec;
+        std::filesystem::remove(output_path, ec);
+    }
+    return ok;
+}
+
+// ------------------------------------------------------------------------
+// Operaciones con archivos
+// ------------------------------------------------------------------------
+
+// Función para cifrar un archivo con una llave del almacén: los fragmentos se leen, resumen, cifran y escriben
+// en su posición en paralelo
+bool encryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore,
+                  const std::string &key_id) {
+    return encryptKeyed(input_path, output_path, keystore, key_id, isVerbose());
+}
+
+bool encryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore,
+                  const std::string &key_id, bool verbose) {
+    if (verbose) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+    unsigned char key[32], iv[16];
+    if (!randomBytes(key, sizeof(key)) || !randomBytes(iv, sizeof(iv))) return false;
+    KeyedHeader header;
+    header.keyId = key_id;
+    if (!wrapWithKeystore(keystore, key_id, key, iv, header.wrapped)) return false;
+
+    int in = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (in < 0 || fstat(in, &st) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        if (in >= 0) close(in);
+        return false;
+    }
+    header.chunkSize = std::min(std::max<uint64_t>(budgetedChunk(tuningProfile().chunk_size), kMinKeyedChunkSize),
+                                kMaxChunkSize);
+    header.plainSize = static_cast<uint64_t>(st.st_size);
+
+    std::ostringstream head;
+    head.write(kKeyedMagic, sizeof(kKeyedMagic));
+    writeU64(head, header.keyId.size());
+    head << header.keyId;
+    writeU64(head, header.wrapped.size());
+    head.write(reinterpret_cast<const char *>(header.wrapped.data()),
+               static_cast<std::streamsize>(header.wrapped.size()));
+    writeU64(head, header.chunkSize);
+    writeU64(head, header.plainSize);
+    std::string headBytes = head.str();
+    header.dataOffset = headBytes.size();
+
+    createParentDirectory(output_path);
+    int out = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        close(in);
+        return false;
+    }
+    posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<ChunkDigest> digests(static_cast<size_t>(chunkCount(header)));
+    bool ok = pwriteAll(out, reinterpret_cast<const unsigned char *>(headBytes.data()), headBytes.size(), 0) &&
+              forEachChunk(header, 0, [&](uint64_t index, unsigned char *buffer) {
+                  size_t len = chunkLength(header, index);
+                  unsigned char *plain = buffer;
+                  unsigned char *sealed = buffer + len;
+                  return preadAll(in, plain, len, index * header.chunkSize) &&
+                         EVP_Digest(plain, len, digests[index].bytes, nullptr, EVP_sha256(), nullptr) == 1 &&
+                         gcmChunk(true, header, key, iv, index, kChunkKind, plain, len, sealed, sealed + len) &&
+                         pwriteAll(out, sealed, len + kTagSize, chunkOffset(header, index));
+              });
+    unsigned char digest[kDigestSize], sealed[kDigestSize + kTagSize];
+    ok = ok && contentDigest(digests, digest) &&
+         gcmChunk(true, header, key, iv, chunkCount(header), kDigestKind, digest, kDigestSize, sealed,
+                  sealed + kDigestSize) &&
+         pwriteAll(out, sealed, sizeof(sealed), digestOffset(header));
+    close(in);
+    if (close(out) != 0) ok = false;
+    if (!ok) {
+        std::cerr << "❌ [ERROR] Error de lectura/escritura procesando: " << input_path << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(output_path, ec);
+        return false;
+    }
+
+    if (verbose) {
+        std::cout << std::endl;
+        std::cout << "Encrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para descifrar un archivo con llave: el identificador de la llave va en la cabecera
+bool decryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore) {
+    return decryptKeyed(input_path, output_path, keystore, isVerbose());
+}
+
+bool decryptKeyed(const std::string &input_path, const std::string &output_path, const Keystore &keystore,
+                  bool verbose) {
+    if (verbose) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+    KeyedHeader header;
+    unsigned char key[32], iv[16];
+    if (!openKeyed(input_path, keystore, header, key, iv)) return false;
+    if (!decryptKeyedPayload(input_path, header, output_path, key, iv)) return false;
+
+    if (verbose) {
+        std::cout << std::endl;
+        std::cout << "Decrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para comprobar un archivo con llave frente a su original
+bool verifyKeyed(const std::string &encrypted_path, const std::string &original_path, const Keystore &keystore) {
+    KeyedHeader header;
+    unsigned char key[32], iv[16];
+    if (!openKeyed(encrypted_path, keystore, header, key, iv)) return false;
+
+    int original = open(original_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (original < 0 || fstat(original, &st) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << original_path << std::endl;
+        if (original >= 0) close(original);
+        return false;
+    }
+    bool ok = static_cast<uint64_t>(st.st_size) == header.plainSize &&
+              openChunks(encrypted_path, header, key, iv, 0, false,
+                         [&](uint64_t index, const unsigned char *plain, size_t len) {
+                             // El original se compara por tramos, sin reservar otro fragmento
+                             unsigned char expected[64 * 1024];
+                             for (size_t done = 0; done < len;) {
+                                 size_t step = std::min(sizeof(expected), len - done);
+                                 if (!preadAll(original, expected, step, index * header.chunkSize + done) ||
+                                     std::memcmp(expected, plain + done, step) != 0) {
+                                     return false;
+                                 }
+                                 done += step;
+                             }
+                             return true;
+                         });
+    close(original);
+    if (!ok) {
+        std::cerr << "❌ [ERROR] El contenido descifrado no coincide con el original: " << encrypted_path << std::endl;
+    }
+    return ok;
+}
+
+// Función para comprobar la integridad de un archivo con 'chunkThreads' hilos para sus fragmentos
+static bool verifyIntegrityWith(const std::string &encrypted_path, const Keystore &keystore, bool check_digest,
+                                size_t chunkThreads) {
+    KeyedHeader header;
+    unsigned char key[32], iv[16];
+    if (!openKeyed(encrypted_path, keystore, header, key, iv)) return false;
+    return openChunks(encrypted_path, header, key, iv, chunkThreads, check_digest, nullptr);
+}
+
+bool verifyIntegrity(const std::string &encrypted_path, const Keystore &keystore, bool check_digest) {
+    return verifyIntegrityWith(encrypted_path, keystore, check_digest, 0);
+}
+
+// Función para auditar muchos archivos: cada hilo comprueba un archivo y, si hay menos archivos que hilos,
+// los que sobran se reparten los fragmentos de cada archivo
+bool auditFiles(const std::vector<std::string> &paths, const Keystore &keystore, const AuditOptions &options) {
+    std::vector<std::string> files;
+    for (const std::string &path: paths) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(path, ec)) {
+            files.push_back(path);
+            continue;
+        }
+        for (const auto &entry: std::filesystem::recursive_directory_iterator(path, ec)) {
+            std::string name = entry.path().filename().string();
+            if (entry.is_regular_file(ec) && !name.empty() && name[0] != '.') files.push_back(entry.path().string());
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "❌ [ERROR] No hay archivos que comprobar" << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t workers = workerCount(options.threads);
+    size_t fileThreads = std::min(workers, files.size());
+    size_t chunkThreads = std::max<size_t>(1, workers / fileThreads);
+    const size_t maxInFlight = fileThreads * 4;
+
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    size_t inFlight = 0;
+    std::atomic<size_t> failed{0};
+    std::atomic<uint64_t> bytes{0};
+    {
+        Executor executor(fileThreads);
+        for (const std::string &file: files) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotFree.wait(lock, [&] { return inFlight < maxInFlight; });
+                ++inFlight;
+            }
+            executor.post([&, file] {
+                if (verifyIntegrityWith(file, keystore, options.check_digest, chunkThreads)) bytes += pathSize(file);
+                else ++failed;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --inFlight;
+                }
+                slotFree.notify_one();
+            });
+        }
+    }
+
+    if (isVerbose()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Verified " << files.size() - failed << " of " << files.size() << " files ("
+                << formatBytes(bytes) << ") in " << formatDuration(seconds) << ", failed: " << failed;
+        if (seconds > 0) std::cout << ", " << formatBytes(static_cast<uint64_t>(bytes / seconds)) << "/s";
+        std::cout << std::endl;
+    }
+    return failed == 0;
+}
+
+} // namespace enigmacore
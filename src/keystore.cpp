@@ -0,0 +1,395 @@
+#include "enigmacore/keystore.h"
+#include "internal.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace enigmacore {
+
+// Formato del almacén (enteros de 64 bits en little-endian):
+//   magic | número de llaves | número de huecos de la tabla (potencia de dos)
+//   tabla hash: por hueco, el hash del identificador y la posición de su registro (0 = hueco vacío)
+//   registros: longitud del id | tipo | longitud DER pública | longitud DER privada | id | DER pública | DER privada
+const char kKeystoreMagic[8] = {'E', 'N', 'I', 'G', 'K', 'S', 'T', 'R'};
+const size_t kKeystoreHeaderSize = sizeof(kKeystoreMagic) + 2 * 8;
+const size_t kKeystoreSlotSize = 2 * 8;
+const size_t kKeystoreRecordHeaderSize = 4 * 8;
+
+// Texto de contexto de la derivación de la clave de envoltura ECIES
+const char kEciesInfo[] = "enigmacore-keyed-v1";
+
+// Función para leer un entero de 64 bits en little-endian de la proyección
+static uint64_t loadU64(const unsigned char *data) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | data[i];
+    return value;
+}
+
+// Función para añadir un entero de 64 bits en little-endian
+static void appendU64(std::string &out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+// Hash FNV-1a de 64 bits del identificador
+static uint64_t keyIdHash(const std::string &key_id) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c: key_id) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Función para generar un par de llaves y serializarlo como registro del almacén
+static bool generateRecord(const std::string &key_id, const KeygenOptions &options, std::string &record) {
+    EVP_PKEY *pkey = options.type == KeyType::RSA
+                         ? EVP_PKEY_Q_keygen(nullptr, nullptr, "RSA", static_cast<size_t>(options.rsa_bits))
+                         : EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", options.curve.c_str());
+    if (!pkey) return false;
+
+    unsigned char *publicDer = nullptr;
+    unsigned char *privateDer = nullptr;
+    int publicLen = i2d_PUBKEY(pkey, &publicDer);
+    int privateLen = i2d_PrivateKey(pkey, &privateDer);
+    bool ok = publicLen > 0 && privateLen > 0;
+    if (ok) {
+        appendU64(record, key_id.size());
+        appendU64(record, static_cast<uint64_t>(options.type));
+        appendU64(record, static_cast<uint64_t>(publicLen));
+        appendU64(record, static_cast<uint64_t>(privateLen));
+        record += key_id;
+        record.append(reinterpret_cast<char *>(publicDer), publicLen);
+        record.append(reinterpret_cast<char *>(privateDer), privateLen);
+    }
+    OPENSSL_free(publicDer);
+    OPENSSL_free(privateDer);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+bool generateKeystore(const std::string &path, size_t count, const KeygenOptions &options) {
+    if (count == 0 || (options.type == KeyType::RSA && options.rsa_bits < 2048)) {
+        std::cerr << "❌ [ERROR] Parámetros de generación no válidos (al menos una llave, RSA de 2048 bits o más)"
+                << std::endl;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // La generación (sobre todo la de RSA) es lo costoso: cada hilo genera y serializa sus llaves
+    std::vector<std::string> records(count);
+    if (!parallelForNodes(count, options.threads, [&](size_t index) {
+        return generateRecord(options.prefix + std::to_string(index), options, records[index]);
+    })) {
+        std::cerr << "❌ [ERROR] No se pudieron generar las llaves "
+                << (options.type == KeyType::RSA ? "RSA de " + std::to_string(options.rsa_bits) + " bits"
+                                                 : "EC (¿curva no soportada?): " + options.curve) << std::endl;
+        return false;
+    }
+
+    // Tabla con al menos el doble de huecos que llaves, para que las búsquedas sondeen pocos huecos
+    uint64_t slots = 1;
+    while (slots < 2 * static_cast<uint64_t>(count)) slots <<= 1;
+    std::vector<unsigned char> table(slots * kKeystoreSlotSize, 0);
+    uint64_t offset = kKeystoreHeaderSize + table.size();
+    for (size_t index = 0; index < count; ++index) {
+        uint64_t hash = keyIdHash(options.prefix + std::to_string(index));
+        uint64_t slot = hash & (slots - 1);
+        while (loadU64(&table[slot * kKeystoreSlotSize + 8]) != 0) slot = (slot + 1) & (slots - 1);
+        for (int i = 0; i < 8; ++i) {
+            table[slot * kKeystoreSlotSize + i] = static_cast<unsigned char>(hash >> (8 * i));
+            table[slot * kKeystoreSlotSize + 8 + i] = static_cast<unsigned char>(offset >> (8 * i));
+        }
+        offset += records[index].size();
+    }
+
+    std::string header(kKeystoreMagic, sizeof(kKeystoreMagic));
+    appendU64(header, count);
+    appendU64(header, slots);
+
+    // Se escribe en un temporal creado con permisos 0600 y se renombra al terminar
+    createParentDirectory(path);
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = fd >= 0;
+    uint64_t position = 0;
+    auto write = [&](const unsigned char *data, size_t len) {
+        ok = ok && pwriteAll(fd, data, len, position);
+        position += len;
+    };
+    write(reinterpret_cast<const unsigned char *>(header.data()), header.size());
+    write(table.data(), table.size());
+    for (const std::string &record: records) {
+        write(reinterpret_cast<const unsigned char *>(record.data()), record.size());
+    }
+    if (fd >= 0 && (fsync(fd) != 0 || close(fd) != 0)) ok = false;
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temp, path, ec);
+    if (!ok || ec) {
+        std::cerr << "❌ [ERROR] No se pudo escribir el almacén de claves: " << path << std::endl;
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    if (isVerbose()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Generated " << count << " "
+                << (options.type == KeyType::RSA ? "RSA-" + std::to_string(options.rsa_bits) : "EC " + options.curve)
+                << " keys in " << formatDuration(seconds) << " -> " << path << std::endl;
+    }
+    return true;
+}
+
+// Llaves interpretadas con d2i_AutoPrivateKey: la llave privada sirve también para envolver
+struct Keystore::KeyCache {
+    std::mutex mutex;
+    std::unordered_map<std::string, EVP_PKEY *> keys;
+
+    ~KeyCache() { clear(); }
+
+    void clear() {
+        for (auto &item: keys) EVP_PKEY_free(item.second);
+        keys.clear();
+    }
+};
+
+Keystore::Keystore() : keys_(new KeyCache) {
+}
+
+Keystore::~Keystore() {
+    if (data_) munmap(const_cast<unsigned char *>(data_), mappedSize_);
+}
+
+bool Keystore::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el almacén de claves: " << path << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *map = size >= kKeystoreHeaderSize ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    const unsigned char *data = map == MAP_FAILED ? nullptr : static_cast<const unsigned char *>(map);
+
+    uint64_t count = data ? loadU64(data + sizeof(kKeystoreMagic)) : 0;
+    uint64_t slots = data ? loadU64(data + sizeof(kKeystoreMagic) + 8) : 0;
+    if (!data || std::memcmp(data, kKeystoreMagic, sizeof(kKeystoreMagic)) != 0 || slots == 0 ||
+        (slots & (slots - 1)) != 0 || count > slots || slots > (size - kKeystoreHeaderSize) / kKeystoreSlotSize) {
+        std::cerr << "❌ [ERROR] El archivo no es un almacén de claves válido: " << path << std::endl;
+        if (data) munmap(map, size);
+        return false;
+    }
+    // Se consulta por huecos sueltos de la tabla, no en orden
+    madvise(map, size, MADV_RANDOM);
+
+    if (data_) munmap(const_cast<unsigned char *>(data_), mappedSize_);
+    keys_->clear();
+    data_ = data;
+    mappedSize_ = size;
+    count_ = count;
+    slots_ = slots;
+    return true;
+}
+
+bool Keystore::find(const std::string &key_id, KeystoreEntry &entry) const {
+    if (!data_) return false;
+    uint64_t hash = keyIdHash(key_id);
+    uint64_t slot = hash & (slots_ - 1);
+    for (uint64_t probe = 0; probe < slots_; ++probe, slot = (slot + 1) & (slots_ - 1)) {
+        const unsigned char *item = data_ + kKeystoreHeaderSize + slot * kKeystoreSlotSize;
+        uint64_t offset = loadU64(item + 8);
+        if (offset == 0) return false;
+        if (loadU64(item) != hash) continue;
+
+        // Comprobar que el registro está entero dentro del archivo antes de leerlo
+        if (offset > mappedSize_ || mappedSize_ - offset < kKeystoreRecordHeaderSize) return false;
+        const unsigned char *record = data_ + offset;
+        uint64_t idLen = loadU64(record);
+        uint64_t type = loadU64(record + 8);
+        uint64_t publicLen = loadU64(record + 16);
+        uint64_t privateLen = loadU64(record + 24);
+        uint64_t available = mappedSize_ - offset - kKeystoreRecordHeaderSize;
+        if (idLen > available || publicLen > available - idLen || privateLen > available - idLen - publicLen)
+            return false;
+        const unsigned char *id = record + kKeystoreRecordHeaderSize;
+        if (idLen != key_id.size() || std::memcmp(id, key_id.data(), idLen) != 0) continue;
+        if (type != static_cast<uint64_t>(KeyType::RSA) && type != static_cast<uint64_t>(KeyType::EC)) return false;
+
+        entry.type = static_cast<KeyType>(type);
+        entry.public_der = ByteSpan(id + idLen, static_cast<size_t>(publicLen));
+        entry.private_der = ByteSpan(id + idLen + publicLen, static_cast<size_t>(privateLen));
+        return true;
+    }
+    return false;
+}
+
+EVP_PKEY *cachedKey(const Keystore &keystore, const std::string &key_id, const KeystoreEntry &entry) {
+    Keystore::KeyCache &cache = *keystore.keys_;
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto found = cache.keys.find(key_id);
+        if (found != cache.keys.end()) return found->second;
+    }
+    // Se interpreta fuera del bloqueo; si otro hilo se adelantó, se queda la suya
+    const unsigned char *der = entry.private_der.data;
+    EVP_PKEY *pkey = d2i_AutoPrivateKey(nullptr, &der, static_cast<long>(entry.private_der.size));
+    if (!pkey) return nullptr;
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto inserted = cache.keys.emplace(key_id, pkey);
+    if (!inserted.second) EVP_PKEY_free(pkey);
+    return inserted.first->second;
+}
+
+// ------------------------------------------------------------------------
+// Envoltura de la clave de datos
+// ------------------------------------------------------------------------
+
+// Función para derivar la clave de envoltura ECIES (HKDF-SHA256 del secreto ECDH, con el punto efímero como sal)
+static bool deriveWrapKey(const std::vector<unsigned char> &secret, const unsigned char *point, size_t pointLen,
+                          unsigned char *kek) {
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+    size_t outlen = 32;
+    bool ok = ctx && EVP_PKEY_derive_init(ctx) > 0 && EVP_PKEY_CTX_set_hkdf_md(ctx, EVP_sha256()) > 0 &&
+              EVP_PKEY_CTX_set1_hkdf_key(ctx, secret.data(), static_cast<int>(secret.size())) > 0 &&
+              EVP_PKEY_CTX_set1_hkdf_salt(ctx, point, static_cast<int>(pointLen)) > 0 &&
+              EVP_PKEY_CTX_add1_hkdf_info(ctx, reinterpret_cast<const unsigned char *>(kEciesInfo),
+                                          sizeof(kEciesInfo) - 1) > 0 &&
+              EVP_PKEY_derive(ctx, kek, &outlen) > 0 && outlen == 32;
+    EVP_PKEY_CTX_free(ctx);
+    return ok;
+}
+
+// Función para calcular el secreto ECDH entre una llave propia y la del otro extremo
+static bool ecdh(EVP_PKEY *own, EVP_PKEY *peer, std::vector<unsigned char> &secret) {
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(own, nullptr);
+    size_t len = 0;
+    bool ok = ctx && EVP_PKEY_derive_init(ctx) > 0 && EVP_PKEY_derive_set_peer(ctx, peer) > 0 &&
+              EVP_PKEY_derive(ctx, nullptr, &len) > 0;
+    if (ok) {
+        secret.resize(len);
+        ok = EVP_PKEY_derive(ctx, secret.data(), &len) > 0;
+        secret.resize(len);
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return ok;
+}
+
+// Función para cifrar o descifrar con AES-256-GCM los 48 bytes de clave e IV
+static bool gcmCrypt(bool encrypting, const unsigned char *kek, const unsigned char *nonce, const unsigned char *in,
+                     unsigned char *out, unsigned char *tag) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int len = 0;
+    bool ok = ctx && EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), nullptr, kek, nonce, encrypting ? 1 : 0) == 1 &&
+              EVP_CipherUpdate(ctx, out, &len, in, 48) == 1;
+    if (ok && !encrypting) ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16, tag) == 1;
+    ok = ok && EVP_CipherFinal_ex(ctx, out + len, &len) == 1;
+    if (ok && encrypting) ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, tag) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+// Función para crear el contexto RSA-OAEP de una llave
+static EVP_PKEY_CTX *oaepContext(EVP_PKEY *pkey, bool encrypting) {
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(pkey, nullptr);
+    if (ctx && (encrypting ? EVP_PKEY_encrypt_init(ctx) : EVP_PKEY_decrypt_init(ctx)) > 0 &&
+        EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) > 0) {
+        return ctx;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return nullptr;
+}
+
+// Envoltura RSA: OAEP de clave||IV. Envoltura EC (ECIES): longitud del punto efímero (1 byte) | punto |
+// nonce (12) | etiqueta GCM (16) | clave||IV cifrados con AES-256-GCM (48)
+bool wrapDataKey(EVP_PKEY *pkey, KeyType type, const unsigned char *key, const unsigned char *iv,
+                 std::vector<unsigned char> &wrapped) {
+    unsigned char plain[48];
+    std::memcpy(plain, key, 32);
+    std::memcpy(plain + 32, iv, 16);
+    bool ok = false;
+    if (type == KeyType::RSA) {
+        EVP_PKEY_CTX *ctx = oaepContext(pkey, true);
+        wrapped.resize(static_cast<size_t>(EVP_PKEY_size(pkey)));
+        size_t outlen = wrapped.size();
+        ok = ctx && EVP_PKEY_encrypt(ctx, wrapped.data(), &outlen, plain, sizeof(plain)) > 0;
+        wrapped.resize(outlen);
+        EVP_PKEY_CTX_free(ctx);
+    } else {
+        // Llave efímera en la misma curva que la del destinatario
+        EVP_PKEY *ephemeral = nullptr;
+        EVP_PKEY_CTX *keygen = EVP_PKEY_CTX_new(pkey, nullptr);
+        std::vector<unsigned char> secret;
+        unsigned char *point = nullptr;
+        size_t pointLen = 0;
+        unsigned char kek[32], nonce[12], tag[16], sealed[48];
+        ok = keygen && EVP_PKEY_keygen_init(keygen) > 0 && EVP_PKEY_keygen(keygen, &ephemeral) > 0 &&
+             ecdh(ephemeral, pkey, secret) && (pointLen = EVP_PKEY_get1_encoded_public_key(ephemeral, &point)) > 0 &&
+             pointLen < 256 && deriveWrapKey(secret, point, pointLen, kek) &&
+             RAND_bytes(nonce, sizeof(nonce)) == 1 && gcmCrypt(true, kek, nonce, plain, sealed, tag);
+        if (ok) {
+            wrapped.assign(1, static_cast<unsigned char>(pointLen));
+            wrapped.insert(wrapped.end(), point, point + pointLen);
+            wrapped.insert(wrapped.end(), nonce, nonce + sizeof(nonce));
+            wrapped.insert(wrapped.end(), tag, tag + sizeof(tag));
+            wrapped.insert(wrapped.end(), sealed, sealed + sizeof(sealed));
+        }
+        OPENSSL_cleanse(kek, sizeof(kek));
+        OPENSSL_cleanse(secret.data(), secret.size());
+        OPENSSL_free(point);
+        EVP_PKEY_free(ephemeral);
+        EVP_PKEY_CTX_free(keygen);
+    }
+    OPENSSL_cleanse(plain, sizeof(plain));
+    return ok;
+}
+
+bool unwrapDataKey(EVP_PKEY *pkey, KeyType type, const unsigned char *wrapped, size_t len, unsigned char *key,
+                   unsigned char *iv) {
+    unsigned char plain[48];
+    bool ok = false;
+    if (type == KeyType::RSA) {
+        // OpenSSL 3 exige que el buffer de salida tenga el tamaño del módulo RSA
+        EVP_PKEY_CTX *ctx = oaepContext(pkey, false);
+        std::vector<unsigned char> decrypted(static_cast<size_t>(EVP_PKEY_size(pkey)));
+        size_t outlen = decrypted.size();
+        ok = ctx && EVP_PKEY_decrypt(ctx, decrypted.data(), &outlen, wrapped, len) > 0 && outlen == sizeof(plain);
+        if (ok) std::memcpy(plain, decrypted.data(), sizeof(plain));
+        OPENSSL_cleanse(decrypted.data(), decrypted.size());
+        EVP_PKEY_CTX_free(ctx);
+    } else if (len > 0 && len == 1 + static_cast<size_t>(wrapped[0]) + 12 + 16 + 48) {
+        size_t pointLen = wrapped[0];
+        const unsigned char *point = wrapped + 1;
+        const unsigned char *nonce = point + pointLen;
+        unsigned char tag[16];
+        std::memcpy(tag, nonce + 12, sizeof(tag));
+        EVP_PKEY *ephemeral = EVP_PKEY_new();
+        std::vector<unsigned char> secret;
+        unsigned char kek[32];
+        ok = ephemeral && EVP_PKEY_copy_parameters(ephemeral, pkey) > 0 &&
+             EVP_PKEY_set1_encoded_public_key(ephemeral, point, pointLen) > 0 && ecdh(pkey, ephemeral, secret) &&
+             deriveWrapKey(secret, point, pointLen, kek) && gcmCrypt(false, kek, nonce, nonce + 28, plain, tag);
+        OPENSSL_cleanse(kek, sizeof(kek));
+        OPENSSL_cleanse(secret.data(), secret.size());
+        EVP_PKEY_free(ephemeral);
+    }
+    if (ok) {
+        std::memcpy(key, plain, 32);
+        std::memcpy(iv, plain + 32, 16);
+    }
+    OPENSSL_cleanse(plain, sizeof(plain));
+    return ok;
+}
+
+} // namespace enigmacore
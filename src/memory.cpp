@@ -0,0 +1,78 @@
+#include "internal.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <sys/resource.h>
+
+namespace enigmacore {
+
+// Bytes reservados ahora mismo por los buffers de todas las operaciones en curso
+static std::mutex budgetMutex;
+static std::condition_variable budgetFreed;
+static uint64_t reservedBytes = 0;
+
+uint64_t memoryBudget() {
+    return tuningProfile().max_memory;
+}
+
+MemoryReservation::MemoryReservation(uint64_t bytes) : bytes_(0) {
+    uint64_t budget = memoryBudget();
+    if (!budget || !bytes) return;
+    // Una reserva mayor que el límite entero esperaría para siempre: se limita al límite
+    bytes_ = std::min(bytes, budget);
+    std::unique_lock<std::mutex> lock(budgetMutex);
+    budgetFreed.wait(lock, [&] { return reservedBytes + bytes_ <= budget; });
+    reservedBytes += bytes_;
+}
+
+MemoryReservation::MemoryReservation(uint64_t bytes, std::chrono::milliseconds timeout) : bytes_(0) {
+    uint64_t budget = memoryBudget();
+    if (!budget || !bytes) return;
+    uint64_t wanted = std::min(bytes, budget);
+    std::unique_lock<std::mutex> lock(budgetMutex);
+    if (!budgetFreed.wait_for(lock, timeout, [&] { return reservedBytes + wanted <= budget; })) {
+        acquired_ = false;
+        return;
+    }
+    bytes_ = wanted;
+    reservedBytes += bytes_;
+}
+
+MemoryReservation::~MemoryReservation() {
+    if (!bytes_) return;
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex);
+        reservedBytes -= bytes_;
+    }
+    budgetFreed.notify_all();
+}
+
+size_t budgetedChunk(size_t chunk) {
+    uint64_t budget = memoryBudget();
+    if (!budget) return chunk;
+    // Un bloque no pasa de la cuarta parte del límite, para que quepan varios en vuelo, ni baja del
+    // periodo del flujo de claves
+    return static_cast<size_t>(std::max<uint64_t>(std::min<uint64_t>(chunk, budget / 4), 4096));
+}
+
+size_t budgetedWorkers(size_t workers, uint64_t bytesPerWorker) {
+    uint64_t budget = memoryBudget();
+    if (!budget || !bytesPerWorker) return workers;
+    return static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(workers, budget / bytesPerWorker)));
+}
+
+bool fitsMemoryBudget(uint64_t bytes, const std::string &path) {
+    uint64_t budget = memoryBudget();
+    if (!budget || bytes <= budget) return true;
+    std::cerr << "❌ [ERROR] El archivo necesita " << formatBytes(bytes) << " en memoria y el límite es "
+            << formatBytes(budget) << " (--max-memory): " << path << std::endl;
+    return false;
+}
+
+uint64_t peakRss() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // Linux lo da en KB
+}
+
+} // namespace enigmacore
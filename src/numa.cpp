@@ -0,0 +1,356 @@
+#include "internal.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace enigmacore {
+
+// Función para interpretar una lista de CPU de sysfs, por ejemplo "0-3,8-11"
+static std::vector<int> parseCpuList(const std::string &text) {
+    std::vector<int> cpus;
+    std::stringstream list(text);
+    std::string range;
+    while (std::getline(list, range, ',')) {
+        if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0]))) continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Función para leer la topología de /sys/devices/system/node, limitada a las CPU que el proceso puede usar.
+// Sin sysfs (contenedores, otros sistemas) todo queda en un único nodo y no se fija la afinidad.
+static std::vector<NumaNode> readTopology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    std::vector<NumaNode> nodes;
+    std::error_code ec;
+    for (const auto &entry: std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4])))
+            continue;
+        std::ifstream cpulist(entry.path() / "cpulist");
+        std::string text;
+        std::getline(cpulist, text);
+
+        NumaNode node;
+        node.id = std::stoi(name.substr(4));
+        for (int cpu: parseCpuList(text)) {
+            if (!haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) node.cpus.push_back(cpu);
+        }
+        // Los nodos solo de memoria no tienen CPU en las que trabajar
+        if (!node.cpus.empty()) nodes.push_back(node);
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+
+    if (nodes.empty()) {
+        NumaNode node;
+        node.id = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE && haveMask; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) node.cpus.push_back(cpu);
+        }
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+const std::vector<NumaNode> &numaNodes() {
+    static const std::vector<NumaNode> nodes = readTopology();
+    return nodes;
+}
+
+bool pinCurrentThread(const std::vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu: cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Buffer de trabajo de un hilo. Se proyecta con mmap en lugar de usar malloc: al terminar el hilo la
+// memoria vuelve al sistema, en vez de quedarse en la arena de malloc del hilo.
+class WorkerBuffer {
+public:
+    ~WorkerBuffer() { release(); }
+
+    unsigned char *get(size_t size) {
+        if (size_ < size) {
+            // Se libera el anterior antes de reservar el nuevo, para no esperar por memoria propia
+            release();
+            allocate(size, std::unique_ptr<MemoryReservation>(new MemoryReservation(size)));
+        }
+        return data_;
+    }
+
+    // Prepara el buffer sin esperar: si no hay sitio en el límite de memoria devuelve false y conserva el actual
+    bool tryGet(size_t size) {
+        if (size_ >= size) return true;
+        std::unique_ptr<MemoryReservation> reservation(new MemoryReservation(size, std::chrono::milliseconds(0)));
+        if (!reservation->acquired()) return false;
+        release();
+        allocate(size, std::move(reservation));
+        return true;
+    }
+
+    // Libera el buffer y su reserva
+    void release() {
+        if (data_) munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+        reservation_.reset();
+    }
+
+private:
+    void allocate(size_t size, std::unique_ptr<MemoryReservation> reservation) {
+        reservation_ = std::move(reservation);
+        void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            reservation_.reset();
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<unsigned char *>(map);
+        size_ = size;
+    }
+
+    unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+    std::unique_ptr<MemoryReservation> reservation_;
+};
+
+// Se reserva y se escribe desde el propio hilo: por la política de primer acceso de Linux las páginas
+// quedan en el nodo donde está fijado el hilo, y se reutilizan en las siguientes tareas y, en los hilos del
+// conjunto persistente, en las siguientes llamadas
+static thread_local WorkerBuffer threadBuffer;
+
+// Llamadas a parallelForNodes en las que trabaja el hilo actual (como quien llama o como ayudante)
+static thread_local size_t runDepth = 0;
+
+struct RunScope {
+    RunScope() { ++runDepth; }
+    ~RunScope() { --runDepth; }
+};
+
+unsigned char *workerBuffer(size_t size) {
+    // Dentro de una llamada el buffer ya tiene la reserva de 'workerBytes': una tarea que pide más no espera con
+    // esa reserva tomada
+    if (runDepth && !threadBuffer.tryGet(size)) {
+        throw std::runtime_error("No hay sitio en el límite de memoria (--max-memory) para el buffer del hilo");
+    }
+    return threadBuffer.get(size);
+}
+
+// Límite de hilos de trabajo del hilo actual (0 = sin límite), fijado con WorkerLimit
+static thread_local size_t threadWorkerLimit = 0;
+
+WorkerLimit::WorkerLimit(size_t limit) : previous_(threadWorkerLimit) {
+    // Un límite anidado nunca amplía el exterior
+    limit = std::max<size_t>(1, limit);
+    threadWorkerLimit = previous_ ? std::min(previous_, limit) : limit;
+}
+
+WorkerLimit::~WorkerLimit() {
+    threadWorkerLimit = previous_;
+}
+
+// Llamada en curso a parallelForNodes: 'help(home)' trabaja en ella como ayudante del nodo 'home'. 'active'
+// cuenta los ayudantes que la están ejecutando y se protege con el mutex del conjunto de hilos.
+struct ParallelRun {
+    std::function<void(size_t)> help;
+    size_t active = 0;
+    std::condition_variable done;
+};
+
+// Conjunto persistente de hilos de trabajo, fijados a su nodo al crearse. Cada llamada a parallelForNodes
+// publica plazas de ayudante en la cola de cada nodo; los hilos libres del nodo las toman y, si no hay
+// bastantes, se crean más, que después esperan a las siguientes llamadas en lugar de terminar.
+class WorkerPool {
+public:
+    // No se destruye nunca: al salir del proceso sus hilos siguen esperando en las colas
+    static WorkerPool &instance() {
+        static WorkerPool *pool = new WorkerPool();
+        return *pool;
+    }
+
+    // Publica 'helpers' plazas de 'run' para el nodo 'home'. Si no se puede crear un hilo la plaza se queda sin
+    // tomar y quien llama hace ese trabajo.
+    void post(ParallelRun &run, size_t home, size_t helpers) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        NodeQueue &queue = queues_[home];
+        for (size_t i = 0; i < helpers; ++i) queue.slots.push_back(&run);
+        try {
+            while (queue.idle < queue.slots.size()) {
+                std::thread(&WorkerPool::loop, this, home).detach();
+                ++queue.idle;
+            }
+        } catch (const std::system_error &) {
+        }
+        for (size_t i = 0; i < helpers; ++i) queue.ready.notify_one();
+    }
+
+    // Retira las plazas de 'run' que nadie tomó y espera a los ayudantes que siguen en ella
+    void finish(ParallelRun &run) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (NodeQueue &queue: queues_) {
+            queue.slots.erase(std::remove(queue.slots.begin(), queue.slots.end(), &run), queue.slots.end());
+        }
+        run.done.wait(lock, [&] { return run.active == 0; });
+    }
+
+private:
+    struct NodeQueue {
+        std::deque<ParallelRun *> slots;
+        size_t idle = 0; // hilos esperando plazas o recién creados
+        std::condition_variable ready;
+    };
+
+    WorkerPool() : queues_(numaNodes().size()) {
+    }
+
+    void loop(size_t home) {
+        const std::vector<NumaNode> &nodes = numaNodes();
+        if (nodes.size() > 1) pinCurrentThread(nodes[home].cpus);
+        NodeQueue &queue = queues_[home];
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            queue.ready.wait(lock, [&] { return !queue.slots.empty(); });
+            ParallelRun *run = queue.slots.front();
+            queue.slots.pop_front();
+            --queue.idle;
+            ++run->active;
+            lock.unlock();
+            run->help(home);
+            lock.lock();
+            ++queue.idle;
+            // Se avisa con el mutex tomado: quien llamó no puede destruir 'run' hasta soltarlo
+            if (--run->active == 0) run->done.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::vector<NodeQueue> queues_;
+};
+
+size_t workerCount(size_t threads) {
+    if (!threads) threads = tuningProfile().threads;
+    if (!threads) {
+        size_t cpus = 0;
+        for (const NumaNode &node: numaNodes()) cpus += node.cpus.size();
+        threads = std::max<size_t>(1, cpus ? cpus : std::thread::hardware_concurrency());
+    }
+    return threadWorkerLimit ? std::min(threads, threadWorkerLimit) : threads;
+}
+
+bool parallelForNodes(size_t count, size_t threads, const std::function<bool(size_t)> &task,
+                      uint64_t workerBytes) {
+    const std::vector<NumaNode> &nodes = numaNodes();
+    size_t workers = std::min(budgetedWorkers(workerCount(threads), workerBytes), count);
+    if (workers == 0) return true;
+
+    // Los trabajadores se reparten entre los nodos por turnos, y los índices en tramos contiguos
+    // proporcionales al número de trabajadores de cada nodo: cada nodo procesa su parte del archivo.
+    size_t nodeCount = nodes.size() > 1 ? std::min(nodes.size(), workers) : 1;
+    std::vector<size_t> nodeWorkers(nodeCount, 0);
+    for (size_t w = 0; w < workers; ++w) ++nodeWorkers[w % nodeCount];
+
+    std::unique_ptr<std::atomic<size_t>[]> next(new std::atomic<size_t>[nodeCount]);
+    std::vector<size_t> end(nodeCount);
+    size_t begin = 0;
+    for (size_t k = 0; k < nodeCount; ++k) {
+        next[k] = begin;
+        // count * nodeWorkers[k] / workers, sin desbordar con recuentos muy grandes
+        begin += count / workers * nodeWorkers[k] + count % workers * nodeWorkers[k] / workers;
+        end[k] = k + 1 == nodeCount ? count : begin;
+    }
+
+    // Una tarea que falla detiene el reparto. Una excepción que saliera de un hilo terminaría el proceso: se
+    // muestra y cuenta como un fallo.
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    auto fail = [&](const char *what) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        std::cerr << "❌ [ERROR] " << what << std::endl;
+        failed = true;
+    };
+
+    // Primero el tramo del propio nodo; al acabarlo se ayuda a los demás nodos
+    auto work = [&](size_t home) {
+        try {
+            for (size_t step = 0; step < nodeCount && !failed; ++step) {
+                size_t k = (home + step) % nodeCount;
+                for (size_t i = next[k]++; i < end[k] && !failed; i = next[k]++) {
+                    if (!task(i)) failed = true;
+                }
+            }
+        } catch (const std::exception &e) {
+            fail(e.what());
+        } catch (...) {
+            fail("Error desconocido en un hilo de trabajo");
+        }
+    };
+
+    // Buffer de quien llama, que trabaja como el primer trabajador del primer nodo. Fuera de otra llamada el hilo
+    // no tiene nada reservado y espera a que haya sitio: la operación siempre avanza y nunca pasa del límite. En
+    // una llamada anidada (desde una tarea de otra) se usa el buffer que ya reservó la llamada exterior; si no
+    // basta se amplía sin esperar o la llamada falla, porque esperar con la reserva exterior tomada podría
+    // bloquear para siempre.
+    bool nested = runDepth > 0;
+    try {
+        if (workerBytes && !nested) {
+            threadBuffer.get(static_cast<size_t>(workerBytes));
+        } else if (workerBytes && !threadBuffer.tryGet(static_cast<size_t>(workerBytes))) {
+            fail("No hay sitio en el límite de memoria (--max-memory) para una operación anidada");
+            return false;
+        }
+    } catch (const std::exception &e) {
+        fail(e.what());
+        return false;
+    }
+    RunScope scope;
+
+    // Con un solo trabajador las tareas se ejecutan en el hilo de quien llama (por ejemplo, el de un ejecutor),
+    // sin ayudantes. Si no, los ayudantes del conjunto persistente reservan su buffer sin esperar: sin sitio, el
+    // ayudante no trabaja y los demás se reparten su parte. Con límite de memoria el buffer se libera al
+    // terminar, para que los hilos libres no ocupen el límite.
+    ParallelRun run;
+    run.help = [&](size_t home) {
+        RunScope helperScope;
+        try {
+            if (workerBytes && !threadBuffer.tryGet(static_cast<size_t>(workerBytes))) return;
+        } catch (const std::exception &e) {
+            fail(e.what());
+            return;
+        }
+        work(home);
+        if (memoryBudget()) threadBuffer.release();
+    };
+    if (workers > 1) {
+        WorkerPool &pool = WorkerPool::instance();
+        for (size_t k = 0; k < nodeCount; ++k) {
+            size_t helpers = nodeWorkers[k] - (k == 0 ? 1 : 0);
+            if (helpers) pool.post(run, k, helpers);
+        }
+        work(0);
+        pool.finish(run);
+    } else {
+        work(0);
+    }
+    // La reserva de una llamada anidada es de la exterior, que la libera al terminar
+    if (!nested) threadBuffer.release();
+    return !failed;
+}
+
+} // namespace enigmacore
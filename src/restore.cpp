@@ -0,0 +1,205 @@
+#include "enigmacore/async.h"
+#include "enigmacore/keystore.h"
+#include "internal.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <openssl/evp.h>
+
+namespace enigmacore {
+
+// Archivo a restaurar con su cabecera ya leída
+struct RestoreItem {
+    std::string input;
+    std::string output;
+    uint64_t dataOffset = 0;
+    std::vector<unsigned char> wrapped; // cabecera RSA (vacía en los demás formatos)
+    KeyedHeader keyed; // cabecera del formato con llave (vacía en los demás formatos)
+    unsigned char key[32];
+    unsigned char iv[16];
+};
+
+// Contexto OAEP del hilo: crear el contexto cuesta casi tanto como leer la llave, así que cada hilo de
+// desenvoltura crea el suyo una vez y lo reutiliza para todos sus archivos
+struct ThreadUnwrapContext {
+    EVP_PKEY *key = nullptr;
+    EVP_PKEY_CTX *ctx = nullptr;
+
+    ~ThreadUnwrapContext() { EVP_PKEY_CTX_free(ctx); }
+
+    EVP_PKEY_CTX *get(EVP_PKEY *pkey) {
+        // El contexto guarda una referencia a su llave, así que una llave nueva nunca reutiliza la dirección
+        if (key != pkey) {
+            EVP_PKEY_CTX_free(ctx);
+            ctx = newUnwrapContext(pkey);
+            key = pkey;
+        }
+        return ctx;
+    }
+};
+
+// Función para obtener la ruta de salida: la misma ruta relativa, sin el sufijo de los archivos cifrados
+static std::string restoredPath(const std::filesystem::path &input, const std::string &input_dir,
+                                const std::string &output_dir, const std::string &suffix) {
+    std::string relative = std::filesystem::relative(input, input_dir).string();
+    if (!suffix.empty() && relative.size() > suffix.size() &&
+        relative.compare(relative.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        relative.resize(relative.size() - suffix.size());
+    }
+    return (std::filesystem::path(output_dir) / relative).string();
+}
+
+// Función para leer la cabecera de un archivo según el formato: la clave en claro (básico), dos bloques RSA
+// de 'blockSize' bytes o la envoltura con el identificador de la llave
+static bool readRestoreHeader(RestoreItem &item, const RestoreOptions &options, size_t blockSize) {
+    std::ifstream file(item.input, std::ios::binary);
+    if (!file) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << item.input << std::endl;
+        return false;
+    }
+    if (!options.keystore.empty()) {
+        if (!readKeyedHeader(file, item.keyed, item.input)) return false;
+        item.dataOffset = item.keyed.dataOffset;
+    } else {
+        size_t headerSize = options.private_key.empty() ? sizeof(item.key) + sizeof(item.iv) : 2 * blockSize;
+        item.wrapped.resize(headerSize);
+        if (!file.read(reinterpret_cast<char *>(item.wrapped.data()), static_cast<std::streamsize>(headerSize))) {
+            std::cerr << "❌ [ERROR] Archivo cifrado incompleto: " << item.input << std::endl;
+            return false;
+        }
+        if (options.private_key.empty()) {
+            std::copy(item.wrapped.begin(), item.wrapped.begin() + sizeof(item.key), item.key);
+            std::copy(item.wrapped.begin() + sizeof(item.key), item.wrapped.end(), item.iv);
+            item.wrapped.clear();
+        }
+        item.dataOffset = static_cast<uint64_t>(file.tellg());
+    }
+    return true;
+}
+
+// Función para restaurar todos los archivos cifrados de 'input_dir' en 'output_dir'. El hilo que llama lee
+// las cabeceras y va encolando los archivos; los hilos de desenvoltura recuperan en paralelo las claves con
+// la llave privada o el almacén, y cada clave recuperada pasa a los hilos de descifrado, de modo que las
+// operaciones de llave privada de unos archivos se solapan con el descifrado AES de otros.
+bool restoreFiles(const std::string &input_dir, const std::string &output_dir, const RestoreOptions &options) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(input_dir, ec)) {
+        std::cerr << "❌ [ERROR] No existe el directorio: " << input_dir << std::endl;
+        return false;
+    }
+    std::filesystem::create_directories(output_dir, ec);
+    if (std::filesystem::equivalent(input_dir, output_dir, ec)) {
+        std::cerr << "❌ [ERROR] El directorio de salida debe ser distinto del de entrada: " << output_dir
+                << std::endl;
+        return false;
+    }
+
+    // La llave privada o el almacén se cargan una sola vez para todos los archivos; el almacén interpreta cada
+    // llave la primera vez que se usa y la comparten los hilos de desenvoltura
+    EVP_PKEY *privateKey = nullptr;
+    size_t blockSize = 0;
+    if (!options.private_key.empty()) {
+        privateKey = readPrivateKey(options.private_key);
+        if (!privateKey) return false;
+        blockSize = static_cast<size_t>(EVP_PKEY_size(privateKey));
+    }
+    const bool keyed = !options.keystore.empty();
+    Keystore keystore;
+    if (keyed && !keystore.open(options.keystore)) {
+        EVP_PKEY_free(privateKey);
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    size_t threads = workerCount(options.threads);
+    size_t decryptThreads = budgetedWorkers(threads, budgetedChunk(tuningProfile().chunk_size));
+    // Cabeceras leídas por adelantado: suficientes para que ningún hilo se quede sin trabajo
+    const size_t maxInFlight = 8 * std::max(threads, decryptThreads);
+
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    size_t inFlight = 0;
+    size_t files = 0;
+    std::atomic<size_t> failed{0};
+
+    // Marca el archivo como terminado y libera su hueco en la cola
+    auto finish = [&](bool ok) {
+        if (!ok) ++failed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --inFlight;
+        }
+        slotFree.notify_one();
+    };
+
+    {
+        // Los hilos de desenvoltura encolan en los de descifrado, así que se destruyen (y vacían) antes
+        Executor decryptors(decryptThreads);
+        Executor unwrappers(threads);
+
+        // Si la salida está dentro de la entrada, no se recorre
+        std::filesystem::path outputRoot = std::filesystem::weakly_canonical(output_dir, ec);
+        std::filesystem::recursive_directory_iterator it(input_dir, ec), end;
+        for (; it != end; it.increment(ec)) {
+            const std::filesystem::directory_entry &entry = *it;
+            if (entry.is_directory(ec) && std::filesystem::weakly_canonical(entry.path(), ec) == outputRoot) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            std::string name = entry.path().filename().string();
+            if (!entry.is_regular_file(ec) || name.empty() || name[0] == '.') continue;
+            ++files;
+
+            auto item = std::make_shared<RestoreItem>();
+            item->input = entry.path().string();
+            item->output = restoredPath(entry.path(), input_dir, output_dir, options.suffix);
+            if (!readRestoreHeader(*item, options, blockSize)) {
+                ++failed;
+                continue;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotFree.wait(lock, [&] { return inFlight < maxInFlight; });
+                ++inFlight;
+            }
+
+            // Los archivos se descifran sin mensajes informativos; al final se muestra un resumen
+            auto decryptItem = [&, item] {
+                finish(keyed ? decryptKeyedPayload(item->input, item->keyed, item->output, item->key, item->iv)
+                             : decryptPayload(item->input, item->dataOffset, item->output, item->key, item->iv, false));
+            };
+            if (item->wrapped.empty() && !keyed) {
+                // Formato básico: no hay nada que desenvolver
+                decryptors.post(decryptItem);
+                continue;
+            }
+            unwrappers.post([&, item, decryptItem] {
+                bool ok;
+                if (privateKey) {
+                    thread_local ThreadUnwrapContext context;
+                    EVP_PKEY_CTX *ctx = context.get(privateKey);
+                    ok = ctx && unwrapAESKeyAndIV(ctx, blockSize, item->wrapped.data(), item->key, item->iv);
+                    if (!ok) std::cerr << "❌ [ERROR] No se pudo recuperar la clave de: " << item->input << std::endl;
+                } else {
+                    ok = unwrapKeyed(keystore, item->keyed, item->key, item->iv, item->input);
+                }
+                if (ok) decryptors.post(decryptItem);
+                else finish(false);
+            });
+        }
+    }
+    EVP_PKEY_free(privateKey);
+
+    if (isVerbose()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Restored " << files - failed << " of " << files << " files in " << formatDuration(seconds)
+                << ", failed: " << failed << ", peak RSS: " << formatBytes(peakRss()) << std::endl;
+    }
+    return failed == 0;
+}
+
+} // namespace enigmacore
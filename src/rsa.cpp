@@ -0,0 +1,171 @@
+#include "internal.h"
+
+#include <cstdio>
+#include <fstream>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+
+namespace enigmacore {
+
+// Función para encriptar la llave AES y el IV
+bool encryptAESKeyAndIV(const std::string& public_key_path, unsigned char* aes_key, unsigned char* iv, std::ofstream& outputFile) {
+    FILE* pubKeyFile = fopen(public_key_path.c_str(), "rb");
+    if (!pubKeyFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo de la llave pública: " << public_key_path << std::endl;
+        return false;
+    }
+
+    EVP_PKEY* evp_pkey = PEM_read_PUBKEY(pubKeyFile, nullptr, nullptr, nullptr);
+    fclose(pubKeyFile);
+
+    if (!evp_pkey) {
+        std::cerr << "❌ [ERROR] No se pudo leer la llave pública RSA." << std::endl;
+        return false;
+    }
+
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(evp_pkey, nullptr);
+    if (!ctx) {
+        std::cerr << "❌ [ERROR] Error creando el contexto de la llave pública." << std::endl;
+        EVP_PKEY_free(evp_pkey);
+        return false;
+    }
+
+    if (EVP_PKEY_encrypt_init(ctx) <= 0) {
+        std::cerr << "❌ [ERROR] Error inicializando la encriptación." << std::endl;
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(evp_pkey);
+        return false;
+    }
+
+    // Establecer el esquema de padding
+    if (EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) <= 0) {
+        std::cerr << "❌ [ERROR] Error estableciendo el padding." << std::endl;
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(evp_pkey);
+        return false;
+    }
+
+    std::vector<unsigned char> encrypted_aes_key(EVP_PKEY_size(evp_pkey));
+    size_t outlen = encrypted_aes_key.size();
+    if (EVP_PKEY_encrypt(ctx, encrypted_aes_key.data(), &outlen, aes_key, 32) <= 0) {
+        std::cerr << "❌ [ERROR] Error encriptando la clave AES." << std::endl;
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(evp_pkey);
+        return false;
+    }
+
+    encrypted_aes_key.resize(outlen);
+
+    std::vector<unsigned char> encrypted_iv(EVP_PKEY_size(evp_pkey));
+    outlen = encrypted_iv.size();
+    if (EVP_PKEY_encrypt(ctx, encrypted_iv.data(), &outlen, iv, 16) <= 0) {
+        std::cerr << "❌ [ERROR] Error encriptando el IV." << std::endl;
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(evp_pkey);
+        return false;
+    }
+
+    encrypted_iv.resize(outlen);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(evp_pkey);
+
+    // Guardar la clave y el IV encriptados; un fallo de escritura (por ejemplo, disco lleno) dejaría una
+    // cabecera incompleta
+    outputFile.write(reinterpret_cast<char*>(encrypted_aes_key.data()), encrypted_aes_key.size());
+    outputFile.write(reinterpret_cast<char*>(encrypted_iv.data()), encrypted_iv.size());
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo escribir la clave AES y el IV encriptados." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Función para leer una llave privada en formato PEM
+EVP_PKEY *readPrivateKey(const std::string &private_key_path) {
+    FILE* privKeyFile = fopen(private_key_path.c_str(), "rb");
+    if (!privKeyFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo de la llave privada: " << private_key_path << std::endl;
+        return nullptr;
+    }
+
+    EVP_PKEY* evp_pkey = PEM_read_PrivateKey(privKeyFile, nullptr, nullptr, nullptr);
+    fclose(privKeyFile);
+
+    if (!evp_pkey) {
+        std::cerr << "❌ [ERROR] No se pudo leer la llave privada RSA." << std::endl;
+    }
+    return evp_pkey;
+}
+
+// Función para crear un contexto de desencriptación RSA-OAEP para la llave privada
+EVP_PKEY_CTX *newUnwrapContext(EVP_PKEY *evp_pkey) {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(evp_pkey, nullptr);
+    if (!ctx) {
+        std::cerr << "❌ [ERROR] Error creando el contexto de la llave privada." << std::endl;
+        return nullptr;
+    }
+
+    if (EVP_PKEY_decrypt_init(ctx) <= 0) {
+        std::cerr << "❌ [ERROR] Error inicializando la desencriptación." << std::endl;
+        EVP_PKEY_CTX_free(ctx);
+        return nullptr;
+    }
+
+    // Establecer el esquema de padding
+    if (EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) <= 0) {
+        std::cerr << "❌ [ERROR] Error estableciendo el padding." << std::endl;
+        EVP_PKEY_CTX_free(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+// Función para desencriptar la llave AES y el IV de la cabecera RSA ya leída ('wrapped' tiene dos bloques
+// de 'block_size' bytes: la clave y el IV cifrados)
+bool unwrapAESKeyAndIV(EVP_PKEY_CTX *ctx, size_t block_size, const unsigned char *wrapped, unsigned char *aes_key,
+                       unsigned char *iv) {
+    // OpenSSL 3 exige que el buffer de salida tenga el tamaño del módulo RSA
+    std::vector<unsigned char> decrypted(block_size);
+    size_t outlen = decrypted.size();
+    if (EVP_PKEY_decrypt(ctx, decrypted.data(), &outlen, wrapped, block_size) <= 0 ||
+        outlen != 32) {  // Tamaño de la clave AES
+        std::cerr << "❌ [ERROR] Error desencriptando la clave AES." << std::endl;
+        return false;
+    }
+    std::copy(decrypted.begin(), decrypted.begin() + 32, aes_key);
+
+    outlen = decrypted.size();
+    if (EVP_PKEY_decrypt(ctx, decrypted.data(), &outlen, wrapped + block_size, block_size) <= 0 ||
+        outlen != 16) {  // Tamaño del IV
+        std::cerr << "❌ [ERROR] Error desencriptando el IV." << std::endl;
+        return false;
+    }
+    std::copy(decrypted.begin(), decrypted.begin() + 16, iv);
+    return true;
+}
+
+// Función para desencriptar la llave AES y el IV
+bool decryptAESKeyAndIV(const std::string& private_key_path, unsigned char* aes_key, unsigned char* iv, std::ifstream& inputFile) {
+    EVP_PKEY* evp_pkey = readPrivateKey(private_key_path);
+    if (!evp_pkey) return false;
+
+    EVP_PKEY_CTX* ctx = newUnwrapContext(evp_pkey);
+    if (!ctx) {
+        EVP_PKEY_free(evp_pkey);
+        return false;
+    }
+
+    // Leer la clave AES y el IV cifrados, un bloque del tamaño del módulo cada uno
+    size_t block_size = EVP_PKEY_size(evp_pkey);
+    std::vector<unsigned char> wrapped(2 * block_size);
+    inputFile.read(reinterpret_cast<char*>(wrapped.data()), wrapped.size());
+
+    bool ok = unwrapAESKeyAndIV(ctx, block_size, wrapped.data(), aes_key, iv);
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(evp_pkey);
+    return ok;
+}
+
+} // namespace enigmacore
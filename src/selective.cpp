@@ -0,0 +1,450 @@
+#include "internal.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
+
+namespace enigmacore {
+
+// ----------------------------------------------------------------------------
+// Cifrado selectivo de imágenes JPEG y TIFF/TIFF-EP (.NEF)
+// ----------------------------------------------------------------------------
+// Solo se cifran los datos de imagen (datos entrópicos de JPEG, tiras/teselas y miniaturas de
+// TIFF) y los metadatos sensibles (valores de EXIF/GPS, XMP, IPTC, comentarios). Los marcadores,
+// cabeceras de segmento y las IFD se dejan intactos, así que el archivo sigue siendo reconocible
+// por las herramientas. Cada región se cifra in situ en CTR con el contador en su posición.
+//
+// Formato: imagen con las regiones cifradas | clave (32) | IV (16) | regiones (desplazamiento
+// u64, longitud u64) | número de regiones (u64) | tamaño original (u64) | "ENIGSELV"
+// Los lectores de JPEG y TIFF ignoran los datos que siguen al final de la imagen.
+
+static const char kSelectiveMagic[8] = {'E', 'N', 'I', 'G', 'S', 'E', 'L', 'V'};
+
+// Lector de enteros de una estructura TIFF con su orden de bytes
+struct TiffReader {
+    const unsigned char *data;
+    size_t limit; // Fin de la estructura TIFF dentro del archivo
+    size_t base;  // Posición de la cabecera TIFF (los desplazamientos son relativos a ella)
+    bool bigEndian;
+
+    bool u16(size_t pos, uint32_t &value) const {
+        if (pos + 2 > limit) return false;
+        value = bigEndian ? (data[pos] << 8 | data[pos + 1]) : (data[pos + 1] << 8 | data[pos]);
+        return true;
+    }
+
+    bool u32(size_t pos, uint32_t &value) const {
+        if (pos + 4 > limit) return false;
+        const unsigned char *p = data + pos;
+        value = bigEndian
+                    ? (uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3])
+                    : (uint32_t(p[3]) << 24 | uint32_t(p[2]) << 16 | uint32_t(p[1]) << 8 | p[0]);
+        return true;
+    }
+};
+
+// Función para leer el i-ésimo valor SHORT/LONG de una entrada de IFD
+static bool tiffArrayValue(const TiffReader &tiff, uint32_t type, size_t valuePos, uint32_t index,
+                           uint32_t &value) {
+    return type == 3 ? tiff.u16(valuePos + 2 * index, value) : tiff.u32(valuePos + 4 * index, value);
+}
+
+// Función para recorrer una estructura TIFF (un .NEF completo o el bloque EXIF de un JPEG) y
+// reunir las regiones a cifrar
+static bool collectTiffRegions(const unsigned char *data, size_t base, size_t limit,
+                               std::vector<ByteRegion> &regions) {
+    if (base + 8 > limit) return false;
+    TiffReader tiff{data, limit, base, data[base] == 'M'};
+    uint32_t magic, ifd0;
+    if ((data[base] != 'I' && data[base] != 'M') || data[base] != data[base + 1] ||
+        !tiff.u16(base + 2, magic) || magic != 42 || !tiff.u32(base + 4, ifd0))
+        return false;
+
+    // Tamaño en bytes de cada tipo TIFF (BYTE, ASCII, SHORT, LONG, RATIONAL, ...)
+    static const uint32_t typeSizes[] = {0, 1, 1, 2, 4, 8, 1, 1, 2, 4, 8, 4, 8, 4};
+
+    // Cola de IFD pendientes: (desplazamiento, es IFD de metadatos)
+    std::vector<std::pair<uint32_t, bool> > pending = {{ifd0, false}};
+    std::unordered_set<uint32_t> visited;
+    while (!pending.empty() && visited.size() < 256) {
+        auto [ifdOffset, metadata] = pending.back();
+        pending.pop_back();
+        if (ifdOffset == 0 || !visited.insert(ifdOffset).second) continue;
+
+        size_t ifdPos = base + ifdOffset;
+        uint32_t entryCount;
+        if (!tiff.u16(ifdPos, entryCount)) continue;
+
+        // Offsets y tamaños de tiras/teselas/miniatura de esta IFD
+        size_t offsetsPos = 0, countsPos = 0, thumbPos = 0, thumbLenPos = 0;
+        uint32_t offsetsType = 0, countsType = 0, offsetsCount = 0;
+
+        for (uint32_t e = 0; e < entryCount; ++e) {
+            size_t entryPos = ifdPos + 2 + 12 * e;
+            uint32_t tag, type, count, valueOffset;
+            if (!tiff.u16(entryPos, tag) || !tiff.u16(entryPos + 2, type) || !tiff.u32(entryPos + 4, count) ||
+                !tiff.u32(entryPos + 8, valueOffset))
+                break;
+            uint64_t valueSize = type < sizeof(typeSizes) / sizeof(typeSizes[0])
+                                     ? uint64_t(typeSizes[type]) * count
+                                     : 0;
+            size_t valuePos = valueSize <= 4 ? entryPos + 8 : base + valueOffset;
+            if (valueSize == 0 || valuePos + valueSize > limit) continue;
+
+            // Punteros a otras IFD: se siguen y se dejan en claro
+            if (tag == 0x8769 || tag == 0x8825) { // EXIF, GPS
+                pending.push_back({valueOffset, true});
+                continue;
+            }
+            if (tag == 0x014A) { // SubIFDs (datos RAW en TIFF-EP)
+                for (uint32_t i = 0; i < count && i < 64; ++i) {
+                    uint32_t sub;
+                    if (tiff.u32(valuePos + 4 * i, sub)) pending.push_back({sub, false});
+                }
+                continue;
+            }
+            if (tag == 0xA005) continue; // Interoperabilidad: solo estructura
+
+            if (metadata) {
+                // En EXIF/GPS se cifran los valores, no las entradas
+                regions.push_back({valuePos, valueSize});
+            } else if (tag == 273 || tag == 324) { // StripOffsets / TileOffsets
+                offsetsPos = valuePos, offsetsType = type, offsetsCount = count;
+            } else if (tag == 279 || tag == 325) { // StripByteCounts / TileByteCounts
+                countsPos = valuePos, countsType = type;
+            } else if (tag == 0x0201) { // JPEGInterchangeFormat (miniatura)
+                thumbPos = entryPos + 8;
+            } else if (tag == 0x0202) { // JPEGInterchangeFormatLength
+                thumbLenPos = entryPos + 8;
+            }
+        }
+
+        if (offsetsPos && countsPos) {
+            for (uint32_t i = 0; i < offsetsCount; ++i) {
+                uint32_t offset, length;
+                if (tiffArrayValue(tiff, offsetsType, offsetsPos, i, offset) &&
+                    tiffArrayValue(tiff, countsType, countsPos, i, length) && base + uint64_t(offset) < limit)
+                    regions.push_back({base + offset, std::min<uint64_t>(length, limit - base - offset)});
+            }
+        }
+        uint32_t thumbOffset, thumbLength;
+        if (thumbPos && thumbLenPos && tiff.u32(thumbPos, thumbOffset) && tiff.u32(thumbLenPos, thumbLength) &&
+            base + uint64_t(thumbOffset) < limit) {
+            regions.push_back({base + thumbOffset, std::min<uint64_t>(thumbLength, limit - base - thumbOffset)});
+        }
+
+        // Siguiente IFD de la cadena (IFD0 -> IFD1 con la miniatura)
+        uint32_t next;
+        if (tiff.u32(ifdPos + 2 + 12 * entryCount, next)) pending.push_back({next, metadata});
+    }
+    return true;
+}
+
+// Función para recorrer los segmentos de un JPEG y reunir las regiones a cifrar
+static bool collectJpegRegions(const unsigned char *data, size_t size, std::vector<ByteRegion> &regions) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+    static const char exifId[] = "Exif\0";  // "Exif\0\0"
+    static const char xmpId[] = "http://ns.adobe.com/xap/1.0/";
+
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return false;
+        unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) { // Relleno entre segmentos
+            ++pos;
+            continue;
+        }
+        if (marker == 0xD9) break; // EOI
+        if ((marker >= 0xD0 && marker <= 0xD7) || marker == 0x01) {
+            pos += 2;
+            continue;
+        }
+
+        size_t segmentLength = data[pos + 2] << 8 | data[pos + 3];
+        size_t payload = pos + 4;
+        size_t segmentEnd = pos + 2 + segmentLength;
+        if (segmentLength < 2 || segmentEnd > size) return false;
+        size_t payloadLength = segmentEnd - payload;
+
+        if (marker == 0xE1 && payloadLength > 6 && std::memcmp(data + payload, exifId, 6) == 0) {
+            // APP1 EXIF: los valores de EXIF/GPS y la miniatura se cifran dentro del TIFF
+            collectTiffRegions(data, payload + 6, segmentEnd, regions);
+        } else if (marker == 0xE1 && payloadLength > sizeof(xmpId) &&
+                   std::memcmp(data + payload, xmpId, sizeof(xmpId)) == 0) {
+            // APP1 XMP: se cifra el paquete XML completo
+            regions.push_back({payload + sizeof(xmpId), payloadLength - sizeof(xmpId)});
+        } else if ((marker == 0xED || marker == 0xFE) && payloadLength > 0) {
+            // APP13 (IPTC) y COM
+            regions.push_back({payload, payloadLength});
+        }
+
+        pos = segmentEnd;
+        if (marker == 0xDA) {
+            // SOS: los datos entrópicos llegan hasta el siguiente marcador que no sea relleno (FF00) ni RSTn
+            size_t end = pos;
+            while (true) {
+                // Saltar directamente al siguiente 0xFF
+                const void *next = std::memchr(data + end, 0xFF, size - end);
+                end = next ? static_cast<const unsigned char *>(next) - data : size;
+                if (end + 1 >= size) {
+                    end = size;
+                    break;
+                }
+                unsigned char following = data[end + 1];
+                if (following != 0x00 && (following < 0xD0 || following > 0xD7)) break;
+                end += 2;
+            }
+            if (end > pos) regions.push_back({pos, end - pos});
+            pos = end;
+        }
+    }
+    return true;
+}
+
+// Función para reunir las regiones cifrables de una imagen; ordena y une las que se solapan
+// (una región cifrada dos veces quedaría en claro)
+static bool collectImageRegions(const std::vector<unsigned char> &data, std::vector<ByteRegion> &regions) {
+    regions.clear();
+    bool parsed = data.size() >= 2 && data[0] == 0xFF && data[1] == 0xD8
+                      ? collectJpegRegions(data.data(), data.size(), regions)
+                      : collectTiffRegions(data.data(), 0, data.size(), regions);
+    if (!parsed) return false;
+
+    std::sort(regions.begin(), regions.end(), [](const ByteRegion &a, const ByteRegion &b) {
+        return a.offset < b.offset;
+    });
+    std::vector<ByteRegion> merged;
+    for (const ByteRegion &region: regions) {
+        if (region.length == 0) continue;
+        if (!merged.empty() && region.offset <= merged.back().offset + merged.back().length) {
+            uint64_t end = std::max(merged.back().offset + merged.back().length, region.offset + region.length);
+            merged.back().length = end - merged.back().offset;
+        } else {
+            merged.push_back(region);
+        }
+    }
+    regions.swap(merged);
+    return true;
+}
+
+// Función para cifrar/descifrar in situ las regiones de la imagen
+static bool cryptImageRegions(std::vector<unsigned char> &data, const std::vector<ByteRegion> &regions,
+                              const unsigned char *key, const unsigned char *iv) {
+    for (const ByteRegion &region: regions) {
+        unsigned char *bytes = data.data() + region.offset;
+        if (!aesCtrAt(bytes, region.length, key, iv, region.offset, bytes)) return false;
+    }
+    return true;
+}
+
+// Función para cifrar de forma selectiva una imagen JPEG o TIFF/TIFF-EP
+bool encryptSelective(const std::string &input_path, const std::string &output_path) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    // La imagen completa se procesa en memoria
+    uint64_t fileSize = pathSize(input_path);
+    if (!fitsMemoryBudget(fileSize, input_path)) return false;
+    MemoryReservation reservation(fileSize);
+    std::vector<unsigned char> data;
+    if (!readWholeFile(input_path, data)) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        return false;
+    }
+
+    std::vector<ByteRegion> regions;
+    if (!collectImageRegions(data, regions)) {
+        std::cerr << "❌ [ERROR] Formato de imagen no soportado (se espera JPEG o TIFF): " << input_path << std::endl;
+        return false;
+    }
+    unsigned char key[32], iv[16];
+    if (!randomBytes(key, sizeof(key)) || !randomBytes(iv, sizeof(iv))) return false;
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    std::ofstream outputFile(output_path, std::ios::binary);
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+
+    if (!cryptImageRegions(data, regions, key, iv)) return false;
+
+    // Imagen con las regiones cifradas seguida del bloque de descifrado
+    outputFile.write(reinterpret_cast<char *>(data.data()), data.size());
+    outputFile.write(reinterpret_cast<char *>(key), sizeof(key));
+    outputFile.write(reinterpret_cast<char *>(iv), sizeof(iv));
+    uint64_t encryptedBytes = 0;
+    for (const ByteRegion &region: regions) {
+        writeU64(outputFile, region.offset);
+        writeU64(outputFile, region.length);
+        encryptedBytes += region.length;
+    }
+    writeU64(outputFile, regions.size());
+    writeU64(outputFile, data.size());
+    outputFile.write(kSelectiveMagic, sizeof(kSelectiveMagic));
+    outputFile.close();
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+
+    if (isVerbose()) {
+        std::cout << "Regiones cifradas: " << regions.size() << " (" << formatBytes(encryptedBytes) << " de "
+                << formatBytes(data.size()) << ")" << std::endl;
+        std::cout << "Encrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para descifrar una imagen cifrada de forma selectiva
+bool decryptSelective(const std::string &input_path, const std::string &output_path) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    // La imagen completa se procesa en memoria
+    uint64_t fileSize = pathSize(input_path);
+    if (!fitsMemoryBudget(fileSize, input_path)) return false;
+    MemoryReservation reservation(fileSize);
+    std::vector<unsigned char> data;
+    if (!readWholeFile(input_path, data)) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        return false;
+    }
+
+    // Leer el bloque final: número de regiones, tamaño original y firma
+    const size_t tailSize = 8 + 8 + sizeof(kSelectiveMagic);
+    uint64_t regionCount = 0, originalSize = 0;
+    std::istringstream tail;
+    if (data.size() >= tailSize) {
+        tail.str(std::string(data.end() - tailSize, data.end()));
+        readU64(tail, regionCount);
+        readU64(tail, originalSize);
+    }
+    // Los valores de la cola no son de fiar: el número de regiones se deduce de los bytes que quedan entre la
+    // imagen y la cola, sin sumas que puedan desbordarse
+    bool valid = data.size() >= tailSize + 48 &&
+                 std::memcmp(data.data() + data.size() - sizeof(kSelectiveMagic), kSelectiveMagic,
+                             sizeof(kSelectiveMagic)) == 0 &&
+                 originalSize <= data.size() - tailSize - 48;
+    uint64_t tableSize = valid ? data.size() - tailSize - 48 - originalSize : 0;
+    if (!valid || tableSize % 16 != 0 || tableSize / 16 != regionCount) {
+        std::cerr << "❌ [ERROR] El archivo no es una imagen cifrada de forma selectiva: " << input_path << std::endl;
+        return false;
+    }
+
+    unsigned char key[32], iv[16];
+    std::memcpy(key, data.data() + originalSize, sizeof(key));
+    std::memcpy(iv, data.data() + originalSize + sizeof(key), sizeof(iv));
+    std::istringstream table(std::string(data.begin() + originalSize + 48, data.end() - tailSize));
+    std::vector<ByteRegion> regions(regionCount);
+    for (ByteRegion &region: regions) {
+        readU64(table, region.offset);
+        readU64(table, region.length);
+        if (region.offset > originalSize || region.length > originalSize - region.offset) {
+            std::cerr << "❌ [ERROR] La tabla de regiones está dañada: " << input_path << std::endl;
+            return false;
+        }
+    }
+
+    data.resize(originalSize);
+    if (!cryptImageRegions(data, regions, key, iv)) return false;
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    std::ofstream outputFile(output_path, std::ios::binary);
+    outputFile.write(reinterpret_cast<char *>(data.data()), data.size());
+    outputFile.close();
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+
+    if (isVerbose()) {
+        std::cout << std::endl;
+        std::cout << "Decrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para comparar en memoria el rendimiento del cifrado selectivo frente al cifrado completo.
+// El informe se muestra por pantalla y se guarda en 'output_path'.
+bool benchmarkSelective(const std::string &input_path, const std::string &output_path) {
+    // El original y la copia de trabajo están a la vez en memoria
+    uint64_t fileSize = pathSize(input_path);
+    if (!fitsMemoryBudget(2 * fileSize, input_path)) return false;
+    MemoryReservation reservation(2 * fileSize);
+    std::vector<unsigned char> data;
+    if (!readWholeFile(input_path, data) || data.empty()) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        return false;
+    }
+
+    unsigned char key[32], iv[16];
+    if (!randomBytes(key, sizeof(key)) || !randomBytes(iv, sizeof(iv))) return false;
+    std::vector<unsigned char> work = data;
+    std::vector<ByteRegion> regions;
+    if (!collectImageRegions(data, regions)) {
+        std::cerr << "❌ [ERROR] Formato de imagen no soportado (se espera JPEG o TIFF): " << input_path << std::endl;
+        return false;
+    }
+    uint64_t selectedBytes = 0;
+    for (const ByteRegion &region: regions) selectedBytes += region.length;
+
+    // Repetir cada modo durante al menos medio segundo y devolver el tiempo medio por pasada
+    auto measure = [](auto &&pass) {
+        int iterations = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{};
+        do {
+            pass();
+            ++iterations;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 0.5);
+        return elapsed.count() / iterations;
+    };
+
+    // Las dos pasadas cifran in situ la misma copia de trabajo, sin copias previas: solo cambia qué bytes se tocan.
+    // La selectiva incluye el análisis del formato (sobre el original, que no cambia) para que la comparación sea
+    // justa.
+    bool ok = true;
+    double fullTime = measure([&] {
+        ok = aesCtrAt(work.data(), work.size(), key, iv, 0, work.data()) && ok;
+    });
+    double selectiveTime = measure([&] {
+        collectImageRegions(data, regions);
+        ok = cryptImageRegions(work, regions, key, iv) && ok;
+    });
+    if (!ok) return false;
+
+    std::ostringstream report;
+    double mb = data.size() / (1024.0 * 1024.0);
+    report << std::fixed << std::setprecision(2);
+    report << "archivo: " << input_path << " (" << formatBytes(data.size()) << ")\n";
+    report << "bytes cifrados selectivo: " << formatBytes(selectedBytes) << " ("
+            << 100.0 * selectedBytes / data.size() << "%)\n";
+    report << "completo: " << formatDuration(fullTime) << " por pasada, " << mb / fullTime << " MB/s\n";
+    report << "selectivo: " << formatDuration(selectiveTime) << " por pasada, " << mb / selectiveTime << " MB/s\n";
+    report << "aceleración: " << fullTime / selectiveTime << "x\n";
+
+    if (isVerbose()) std::cout << report.str();
+    std::ofstream reportFile(output_path);
+    if (!reportFile || !(reportFile << report.str())) {
+        std::cerr << "❌ [ERROR] No se pudo escribir el informe: " << output_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace enigmacore
@@ -0,0 +1,331 @@
+#include "internal.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+
+namespace enigmacore {
+
+// ----------------------------------------------------------------------------
+// Salida fragmentada en varios archivos (shards)
+// ----------------------------------------------------------------------------
+// El archivo cifrado se reparte en N fragmentos de tamaño configurable que se escriben y se
+// leen en paralelo. Cada fragmento lleva una cabecera que lo describe por sí mismo y lo liga
+// al manifiesto y a la clave (identificador del archivo y huella de la clave), de modo que
+// puede copiarse o almacenarse por separado.
+//
+// Fragmento: "ENIGSHRD" | id del archivo (16) | huella de la clave (8) | índice, número de
+// fragmentos, desplazamiento, longitud y tamaño total (u64 cada uno) | texto cifrado
+// El texto cifrado usa CTR con el contador en la posición del fragmento en el archivo original.
+//
+// El manifiesto guarda el identificador de la llave del almacén y la clave y el IV envueltos con ella.
+
+const char kShardMagic[8] = {'E', 'N', 'I', 'G', 'S', 'H', 'R', 'D'};
+const size_t kShardHeaderSize = sizeof(kShardMagic) + 16 + 8 + 5 * 8;
+const size_t kShardBufferSize = 1 << 20;
+const char kShardManifestName[] = "manifest.txt";
+const char kShardManifestMagic[] = "ENIGMACORE-SHARDS 2";
+
+// Manifiesto de una salida fragmentada
+struct ShardManifest {
+    unsigned char fileId[16];
+    std::string keyId;
+    std::vector<unsigned char> wrapped; // clave e IV envueltos con la llave
+    unsigned char key[32];
+    unsigned char iv[16];
+    uint64_t size = 0;
+    uint64_t shardSize = 0;
+    uint64_t shardCount = 0;
+};
+
+// Cabecera de cada fragmento
+struct ShardHeader {
+    unsigned char fileId[16];
+    unsigned char keyFingerprint[8];
+    uint64_t index, count, offset, length, size;
+};
+
+// Función para calcular la huella de la clave (primeros 8 bytes de su SHA-256)
+static bool keyFingerprint(const unsigned char *key, unsigned char *fingerprint) {
+    unsigned char digest[32];
+    unsigned int digestLen = sizeof(digest);
+    if (1 != EVP_Digest(key, 32, digest, &digestLen, EVP_sha256(), NULL)) return opensslFailed();
+    std::memcpy(fingerprint, digest, 8);
+    return true;
+}
+
+// Nombre del archivo de cada fragmento
+static std::string shardFileName(uint64_t index) {
+    std::ostringstream name;
+    name << "shard-" << std::setw(5) << std::setfill('0') << index << ".bin";
+    return name.str();
+}
+
+// Función para escribir la cabecera de un fragmento
+static void writeShardHeader(std::ostream &out, const ShardHeader &header) {
+    out.write(kShardMagic, sizeof(kShardMagic));
+    out.write(reinterpret_cast<const char *>(header.fileId), sizeof(header.fileId));
+    out.write(reinterpret_cast<const char *>(header.keyFingerprint), sizeof(header.keyFingerprint));
+    for (uint64_t field: {header.index, header.count, header.offset, header.length, header.size}) {
+        writeU64(out, field);
+    }
+}
+
+// Función para leer la cabecera de un fragmento
+static bool readShardHeader(std::istream &in, ShardHeader &header) {
+    char magic[sizeof(kShardMagic)];
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(header.fileId), sizeof(header.fileId));
+    in.read(reinterpret_cast<char *>(header.keyFingerprint), sizeof(header.keyFingerprint));
+    for (uint64_t *field: {&header.index, &header.count, &header.offset, &header.length, &header.size}) {
+        readU64(in, *field);
+    }
+    return in && std::memcmp(magic, kShardMagic, sizeof(magic)) == 0;
+}
+
+// Función para escribir el manifiesto de los fragmentos (primero en un temporal y luego se renombra, para no
+// dejar nunca un manifiesto a medias)
+static bool writeShardManifest(const std::filesystem::path &path, const ShardManifest &manifest) {
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        file << kShardManifestMagic << "\n";
+        file << "file " << toHex(manifest.fileId, sizeof(manifest.fileId)) << "\n";
+        file << "key-id " << manifest.keyId << "\n";
+        file << "wrapped-key " << toHex(manifest.wrapped.data(), manifest.wrapped.size()) << "\n";
+        file << "size " << manifest.size << "\n";
+        file << "shard-size " << manifest.shardSize << "\n";
+        file << "shards " << manifest.shardCount << "\n";
+        file.close();
+        if (!file) {
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) std::filesystem::remove(tmpPath, ec);
+    return !ec;
+}
+
+// Número de fragmentos de 'shardSize' bytes (mayor que cero) para 'size' bytes, sin desbordar al redondear
+// tamaños cercanos a 2^64
+static uint64_t shardCountFor(uint64_t size, uint64_t shardSize) {
+    return size / shardSize + (size % shardSize != 0);
+}
+
+// Función para leer el manifiesto de los fragmentos; la clave y el IV quedan por desenvolver
+static bool readShardManifest(const std::filesystem::path &path, ShardManifest &manifest) {
+    std::ifstream file(path);
+    std::string line, field, fileId, wrapped;
+    if (!std::getline(file, line) || line != kShardManifestMagic) return false;
+    file >> field >> fileId;
+    // El identificador de la llave ocupa el resto de la línea
+    file >> field >> std::ws;
+    std::getline(file, manifest.keyId);
+    file >> field >> wrapped;
+    manifest.wrapped.resize(wrapped.size() / 2);
+    bool keyRead = fromHex(wrapped, manifest.wrapped.data(), manifest.wrapped.size());
+    file >> field >> manifest.size >> field >> manifest.shardSize >> field >> manifest.shardCount;
+    return file && fromHex(fileId, manifest.fileId, sizeof(manifest.fileId)) && keyRead && manifest.shardSize > 0 &&
+           manifest.shardCount == shardCountFor(manifest.size, manifest.shardSize);
+}
+
+// Función para cifrar un archivo en fragmentos de 'shard_size' bytes dentro de 'output_dir'
+bool encryptSharded(const std::string &input_path, const std::string &output_dir, uint64_t shard_size,
+                    const Keystore &keystore, const std::string &key_id) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_dir << std::endl;
+    }
+
+    if (shard_size == 0) {
+        std::cerr << "❌ [ERROR] El tamaño de fragmento debe ser mayor que cero" << std::endl;
+        return false;
+    }
+
+    int fd = open(input_path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    // El identificador va en una línea del manifiesto
+    if (key_id.find_first_of("\r\n") != std::string::npos) {
+        std::cerr << "❌ [ERROR] Identificador de llave no válido: " << key_id << std::endl;
+        close(fd);
+        return false;
+    }
+    ShardManifest manifest;
+    if (!randomBytes(manifest.fileId, sizeof(manifest.fileId)) || !randomBytes(manifest.key, sizeof(manifest.key)) ||
+        !randomBytes(manifest.iv, sizeof(manifest.iv))) {
+        close(fd);
+        return false;
+    }
+    manifest.keyId = key_id;
+    if (!wrapWithKeystore(keystore, key_id, manifest.key, manifest.iv, manifest.wrapped)) {
+        close(fd);
+        return false;
+    }
+
+    std::filesystem::path outputDir(output_dir);
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
+    if (ec) {
+        std::cerr << "❌ [ERROR] No se pudo crear el directorio: " << outputDir << std::endl;
+        close(fd);
+        return false;
+    }
+
+    manifest.size = st.st_size;
+    manifest.shardSize = shard_size;
+    manifest.shardCount = shardCountFor(manifest.size, manifest.shardSize);
+
+    ShardHeader header;
+    std::memcpy(header.fileId, manifest.fileId, sizeof(header.fileId));
+    if (!keyFingerprint(manifest.key, header.keyFingerprint)) {
+        close(fd);
+        return false;
+    }
+
+    // Cada fragmento se cifra y escribe en paralelo leyendo su tramo con pread
+    bool ok = parallelFor(manifest.shardCount, [&](size_t index) {
+        ShardHeader shard = header;
+        shard.index = index;
+        shard.count = manifest.shardCount;
+        shard.offset = index * manifest.shardSize;
+        shard.length = std::min(manifest.shardSize, manifest.size - shard.offset);
+        shard.size = manifest.size;
+
+        std::ofstream shardFile(outputDir / shardFileName(index), std::ios::binary | std::ios::trunc);
+        writeShardHeader(shardFile, shard);
+
+        // Buffer del hilo, local a su nodo NUMA
+        size_t bufferSize = static_cast<size_t>(std::min<uint64_t>(kShardBufferSize, shard.length));
+        unsigned char *buffer = workerBuffer(bufferSize);
+        for (uint64_t done = 0; done < shard.length && shardFile;) {
+            size_t len = static_cast<size_t>(std::min<uint64_t>(bufferSize, shard.length - done));
+            if (!preadAll(fd, buffer, len, shard.offset + done) ||
+                !aesCtrAt(buffer, len, manifest.key, manifest.iv, shard.offset + done, buffer)) {
+                break;
+            }
+            shardFile.write(reinterpret_cast<char *>(buffer), len);
+            done += len;
+        }
+        bool complete = shardFile && static_cast<uint64_t>(shardFile.tellp()) == kShardHeaderSize + shard.length;
+        shardFile.close();
+        return complete && static_cast<bool>(shardFile);
+    }, kShardBufferSize);
+    close(fd);
+
+    if (!ok || !writeShardManifest(outputDir / kShardManifestName, manifest)) {
+        std::cerr << "❌ [ERROR] " << (ok ? "No se pudo escribir el manifiesto en: "
+                                         : "Error escribiendo los fragmentos en: ") << outputDir << std::endl;
+        // Se borran los fragmentos de esta pasada y el manifiesto, que ya no describiría los fragmentos
+        for (uint64_t index = 0; index < manifest.shardCount; ++index) {
+            std::filesystem::remove(outputDir / shardFileName(index), ec);
+        }
+        std::filesystem::remove(outputDir / kShardManifestName, ec);
+        return false;
+    }
+
+    if (isVerbose()) {
+        std::cout << "Fragmentos: " << manifest.shardCount << " de " << formatBytes(manifest.shardSize) << std::endl;
+        std::cout << "Encrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para reconstruir un archivo a partir de sus fragmentos, leyéndolos en paralelo
+bool decryptSharded(const std::string &input_dir, const std::string &output_path, const Keystore &keystore) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_dir << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    std::filesystem::path inputDir(input_dir);
+    ShardManifest manifest;
+    if (!readShardManifest(inputDir / kShardManifestName, manifest)) {
+        std::cerr << "❌ [ERROR] No se pudo leer el manifiesto en: " << input_dir << std::endl;
+        return false;
+    }
+    if (!unwrapWithKeystore(keystore, manifest.keyId, manifest.wrapped, manifest.key, manifest.iv, input_dir)) {
+        return false;
+    }
+    unsigned char fingerprint[8];
+    if (!keyFingerprint(manifest.key, fingerprint)) return false;
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    int fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || manifest.size > static_cast<uint64_t>(std::numeric_limits<off_t>::max()) ||
+        ftruncate(fd, static_cast<off_t>(manifest.size)) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        if (fd >= 0) {
+            close(fd);
+            std::error_code ec;
+            std::filesystem::remove(output_path, ec);
+        }
+        return false;
+    }
+
+    // Cada hilo valida la cabecera de su fragmento y escribe el texto plano en su posición
+    bool ok = parallelFor(manifest.shardCount, [&](size_t index) {
+        std::filesystem::path shardPath = inputDir / shardFileName(index);
+        std::ifstream shardFile(shardPath, std::ios::binary);
+        ShardHeader shard;
+        if (!readShardHeader(shardFile, shard) ||
+            std::memcmp(shard.fileId, manifest.fileId, sizeof(shard.fileId)) != 0 ||
+            std::memcmp(shard.keyFingerprint, fingerprint, sizeof(fingerprint)) != 0 ||
+            shard.index != index || shard.count != manifest.shardCount || shard.size != manifest.size ||
+            shard.offset != index * manifest.shardSize ||
+            shard.length != std::min(manifest.shardSize, manifest.size - shard.offset)) {
+            std::cerr << "❌ [ERROR] El fragmento no pertenece a este archivo: " << shardPath << std::endl;
+            return false;
+        }
+
+        // Buffer del hilo, local a su nodo NUMA
+        size_t bufferSize = static_cast<size_t>(std::min<uint64_t>(kShardBufferSize, shard.length));
+        unsigned char *buffer = workerBuffer(bufferSize);
+        for (uint64_t done = 0; done < shard.length;) {
+            size_t len = static_cast<size_t>(std::min<uint64_t>(bufferSize, shard.length - done));
+            if (!shardFile.read(reinterpret_cast<char *>(buffer), len)) {
+                std::cerr << "❌ [ERROR] El fragmento está incompleto: " << shardPath << std::endl;
+                return false;
+            }
+            if (!aesCtrAt(buffer, len, manifest.key, manifest.iv, shard.offset + done, buffer) ||
+                !pwriteAll(fd, buffer, len, shard.offset + done)) {
+                return false;
+            }
+            done += len;
+        }
+        return true;
+    }, kShardBufferSize);
+    if (close(fd) != 0) ok = false;
+
+    if (!ok) {
+        std::cerr << "❌ [ERROR] No se pudo reconstruir el archivo: " << output_path << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(output_path, ec);
+        return false;
+    }
+    if (isVerbose()) {
+        std::cout << std::endl;
+        std::cout << "Decrypted image" << std::endl;
+    }
+    return true;
+}
+
+} // namespace enigmacore
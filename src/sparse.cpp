@@ -0,0 +1,279 @@
+#include "internal.h"
+
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace enigmacore {
+
+// ----------------------------------------------------------------------------
+// Cifrado de archivos dispersos (sparse)
+// ----------------------------------------------------------------------------
+// Los huecos del archivo (SEEK_DATA/SEEK_HOLE) y los bloques de 4 KB que solo contienen ceros
+// no se cifran: el contenedor guarda solo las extensiones con datos y al descifrar el resto
+// del archivo queda sin asignar en disco.
+//
+// Formato: "ENIGSPRS" | clave (32) | IV (16) | tamaño original (u64) | texto cifrado de las
+// extensiones, en orden | tabla de extensiones (desplazamiento u64, longitud u64) |
+// número de extensiones (u64) | "ENIGSPRS"
+// Cada extensión se cifra en CTR con el contador en su posición dentro del archivo original.
+
+const char kSparseMagic[8] = {'E', 'N', 'I', 'G', 'S', 'P', 'R', 'S'};
+const size_t kSparseHeaderSize = sizeof(kSparseMagic) + 32 + 16 + 8;
+const size_t kSparseBlockSize = 4096;     // Granularidad de detección de bloques a cero
+const size_t kSparseBufferSize = 1 << 20; // Tamaño de lectura (múltiplo de kSparseBlockSize)
+
+// Extensión del archivo original que contiene datos
+struct SparseExtent {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Función para añadir una extensión, uniéndola con la anterior si son contiguas
+static void addSparseExtent(std::vector<SparseExtent> &extents, uint64_t offset, uint64_t length) {
+    if (!extents.empty() && extents.back().offset + extents.back().length == offset) {
+        extents.back().length += length;
+    } else {
+        extents.push_back({offset, length});
+    }
+}
+
+// Función para comprobar si un bloque solo contiene ceros
+static bool isZeroBlock(const unsigned char *data, size_t len) {
+    static const unsigned char zeros[kSparseBlockSize] = {0};
+    return std::memcmp(data, zeros, len) == 0;
+}
+
+// Función para cifrar un archivo omitiendo huecos y bloques a cero
+bool encryptSparse(const std::string &input_path, const std::string &output_path) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    unsigned char key[32], iv[16];
+    if (!randomBytes(key, sizeof(key)) || !randomBytes(iv, sizeof(iv))) return false;
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    // Se usa un descriptor POSIX para poder consultar los huecos con lseek
+    int fd = open(input_path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    const off_t fileSize = st.st_size;
+
+    std::ofstream outputFile(output_path, std::ios::binary);
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        close(fd);
+        return false;
+    }
+    // Si algo falla se borra el contenedor a medias
+    auto discard = [&] {
+        close(fd);
+        outputFile.close();
+        std::error_code ec;
+        std::filesystem::remove(output_path, ec);
+        return false;
+    };
+
+    outputFile.write(kSparseMagic, sizeof(kSparseMagic));
+    outputFile.write(reinterpret_cast<char *>(key), sizeof(key));
+    outputFile.write(reinterpret_cast<char *>(iv), sizeof(iv));
+    writeU64(outputFile, static_cast<uint64_t>(fileSize));
+
+    std::vector<SparseExtent> extents;
+    MemoryReservation reservation(2 * kSparseBufferSize);
+    std::vector<unsigned char> buffer(kSparseBufferSize);
+    std::vector<unsigned char> outputBuffer(kSparseBufferSize);
+    uint64_t dataBytes = 0; // Bytes cifrados realmente
+
+    off_t pos = 0;
+    while (pos < fileSize) {
+        // Localizar la siguiente extensión con datos; sin SEEK_DATA se recorre todo el archivo
+        off_t dataStart = pos, dataEnd = fileSize;
+#ifdef SEEK_DATA
+        dataStart = lseek(fd, pos, SEEK_DATA);
+        if (dataStart < 0) break; // ENXIO: solo quedan huecos hasta el final
+        dataEnd = lseek(fd, dataStart, SEEK_HOLE);
+        if (dataEnd < 0) dataEnd = fileSize;
+#endif
+
+        for (off_t off = dataStart; off < dataEnd;) {
+            size_t want = static_cast<size_t>(std::min<off_t>(buffer.size(), dataEnd - off));
+            ssize_t got = pread(fd, buffer.data(), want, off);
+            if (got <= 0) {
+                std::cerr << "❌ [ERROR] Error leyendo el archivo: " << input_path << std::endl;
+                return discard();
+            }
+
+            // Recorrer bloques alineados con el archivo y cifrar cada tramo de bloques con datos
+            size_t runStart = 0;
+            bool inRun = false;
+            for (size_t i = 0; i <= static_cast<size_t>(got);) {
+                size_t blockLen = std::min(kSparseBlockSize - (off + i) % kSparseBlockSize, got - i);
+                bool zero = i == static_cast<size_t>(got) || isZeroBlock(buffer.data() + i, blockLen);
+                if (!zero && !inRun) {
+                    runStart = i;
+                    inRun = true;
+                } else if (zero && inRun) {
+                    size_t runLen = i - runStart;
+                    if (!aesCtrAt(buffer.data() + runStart, runLen, key, iv, off + runStart, outputBuffer.data())) {
+                        return discard();
+                    }
+                    outputFile.write(reinterpret_cast<char *>(outputBuffer.data()), runLen);
+                    addSparseExtent(extents, off + runStart, runLen);
+                    dataBytes += runLen;
+                    inRun = false;
+                }
+                if (i == static_cast<size_t>(got)) break;
+                i += blockLen;
+            }
+            off += got;
+        }
+        pos = dataEnd;
+    }
+    // Escribir la tabla de extensiones al final del contenedor
+    for (const SparseExtent &extent: extents) {
+        writeU64(outputFile, extent.offset);
+        writeU64(outputFile, extent.length);
+    }
+    writeU64(outputFile, extents.size());
+    outputFile.write(kSparseMagic, sizeof(kSparseMagic));
+    outputFile.close();
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        return discard();
+    }
+    close(fd);
+
+    if (isVerbose()) {
+        std::cout << "Datos cifrados: " << formatBytes(dataBytes) << " de " << formatBytes(fileSize)
+                << " (" << extents.size() << " extensiones)" << std::endl;
+        std::cout << "Encrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para descifrar un contenedor disperso recreando los huecos
+bool decryptSparse(const std::string &input_path, const std::string &output_path) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    std::ifstream inputFile(input_path, std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "❌ [ERROR] No se pudo abrir el archivo: " << input_path << std::endl;
+        return false;
+    }
+
+    // Leer la cabecera
+    char magic[sizeof(kSparseMagic)];
+    unsigned char key[32], iv[16];
+    uint64_t originalSize;
+    inputFile.read(magic, sizeof(magic));
+    inputFile.read(reinterpret_cast<char *>(key), sizeof(key));
+    inputFile.read(reinterpret_cast<char *>(iv), sizeof(iv));
+    if (!readU64(inputFile, originalSize) || std::memcmp(magic, kSparseMagic, sizeof(magic)) != 0) {
+        std::cerr << "❌ [ERROR] El archivo no es un contenedor disperso: " << input_path << std::endl;
+        return false;
+    }
+
+    // Leer la tabla de extensiones desde el final
+    std::error_code ec;
+    uint64_t containerSize = std::filesystem::file_size(input_path, ec);
+    uint64_t extentCount = 0;
+    inputFile.seekg(-static_cast<std::streamoff>(8 + sizeof(kSparseMagic)), std::ios::end);
+    if (ec || containerSize < kSparseHeaderSize + 8 + sizeof(kSparseMagic) || !readU64(inputFile, extentCount) ||
+        !inputFile.read(magic, sizeof(magic)) || std::memcmp(magic, kSparseMagic, sizeof(magic)) != 0 ||
+        extentCount > (containerSize - kSparseHeaderSize - 8 - sizeof(kSparseMagic)) / 16) {
+        std::cerr << "❌ [ERROR] La tabla de extensiones está dañada: " << input_path << std::endl;
+        return false;
+    }
+    uint64_t tableStart = containerSize - 8 - sizeof(kSparseMagic) - extentCount * 16;
+    inputFile.seekg(static_cast<std::streamoff>(tableStart));
+
+    std::vector<SparseExtent> extents(extentCount);
+    uint64_t dataBytes = 0;
+    bool valid = true;
+    for (SparseExtent &extent: extents) {
+        // Sin desbordar: cada extensión cabe en el archivo original y entre todas no pasan de los datos guardados
+        valid = readU64(inputFile, extent.offset) && readU64(inputFile, extent.length) &&
+                extent.length <= originalSize && extent.offset <= originalSize - extent.length &&
+                extent.length <= tableStart - kSparseHeaderSize - dataBytes;
+        if (!valid) break;
+        dataBytes += extent.length;
+    }
+    if (!valid || dataBytes != tableStart - kSparseHeaderSize) {
+        std::cerr << "❌ [ERROR] La tabla de extensiones está dañada: " << input_path << std::endl;
+        return false;
+    }
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    // Al truncar y extender el archivo vacío todo él queda como hueco; solo se escriben las extensiones
+    int fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+    // Si algo falla se borra la salida: nunca queda un archivo descifrado a medias
+    auto discard = [&] {
+        if (fd >= 0) close(fd);
+        std::error_code removeError;
+        std::filesystem::remove(output_path, removeError);
+        return false;
+    };
+    if (ftruncate(fd, static_cast<off_t>(originalSize)) != 0) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return discard();
+    }
+
+    MemoryReservation reservation(2 * kSparseBufferSize);
+    std::vector<unsigned char> buffer(kSparseBufferSize);
+    std::vector<unsigned char> outputBuffer(kSparseBufferSize);
+    inputFile.seekg(static_cast<std::streamoff>(kSparseHeaderSize));
+    for (const SparseExtent &extent: extents) {
+        for (uint64_t done = 0; done < extent.length;) {
+            size_t len = static_cast<size_t>(std::min<uint64_t>(buffer.size(), extent.length - done));
+            if (!inputFile.read(reinterpret_cast<char *>(buffer.data()), len)) {
+                std::cerr << "❌ [ERROR] Error leyendo el archivo: " << input_path << std::endl;
+                return discard();
+            }
+            if (!aesCtrAt(buffer.data(), len, key, iv, extent.offset + done, outputBuffer.data())) {
+                return discard();
+            }
+            if (pwrite(fd, outputBuffer.data(), len, static_cast<off_t>(extent.offset + done)) !=
+                static_cast<ssize_t>(len)) {
+                std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+                return discard();
+            }
+            done += len;
+        }
+    }
+    int closed = close(fd);
+    fd = -1;
+    if (closed != 0) {
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        return discard();
+    }
+
+    if (isVerbose()) {
+        std::cout << std::endl;
+        std::cout << "Decrypted image" << std::endl;
+    }
+    return true;
+}
+
+} // namespace enigmacore
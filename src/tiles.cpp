@@ -0,0 +1,384 @@
+#include "internal.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef ENIGMA_HAVE_JPEG
+#include <jpeglib.h>
+#endif
+
+namespace enigmacore {
+
+// ----------------------------------------------------------------------------
+// Cifrado de imágenes por teselas
+// ----------------------------------------------------------------------------
+// La imagen se decodifica a píxeles (PNM, o JPEG si se compila con libjpeg) y se divide en
+// teselas de kTileSize x kTileSize. Cada tesela se cifra en CTR con el contador en su posición
+// dentro del contenedor, así que puede descifrarse sola leyendo únicamente su entrada del
+// índice y sus bytes, y varias teselas pueden procesarse en paralelo.
+//
+// Formato: "ENIGTILE" | clave (32) | IV (16) | ancho, alto, canales, tamaño de tesela,
+// teselas en X, teselas en Y (u64 cada uno) | índice (desplazamiento u64, longitud u64) por
+// tesela, fila a fila | píxeles de cada tesela, fila a fila
+
+const char kTileMagic[8] = {'E', 'N', 'I', 'G', 'T', 'I', 'L', 'E'};
+const uint64_t kTileSize = 256; // Lado de la tesela en píxeles
+const uint64_t kMaxImageSide = 1 << 24; // Lado máximo de una imagen, en píxeles
+
+// Imagen decodificada con 8 bits por canal
+struct RasterImage {
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint64_t channels = 0; // 1 (gris) o 3 (RGB)
+    std::vector<unsigned char> pixels;
+};
+
+// Cabecera e índice de un contenedor de teselas
+struct TileContainer {
+    unsigned char key[32];
+    unsigned char iv[16];
+    uint64_t width = 0, height = 0, channels = 0, tileSize = 0, tilesX = 0, tilesY = 0;
+    std::vector<ByteRegion> index;
+};
+
+// Función para reservar los píxeles de una imagen con las dimensiones de su cabecera. Las dimensiones no son de
+// fiar: se comprueban sin desbordamientos, y la imagen y el contenedor cifrado tienen que caber a la vez en el
+// límite de memoria antes de reservar nada. 'available' es lo que queda por leer del archivo (0 = desconocido).
+static bool allocatePixels(RasterImage &image, uint64_t available, const std::string &path) {
+    if (image.width == 0 || image.height == 0 || image.width > kMaxImageSide || image.height > kMaxImageSide ||
+        (image.channels != 1 && image.channels != 3))
+        return false;
+    // Con lados de hasta 2^24 y 3 canales el producto no pasa de 2^50
+    uint64_t bytes = image.width * image.height * image.channels;
+    if ((available && bytes > available) || !fitsMemoryBudget(2 * bytes, path)) return false;
+    image.pixels.resize(static_cast<size_t>(bytes));
+    return true;
+}
+
+// Función para leer una imagen PNM binaria (P5 gris o P6 RGB, 8 bits)
+bool loadPnm(const std::string &path, RasterImage &image) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    uint64_t maxValue;
+    if (!(file >> magic) || (magic != "P5" && magic != "P6")) return false;
+
+    // Leer ancho, alto y valor máximo saltando comentarios
+    uint64_t *fields[] = {&image.width, &image.height, &maxValue};
+    for (uint64_t *field: fields) {
+        while (file >> std::ws && file.peek() == '#') file.ignore(1 << 20, '\n');
+        if (!(file >> *field)) return false;
+    }
+    file.get(); // Un único espacio separa la cabecera de los píxeles
+    if (maxValue != 255) return false;
+
+    // Los píxeles tienen que estar en el archivo: una cabecera falsa no reserva más de lo que ocupa
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff end = file.tellg();
+    file.seekg(start);
+    image.channels = magic == "P6" ? 3 : 1;
+    if (!file || end <= start || !allocatePixels(image, static_cast<uint64_t>(end - start), path)) return false;
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(image.pixels.data()), image.pixels.size()));
+}
+
+// Función para escribir una imagen PNM binaria
+bool writePnm(const std::string &path, uint64_t width, uint64_t height, uint64_t channels,
+              const unsigned char *pixels) {
+    createParentDirectory(path);
+
+    std::ofstream file(path, std::ios::binary);
+    file << (channels == 3 ? "P6" : "P5") << "\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char *>(pixels), width * height * channels);
+    file.close();
+    return static_cast<bool>(file);
+}
+
+#ifdef ENIGMA_HAVE_JPEG
+// Gestor de errores de libjpeg que vuelve con longjmp en lugar de terminar el proceso
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    longjmp(reinterpret_cast<JpegErrorManager *>(cinfo->err)->jump, 1);
+}
+
+// Función para decodificar un JPEG a píxeles RGB o gris
+bool loadJpeg(const std::string &path, RasterImage &image) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager error;
+    cinfo.err = jpeg_std_error(&error.base);
+    error.base.error_exit = jpegErrorExit;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(file);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = cinfo.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    image.width = cinfo.output_width;
+    image.height = cinfo.output_height;
+    image.channels = cinfo.output_components;
+    if (!allocatePixels(image, 0, path)) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(file);
+        return false;
+    }
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = image.pixels.data() + cinfo.output_scanline * image.width * image.channels;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    fclose(file);
+    return true;
+}
+#endif
+
+// Función para decodificar la imagen de entrada según su formato
+bool loadRasterImage(const std::string &path, RasterImage &image) {
+    if (loadPnm(path, image)) return true;
+#ifdef ENIGMA_HAVE_JPEG
+    if (loadJpeg(path, image)) return true;
+#endif
+    return false;
+}
+
+// Función para copiar una tesela entre la imagen completa y su buffer contiguo
+void copyTile(const TileContainer &tiles, uint64_t tx, uint64_t ty, unsigned char *imagePixels,
+              unsigned char *tilePixels, bool toTile) {
+    uint64_t x0 = tx * tiles.tileSize, y0 = ty * tiles.tileSize;
+    uint64_t w = std::min(tiles.tileSize, tiles.width - x0), h = std::min(tiles.tileSize, tiles.height - y0);
+    uint64_t rowBytes = w * tiles.channels;
+    for (uint64_t y = 0; y < h; ++y) {
+        unsigned char *imageRow = imagePixels + ((y0 + y) * tiles.width + x0) * tiles.channels;
+        unsigned char *tileRow = tilePixels + y * rowBytes;
+        if (toTile) std::memcpy(tileRow, imageRow, rowBytes);
+        else std::memcpy(imageRow, tileRow, rowBytes);
+    }
+}
+
+// Función para leer la cabecera e índice de un contenedor de teselas
+bool readTileContainer(std::ifstream &file, TileContainer &tiles) {
+    char magic[sizeof(kTileMagic)];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(tiles.key), sizeof(tiles.key));
+    file.read(reinterpret_cast<char *>(tiles.iv), sizeof(tiles.iv));
+    uint64_t *fields[] = {&tiles.width, &tiles.height, &tiles.channels, &tiles.tileSize, &tiles.tilesX, &tiles.tilesY};
+    for (uint64_t *field: fields) readU64(file, *field);
+    // Las dimensiones se acotan antes de operar con ellas, para que ninguna cuenta se desborde
+    if (!file || std::memcmp(magic, kTileMagic, sizeof(magic)) != 0 || tiles.width == 0 || tiles.height == 0 ||
+        tiles.width > kMaxImageSide || tiles.height > kMaxImageSide || tiles.tileSize == 0 ||
+        tiles.tileSize > kMaxImageSide || (tiles.channels != 1 && tiles.channels != 3) ||
+        tiles.tilesX != (tiles.width + tiles.tileSize - 1) / tiles.tileSize ||
+        tiles.tilesY != (tiles.height + tiles.tileSize - 1) / tiles.tileSize)
+        return false;
+
+    // El índice y las teselas tienen que estar en el archivo: así una cabecera falsa no hace reservar la imagen
+    // ni el índice enteros
+    std::streamoff headerEnd = file.tellg();
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(headerEnd);
+    uint64_t offset = static_cast<uint64_t>(headerEnd) + tiles.tilesX * tiles.tilesY * 16;
+    if (!file || offset > fileSize) return false;
+
+    // Cada entrada debe tener exactamente el tamaño de su tesela y seguir a la anterior
+    tiles.index.resize(tiles.tilesX * tiles.tilesY);
+    for (size_t i = 0; i < tiles.index.size(); ++i) {
+        ByteRegion &entry = tiles.index[i];
+        readU64(file, entry.offset);
+        readU64(file, entry.length);
+        uint64_t w = std::min(tiles.tileSize, tiles.width - (i % tiles.tilesX) * tiles.tileSize);
+        uint64_t h = std::min(tiles.tileSize, tiles.height - (i / tiles.tilesX) * tiles.tileSize);
+        if (entry.offset != offset || entry.length != w * h * tiles.channels || entry.length > fileSize - offset)
+            return false;
+        offset += entry.length;
+    }
+    return static_cast<bool>(file);
+}
+
+// Función para cifrar una imagen por teselas
+bool encryptTiles(const std::string &input_path, const std::string &output_path) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    RasterImage image;
+    if (!loadRasterImage(input_path, image)) {
+        std::cerr << "❌ [ERROR] No se pudo decodificar la imagen (PNM P5/P6"
+#ifdef ENIGMA_HAVE_JPEG
+                << " o JPEG"
+#endif
+                << "): " << input_path << std::endl;
+        return false;
+    }
+
+    // La imagen y el contenedor cifrado están a la vez en memoria (el límite ya se comprobó al decodificarla)
+    MemoryReservation reservation(2 * static_cast<uint64_t>(image.pixels.size()));
+
+    TileContainer tiles;
+    if (!randomBytes(tiles.key, sizeof(tiles.key)) || !randomBytes(tiles.iv, sizeof(tiles.iv))) return false;
+    tiles.width = image.width;
+    tiles.height = image.height;
+    tiles.channels = image.channels;
+    tiles.tileSize = kTileSize;
+    tiles.tilesX = (image.width + kTileSize - 1) / kTileSize;
+    tiles.tilesY = (image.height + kTileSize - 1) / kTileSize;
+
+    // Calcular el índice: las teselas van seguidas tras la cabecera
+    uint64_t headerSize = sizeof(kTileMagic) + 32 + 16 + 6 * 8 + tiles.tilesX * tiles.tilesY * 16;
+    uint64_t offset = headerSize;
+    for (uint64_t ty = 0; ty < tiles.tilesY; ++ty) {
+        for (uint64_t tx = 0; tx < tiles.tilesX; ++tx) {
+            uint64_t w = std::min(kTileSize, image.width - tx * kTileSize);
+            uint64_t h = std::min(kTileSize, image.height - ty * kTileSize);
+            tiles.index.push_back({offset, w * h * image.channels});
+            offset += w * h * image.channels;
+        }
+    }
+
+    // Crear el directorio de salida si no existe
+    createParentDirectory(output_path);
+
+    std::ofstream outputFile(output_path, std::ios::binary);
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+
+    // Cifrar las teselas en paralelo directamente en su posición del contenedor
+    std::vector<unsigned char> body(offset - headerSize);
+    if (!parallelFor(tiles.index.size(), [&](size_t i) {
+        const ByteRegion &entry = tiles.index[i];
+        std::vector<unsigned char> tilePixels(entry.length);
+        copyTile(tiles, i % tiles.tilesX, i / tiles.tilesX, image.pixels.data(), tilePixels.data(), true);
+        return aesCtrAt(tilePixels.data(), entry.length, tiles.key, tiles.iv, entry.offset,
+                        body.data() + (entry.offset - headerSize));
+    })) {
+        return false;
+    }
+
+    outputFile.write(kTileMagic, sizeof(kTileMagic));
+    outputFile.write(reinterpret_cast<char *>(tiles.key), sizeof(tiles.key));
+    outputFile.write(reinterpret_cast<char *>(tiles.iv), sizeof(tiles.iv));
+    for (uint64_t field: {tiles.width, tiles.height, tiles.channels, tiles.tileSize, tiles.tilesX, tiles.tilesY}) {
+        writeU64(outputFile, field);
+    }
+    for (const ByteRegion &entry: tiles.index) {
+        writeU64(outputFile, entry.offset);
+        writeU64(outputFile, entry.length);
+    }
+    outputFile.write(reinterpret_cast<char *>(body.data()), body.size());
+    outputFile.close();
+    if (!outputFile) {
+        std::cerr << "❌ [ERROR] Error escribiendo el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+
+    if (isVerbose()) {
+        std::cout << "Imagen " << image.width << "x" << image.height << ", " << tiles.index.size() << " teselas de "
+                << kTileSize << "x" << kTileSize << std::endl;
+        std::cout << "Encrypted image" << std::endl;
+    }
+    return true;
+}
+
+// Función para descifrar una sola tesela (columna tx, fila ty) a un archivo PNM
+bool decryptTile(const std::string &input_path, uint64_t tx, uint64_t ty, const std::string &output_path) {
+    std::ifstream inputFile(input_path, std::ios::binary);
+    TileContainer tiles;
+    if (!inputFile || !readTileContainer(inputFile, tiles)) {
+        std::cerr << "❌ [ERROR] El archivo no es un contenedor de teselas: " << input_path << std::endl;
+        return false;
+    }
+    if (tx >= tiles.tilesX || ty >= tiles.tilesY) {
+        std::cerr << "❌ [ERROR] Tesela fuera de rango: " << tx << " " << ty << " (la imagen tiene "
+                << tiles.tilesX << "x" << tiles.tilesY << " teselas)" << std::endl;
+        return false;
+    }
+
+    // Leer y descifrar solo los bytes de la tesela pedida
+    const ByteRegion &entry = tiles.index[ty * tiles.tilesX + tx];
+    std::vector<unsigned char> tilePixels(entry.length);
+    inputFile.seekg(static_cast<std::streamoff>(entry.offset));
+    if (!inputFile.read(reinterpret_cast<char *>(tilePixels.data()), entry.length)) {
+        std::cerr << "❌ [ERROR] Error leyendo la tesela del archivo: " << input_path << std::endl;
+        return false;
+    }
+    if (!aesCtrAt(tilePixels.data(), entry.length, tiles.key, tiles.iv, entry.offset, tilePixels.data())) return false;
+
+    uint64_t w = std::min(tiles.tileSize, tiles.width - tx * tiles.tileSize);
+    uint64_t h = std::min(tiles.tileSize, tiles.height - ty * tiles.tileSize);
+    if (!writePnm(output_path, w, h, tiles.channels, tilePixels.data())) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+    if (isVerbose()) std::cout << "Decrypted tile " << tx << " " << ty << std::endl;
+    return true;
+}
+
+// Función para descifrar todas las teselas en paralelo y reconstruir la imagen completa en PNM
+bool decryptTiles(const std::string &input_path, const std::string &output_path) {
+    // Mostrar las rutas de los archivos de entrada y salida
+    if (isVerbose()) {
+        std::cout << "input_path=" << input_path << std::endl;
+        std::cout << "output_path=" << output_path << std::endl;
+    }
+
+    std::ifstream inputFile(input_path, std::ios::binary);
+    TileContainer tiles;
+    if (!inputFile || !readTileContainer(inputFile, tiles)) {
+        std::cerr << "❌ [ERROR] El archivo no es un contenedor de teselas: " << input_path << std::endl;
+        return false;
+    }
+    inputFile.close();
+
+    uint64_t imageSize = tiles.width * tiles.height * tiles.channels;
+    if (!fitsMemoryBudget(imageSize, input_path)) return false;
+    MemoryReservation reservation(imageSize);
+    std::vector<unsigned char> pixels(imageSize);
+    bool ok = parallelFor(tiles.index.size(), [&](size_t i) {
+        // Cada hilo lee con su propio descriptor para no compartir la posición de lectura
+        const ByteRegion &entry = tiles.index[i];
+        std::vector<unsigned char> tilePixels(entry.length);
+        std::ifstream file(input_path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(entry.offset));
+        if (!file.read(reinterpret_cast<char *>(tilePixels.data()), entry.length) ||
+            !aesCtrAt(tilePixels.data(), entry.length, tiles.key, tiles.iv, entry.offset, tilePixels.data())) {
+            return false;
+        }
+        copyTile(tiles, i % tiles.tilesX, i / tiles.tilesX, pixels.data(), tilePixels.data(), false);
+        return true;
+    });
+    if (!ok) {
+        std::cerr << "❌ [ERROR] Error leyendo las teselas del archivo: " << input_path << std::endl;
+        return false;
+    }
+
+    if (!writePnm(output_path, tiles.width, tiles.height, tiles.channels, pixels.data())) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de salida: " << output_path << std::endl;
+        return false;
+    }
+    if (isVerbose()) {
+        std::cout << std::endl;
+        std::cout << "Decrypted image" << std::endl;
+    }
+    return true;
+}
+
+} // namespace enigmacore
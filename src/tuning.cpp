@@ -0,0 +1,227 @@
+#include "internal.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+
+namespace enigmacore {
+
+// Perfil activo; se copia al empezar cada operación
+static std::mutex profileMutex;
+static TuningProfile activeProfile;
+
+void setTuningProfile(const TuningProfile &profile) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    activeProfile = profile;
+}
+
+TuningProfile tuningProfile() {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return activeProfile;
+}
+
+std::string defaultTuningPath() {
+    if (const char *path = std::getenv("ENIGMACORE_CONFIG")) return path;
+    if (const char *config = std::getenv("XDG_CONFIG_HOME")) return std::string(config) + "/enigmacore/tuning.conf";
+    if (const char *home = std::getenv("HOME")) return std::string(home) + "/.config/enigmacore/tuning.conf";
+    return "enigmacore.conf";
+}
+
+// Función para comprobar que el motor de cifrado es uno de los conocidos
+static bool validCipher(const std::string &cipher) {
+    return cipher == "openssl" || cipher == "kernel";
+}
+
+// Función para comprobar que el modo de E/S es uno de los conocidos
+static bool validIo(const std::string &io) {
+    return io == "auto" || io == "stream" || io == "pread" || io == "mmap";
+}
+
+bool loadTuningProfile(const std::string &path, TuningProfile &profile) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    TuningProfile loaded = profile;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        std::string key = line.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : line.substr(eq + 1);
+        if (key == "chunk_size") {
+            loaded.chunk_size = static_cast<size_t>(parseSize(value));
+        } else if (key == "threads") {
+            loaded.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "io") {
+            loaded.io = value;
+        } else if (key == "max_memory") {
+            loaded.max_memory = parseSize(value);
+        } else if (key == "cipher") {
+            loaded.cipher = value;
+        } else {
+            // Claves desconocidas: posiblemente de una versión más nueva, se ignoran
+            continue;
+        }
+        if (loaded.chunk_size == 0 || loaded.chunk_size > kMaxChunkSize || !validIo(loaded.io) ||
+            !validCipher(loaded.cipher) || (loaded.max_memory && loaded.max_memory < kMinMaxMemory)) {
+            std::cerr << "❌ [ERROR] Valor no válido en " << path << ":" << lineNumber << ": " << line << std::endl;
+            return false;
+        }
+    }
+    profile = loaded;
+    return true;
+}
+
+bool saveTuningProfile(const std::string &path, const TuningProfile &profile) {
+    createParentDirectory(path);
+    // Se escribe en un temporal y se renombra para no dejar nunca un perfil a medias
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        file << "# Perfil de rendimiento de EnigmaCore (generado por autotune)\n";
+        file << "chunk_size=" << profile.chunk_size << "\n";
+        file << "threads=" << profile.threads << "\n";
+        file << "io=" << profile.io << "\n";
+        if (profile.max_memory) file << "max_memory=" << profile.max_memory << "\n";
+        if (profile.cipher != "openssl") file << "cipher=" << profile.cipher << "\n";
+        if (!file) {
+            std::cerr << "❌ [ERROR] No se pudo escribir el perfil: " << path << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::cerr << "❌ [ERROR] No se pudo escribir el perfil: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Función para sacar de la caché de páginas un archivo, de modo que la siguiente pasada lea del disco
+static void dropCache(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Función para crear el archivo de prueba con datos aleatorios
+static bool writeSample(const std::string &path, uint64_t size) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::vector<unsigned char> block(1 << 20);
+    if (!randomBytes(block.data(), block.size())) return false;
+    for (uint64_t done = 0; done < size && file; done += block.size()) {
+        file.write(reinterpret_cast<char *>(block.data()), std::min<uint64_t>(block.size(), size - done));
+    }
+    return static_cast<bool>(file);
+}
+
+// Función para medir una pasada de cifrado y otra de descifrado con un perfil, sin mensajes informativos;
+// devuelve MB/s (0 si falla). El perfil se pasa a cada operación: el perfil activo no cambia, así que las
+// operaciones de otros hilos no se ejecutan con el candidato.
+static double measure(const TuningProfile &profile, const std::string &sample, const std::string &encrypted,
+                      const std::string &decrypted, uint64_t size) {
+    dropCache(sample);
+    auto start = std::chrono::steady_clock::now();
+    bool ok = encrypt(sample, encrypted, nullptr, false, profile);
+    dropCache(encrypted);
+    ok = ok && decrypt(encrypted, decrypted, nullptr, false, profile);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok && seconds > 0 ? 2.0 * size / seconds / (1 << 20) : 0;
+}
+
+bool autotune(const std::string &directory, const std::string &config_path, uint64_t sample_size) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::filesystem::path dir(directory);
+    std::string sample = (dir / ".enigmacore-autotune.bin").string();
+    std::string encrypted = sample + ".enc";
+    std::string decrypted = sample + ".dec";
+
+    if (!writeSample(sample, sample_size)) {
+        std::cerr << "❌ [ERROR] No se pudo crear el archivo de prueba en: " << directory << std::endl;
+        std::filesystem::remove(sample, ec);
+        return false;
+    }
+
+    // Candidatos: hilos en potencias de dos hasta las CPU disponibles, y bloques de 4 KB a 16 MB
+    size_t cpus = workerCount(0);
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < cpus; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(cpus);
+    const std::vector<size_t> streamChunks = {4 << 10, 64 << 10, 256 << 10, 1 << 20, 4 << 20};
+    const std::vector<size_t> parallelChunks = {256 << 10, 1 << 20, 4 << 20, 16 << 20};
+
+    std::vector<TuningProfile> candidates;
+    for (size_t chunk: streamChunks) candidates.push_back({chunk, 1, "stream"});
+    for (const char *io: {"pread", "mmap"}) {
+        // Los modos de E/S que no se compilaron no se prueban
+        if (!ioBackendAvailable(io)) continue;
+        for (size_t threads: threadCounts) {
+            for (size_t chunk: parallelChunks) candidates.push_back({chunk, threads, io});
+        }
+    }
+
+    // Todas las pasadas respetan el límite de memoria y el motor de cifrado activos, que se conservan en el
+    // perfil guardado
+    TuningProfile active = tuningProfile();
+    for (TuningProfile &candidate: candidates) {
+        candidate.max_memory = active.max_memory;
+        candidate.cipher = active.cipher;
+    }
+
+    // Los mensajes informativos siguen el ajuste global, como en el resto de operaciones
+    bool verbose = isVerbose();
+    if (verbose) {
+        std::cout << "Autotune: " << candidates.size() << " configuraciones con " << formatBytes(sample_size)
+                << " en " << directory << std::endl;
+    }
+    TuningProfile best;
+    double bestSpeed = 0;
+    for (const TuningProfile &candidate: candidates) {
+        // La mejor de dos pasadas, para reducir el ruido
+        double speed = std::max(measure(candidate, sample, encrypted, decrypted, sample_size),
+                                measure(candidate, sample, encrypted, decrypted, sample_size));
+        if (verbose) {
+            // Se formatea aparte para no dejar cambiado el formato de std::cout
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(1);
+            line << "  io=" << std::setw(6) << std::left << candidate.io << std::right << " threads=" << std::setw(3)
+                    << candidate.threads << " chunk=" << std::setw(10) << formatBytes(candidate.chunk_size) << " "
+                    << std::setw(9) << speed << " MB/s";
+            std::cout << line.str() << std::endl;
+        }
+        if (speed > bestSpeed) {
+            bestSpeed = speed;
+            best = candidate;
+        }
+    }
+
+    for (const std::string &path: {sample, encrypted, decrypted}) std::filesystem::remove(path, ec);
+
+    if (bestSpeed == 0) {
+        std::cerr << "❌ [ERROR] Ninguna configuración funcionó en: " << directory << std::endl;
+        return false;
+    }
+    if (verbose) {
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(1);
+        summary << "Mejor: io=" << best.io << " threads=" << best.threads << " chunk=" << formatBytes(best.chunk_size)
+                << " (" << bestSpeed << " MB/s)";
+        std::cout << summary.str() << std::endl;
+    }
+    if (!saveTuningProfile(config_path, best)) return false;
+    if (verbose) std::cout << "Perfil guardado en " << config_path << std::endl;
+    return true;
+}
+
+} // namespace enigmacore
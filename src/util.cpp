@@ -0,0 +1,220 @@
+#include "internal.h"
+
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+namespace enigmacore {
+
+// Mensajes informativos activados por defecto, como en la línea de comandos
+static std::atomic<bool> verbose{true};
+
+void setVerbose(bool value) {
+    verbose = value;
+}
+
+bool isVerbose() {
+    return verbose;
+}
+
+// Funciones para escribir/leer enteros de 64 bits en little-endian en los contenedores
+void writeU64(std::ostream &out, uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; ++i) bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    out.write(reinterpret_cast<char *>(bytes), sizeof(bytes));
+}
+
+bool readU64(std::istream &in, uint64_t &value) {
+    unsigned char bytes[8];
+    if (!in.read(reinterpret_cast<char *>(bytes), sizeof(bytes))) return false;
+    value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | bytes[i];
+    return true;
+}
+
+// Función para convertir bytes a texto hexadecimal
+std::string toHex(const unsigned char *data, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(len * 2, '0');
+    for (size_t i = 0; i < len; ++i) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+// Función para convertir texto hexadecimal a bytes; devuelve false si el texto no es válido
+bool fromHex(const std::string &hex, unsigned char *out, size_t len) {
+    if (hex.size() != len * 2) return false;
+    for (size_t i = 0; i < len; ++i) {
+        unsigned int byte;
+        if (std::sscanf(hex.c_str() + 2 * i, "%2x", &byte) != 1) return false;
+        out[i] = static_cast<unsigned char>(byte);
+    }
+    return true;
+}
+
+// Función para leer un archivo completo en memoria
+bool readWholeFile(const std::string &path, std::vector<unsigned char> &data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::error_code ec;
+    size_t size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    data.resize(size);
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(data.data()), size));
+}
+
+// Función para escribir todo el buffer en una posición del descriptor
+bool pwriteAll(int fd, const unsigned char *data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t written = pwrite(fd, data, len, static_cast<off_t>(offset));
+        if (written <= 0) return false;
+        data += written, len -= written, offset += written;
+    }
+    return true;
+}
+
+// Función para leer exactamente 'len' bytes de una posición del descriptor
+bool preadAll(int fd, unsigned char *data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t got = pread(fd, data, len, static_cast<off_t>(offset));
+        if (got <= 0) return false;
+        data += got, len -= got, offset += got;
+    }
+    return true;
+}
+
+// Función para formatear el tamaño en bytes a una representación legible
+std::string formatBytes(size_t bytes) {
+    const double KB = 1024.0;
+    const double MB = KB * 1024.0;
+    const double GB = MB * 1024.0;
+
+    std::ostringstream oss;
+    if (bytes < KB) {
+        oss << std::fixed << std::setprecision(2) << bytes << " bytes";
+    } else if (bytes < MB) {
+        oss << std::fixed << std::setprecision(2) << bytes / KB << " KB";
+    } else if (bytes < GB) {
+        oss << std::fixed << std::setprecision(2) << bytes / MB << " MB";
+    } else {
+        oss << std::fixed << std::setprecision(2) << bytes / GB << " GB";
+    }
+    return oss.str();
+}
+
+// Función para mostrar la barra de progreso
+void showProgress(size_t current, size_t total, size_t updateInterval) {
+    static size_t lastUpdate = 0; // Última actualización
+    static auto lastUpdateTime = std::chrono::steady_clock::now(); // Hora de la última actualización
+
+    // Calcula el progreso
+    float progress = (float) current / total;
+    int barWidth = 50;
+    int pos = barWidth * progress;
+
+    // Solo actualiza si se han procesado suficientes bytes o ha pasado suficiente tiempo
+    if (current - lastUpdate >= updateInterval || std::chrono::steady_clock::now() - lastUpdateTime >
+        std::chrono::milliseconds(500)) {
+        std::cout << "\r[" << std::string(pos, '#') << std::string(barWidth - pos, ' ') << "] "
+                << int(progress * 100.0) << "% "
+                << std::flush;
+
+        lastUpdate = current;
+        lastUpdateTime = std::chrono::steady_clock::now();
+    }
+}
+
+std::string formatDuration(double seconds) {
+    std::ostringstream oss;
+
+    if (seconds < 1e-6) {
+        // Menos de 1 microsegundo
+        oss << std::fixed << std::setprecision(2) << seconds * 1e9 << " ns"; // Nanosegundos
+    } else if (seconds < 1e-3) {
+        // Menos de 1 milisegundo
+        oss << std::fixed << std::setprecision(2) << seconds * 1e6 << " µs"; // Microsegundos
+    } else if (seconds < 1.0) {
+        // Menos de 1 segundo
+        oss << std::fixed << std::setprecision(2) << seconds * 1e3 << " ms"; // Milisegundos
+    } else if (seconds < 60.0) {
+        // Menos de 1 minuto
+        oss << std::fixed << std::setprecision(2) << seconds << " s"; // Segundos
+    } else if (seconds < 3600.0) {
+        // Menos de 1 hora
+        int minutes = static_cast<int>(seconds) / 60;
+        int secs = static_cast<int>(seconds) % 60;
+        oss << minutes << " min " << secs << " s"; // Minutos y segundos
+    } else {
+        // 1 hora o más
+        int hours = static_cast<int>(seconds) / 3600;
+        int minutes = (static_cast<int>(seconds) % 3600) / 60;
+        int secs = static_cast<int>(seconds) % 60;
+        oss << hours << " h " << minutes << " min " << secs << " s"; // Horas, minutos y segundos
+    }
+
+    return oss.str();
+}
+
+// Función para imprimir los resultados del proceso
+void printFormattedResults(size_t originalSize, size_t processedSize, double duration) {
+    std::cout << "\n--- Resumen del Proceso ---" << std::endl;
+    std::cout << "Tamaño del archivo original: " << formatBytes(originalSize) << std::endl; // Tamaño original
+    std::cout << "Tamaño del archivo procesado: " << formatBytes(processedSize) << std::endl; // Tamaño procesado
+    std::cout << "Diferencia de tamaño: " << formatBytes(
+        std::abs(static_cast<long long>(processedSize) - static_cast<long long>(originalSize))) << std::endl;
+    // Diferencia de tamaño
+    std::cout << "Tiempo total: " << formatDuration(duration) << std::endl; // Tiempo total
+    std::cout << "Pico de memoria (RSS): " << formatBytes(peakRss()) << std::endl; // Memoria máxima usada
+    std::cout << "----------------------------\n" << std::endl;
+}
+
+// Función para obtener el tamaño de una ruta: el tamaño del archivo o la suma de los archivos de un directorio
+size_t pathSize(const std::string &path) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        size_t total = 0;
+        for (const auto &entry: std::filesystem::recursive_directory_iterator(path, ec)) {
+            if (entry.is_regular_file(ec)) total += entry.file_size(ec);
+        }
+        return total;
+    }
+    size_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+// Función para crear el directorio que contendrá 'path' si no existe
+void createParentDirectory(const std::string &path) {
+    std::filesystem::path outputDir = std::filesystem::path(path).parent_path();
+    std::error_code ec;
+    if (!outputDir.empty()) std::filesystem::create_directories(outputDir, ec);
+}
+
+// Función para interpretar un tamaño con sufijo opcional K, M o G (por ejemplo "64M"); 0 si no es válido
+uint64_t parseSize(const std::string &text) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return 0;
+    char *end = nullptr;
+    errno = 0;
+    uint64_t value = std::strtoull(text.c_str(), &end, 10);
+    if (errno == ERANGE) return 0;
+    int shift = 0;
+    switch (std::toupper(static_cast<unsigned char>(*end))) {
+        case '\0': break;
+        case 'K': shift = 10; break;
+        case 'M': shift = 20; break;
+        case 'G': shift = 30; break;
+        default: return 0;
+    }
+    // Tras el sufijo no puede haber nada más, y el resultado tiene que caber en 64 bits
+    if (shift && (end[1] != '\0' || value > (~0ULL >> shift))) return 0;
+    return value << shift;
+}
+
+} // namespace enigmacore
@@ -0,0 +1,207 @@
+#include "enigmacore/async.h"
+#include "internal.h"
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace enigmacore {
+
+// Los archivos ocultos suelen ser temporales de una copia en curso (rsync, editores, navegadores)
+static bool isCandidate(const std::filesystem::path &path) {
+    std::error_code ec;
+    std::string name = path.filename().string();
+    return !name.empty() && name[0] != '.' && std::filesystem::is_regular_file(path, ec);
+}
+
+// Función para mover un archivo, copiándolo si el destino está en otro sistema de archivos
+static bool moveFile(const std::filesystem::path &from, const std::filesystem::path &to) {
+    std::error_code ec;
+    std::filesystem::rename(from, to, ec);
+    if (!ec) return true;
+    if (!std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec)) return false;
+    return std::filesystem::remove(from, ec);
+}
+
+// Función para cifrar un archivo de la carpeta vigilada. La salida se escribe con la extensión '.part' y
+// se renombra al terminar, de modo que quien lea la carpeta de salida nunca ve un archivo a medias. Los
+// mensajes del cifrado se sustituyen por una línea por archivo (con 'verbose').
+static bool processDroppedFile(const std::filesystem::path &input, const std::filesystem::path &output_dir,
+                               const WatchOptions &options, std::mutex &logMutex, bool verbose) {
+    auto start = std::chrono::steady_clock::now();
+    std::filesystem::path output = output_dir / (input.filename().string() + ".enc");
+    std::filesystem::path partial = output.string() + ".part";
+    std::error_code ec;
+
+    bool ok = encrypt(input.string(), partial.string(), nullptr, false);
+    // Antes de tocar el original se comprueba que el cifrado se puede descifrar
+    if (ok && options.after != WatchOptions::KeepOriginals) ok = verify(partial.string(), input.string());
+    if (ok) {
+        std::filesystem::rename(partial, output, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(partial, ec);
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cerr << "❌ [ERROR] No se pudo cifrar: " << input.string() << std::endl;
+        return false;
+    }
+
+    if (options.after == WatchOptions::DeleteOriginals) {
+        std::filesystem::remove(input, ec);
+    } else if (options.after == WatchOptions::MoveOriginals &&
+               !moveFile(input, std::filesystem::path(options.move_dir) / input.filename())) {
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cerr << "❌ [ERROR] No se pudo mover el original: " << input.string() << std::endl;
+    }
+
+    if (verbose) {
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cout << "Encrypted " << input.filename().string() << " -> " << output.string() << " ("
+                << formatDuration(duration.count()) << ")" << std::endl;
+    }
+    return true;
+}
+
+// Función para vigilar 'input_dir' con inotify y cifrar cada archivo que termine de escribirse o que se
+// mueva a la carpeta. Los eventos de un mismo archivo se agrupan durante 'debounce_ms' para no cifrar
+// escrituras parciales, y como mucho hay dos archivos por hilo en cola en el ejecutor.
+bool watchFolder(const std::string &input_dir, const std::string &output_dir, const WatchOptions &options) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(input_dir, ec)) {
+        std::cerr << "❌ [ERROR] No existe el directorio: " << input_dir << std::endl;
+        return false;
+    }
+    std::filesystem::create_directories(output_dir, ec);
+    if (std::filesystem::equivalent(input_dir, output_dir, ec)) {
+        std::cerr << "❌ [ERROR] El directorio de salida debe ser distinto del vigilado: " << output_dir << std::endl;
+        return false;
+    }
+    if (options.after == WatchOptions::MoveOriginals) {
+        std::filesystem::create_directories(options.move_dir, ec);
+        if (!std::filesystem::is_directory(options.move_dir, ec)) {
+            std::cerr << "❌ [ERROR] No se pudo crear el directorio: " << options.move_dir << std::endl;
+            return false;
+        }
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, input_dir.c_str(),
+                                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY | IN_DELETE | IN_MOVED_FROM) < 0) {
+        std::cerr << "❌ [ERROR] No se pudo vigilar el directorio: " << input_dir << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto debounce = std::chrono::milliseconds(options.debounce_ms);
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = budgetedWorkers(threads, 2 * static_cast<uint64_t>(budgetedChunk(tuningProfile().chunk_size)));
+    const size_t maxInFlight = threads * 2;
+
+    // Archivos pendientes con la hora de su último evento y si ya se cerró tras escribirlo (solo los usa
+    // este hilo). Un archivo que sigue abierto no se cifra aunque lleve tiempo sin cambios.
+    struct PendingFile {
+        Clock::time_point lastEvent;
+        bool closed;
+    };
+    std::map<std::string, PendingFile> pending;
+    // Archivos que se están cifrando (compartido con los hilos de trabajo)
+    std::mutex mutex;
+    std::set<std::string> running;
+    std::mutex logMutex;
+
+    // Añade a pendientes todo lo que ya está en la carpeta (al arrancar o si se desbordó la cola de eventos)
+    auto rescan = [&] {
+        for (const auto &entry: std::filesystem::directory_iterator(input_dir, ec)) {
+            if (isCandidate(entry.path())) pending[entry.path().filename().string()] = {Clock::now(), true};
+        }
+    };
+
+    bool verbose = isVerbose();
+    if (verbose) std::cout << "Watching " << input_dir << " -> " << output_dir << std::endl;
+
+    bool ok = true;
+    {
+        Executor executor(threads);
+        rescan();
+
+        alignas(struct inotify_event) char events[sizeof(struct inotify_event) + NAME_MAX + 1];
+        while (!(options.stop && *options.stop)) {
+            // Esperar eventos como mucho hasta que venza el primer archivo pendiente
+            int timeout = 200;
+            for (const auto &item: pending) {
+                if (!item.second.closed) continue;
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    item.second.lastEvent + debounce - Clock::now()).count();
+                timeout = static_cast<int>(std::max<long long>(0, std::min<long long>(timeout, remaining)));
+            }
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, timeout) < 0 && errno != EINTR) {
+                std::cerr << "❌ [ERROR] Error esperando eventos de inotify" << std::endl;
+                ok = false;
+                break;
+            }
+
+            // Leer todos los eventos disponibles
+            ssize_t length;
+            bool watchLost = false;
+            while ((length = read(fd, events, sizeof(events))) > 0) {
+                for (char *ptr = events; ptr < events + length;) {
+                    const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+                    ptr += sizeof(struct inotify_event) + event->len;
+                    if (event->mask & IN_Q_OVERFLOW) rescan();
+                    if (event->mask & IN_IGNORED) watchLost = true;
+                    if (!event->len || (event->mask & IN_ISDIR)) continue;
+                    std::string name = event->name;
+                    if (name[0] == '.') continue;
+                    if (event->mask & (IN_DELETE | IN_MOVED_FROM)) pending.erase(name);
+                    else pending[name] = {Clock::now(), (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0};
+                }
+            }
+            if (watchLost) {
+                std::cerr << "❌ [ERROR] El directorio vigilado ya no existe: " << input_dir << std::endl;
+                ok = false;
+                break;
+            }
+
+            // Encolar los archivos que llevan 'debounce' sin eventos
+            auto now = Clock::now();
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (!it->second.closed || now - it->second.lastEvent < debounce) {
+                    ++it;
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (running.size() >= maxInFlight) break;
+                // Si el archivo se está cifrando, se vuelve a cifrar cuando termine
+                if (running.count(it->first)) {
+                    ++it;
+                    continue;
+                }
+                std::filesystem::path input = std::filesystem::path(input_dir) / it->first;
+                if (isCandidate(input)) {
+                    running.insert(it->first);
+                    executor.post([&, input, name = it->first] {
+                        processDroppedFile(input, output_dir, options, logMutex, verbose);
+                        std::lock_guard<std::mutex> lock(mutex);
+                        running.erase(name);
+                    });
+                }
+                it = pending.erase(it);
+            }
+        }
+    }
+    close(fd);
+    if (verbose) std::cout << "Stopped (peak RSS: " << formatBytes(peakRss()) << ")" << std::endl;
+    return ok;
+}
+
+} // namespace enigmacore
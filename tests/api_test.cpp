@@ -0,0 +1,199 @@
+// Pruebas de la API de buffers (spans, CtrStream y aesCrypt), de la cabecera RSA y de la ABI de C
+
+#include "test_util.h"
+#include "enigmacore/enigmacore_c.h"
+
+#include <cstring>
+#include <thread>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Material de clave fijo a partir de una semilla
+static KeyMaterial keyMaterial(unsigned seed) {
+    KeyMaterial material;
+    std::vector<unsigned char> bytes = randomData(sizeof(material.key) + sizeof(material.iv), seed);
+    std::memcpy(material.key, bytes.data(), sizeof(material.key));
+    std::memcpy(material.iv, bytes.data() + sizeof(material.key), sizeof(material.iv));
+    return material;
+}
+
+// Flujo de referencia: 'data' cifrado desde la posición 'offset'
+static std::vector<unsigned char> reference(const KeyMaterial &material, const std::vector<unsigned char> &data,
+                                            uint64_t offset) {
+    std::vector<unsigned char> output(data.size());
+    CHECK(aesCtrAt(data.data(), data.size(), material.key, material.iv, offset, output.data()));
+    return output;
+}
+
+// encryptBuffer y decryptBuffer: en cualquier posición, in situ, y con una salida demasiado pequeña
+static void testBuffers() {
+    KeyMaterial material = keyMaterial(1);
+    std::vector<unsigned char> data = randomData(10000, 2);
+    for (uint64_t offset: {uint64_t(0), uint64_t(5), uint64_t(4096), uint64_t(1) << 40}) {
+        std::vector<unsigned char> sealed(data.size());
+        CHECK(encryptBuffer(material, data, sealed, offset));
+        CHECK(sealed == reference(material, data, offset));
+        std::vector<unsigned char> opened = sealed;
+        CHECK(decryptBuffer(material, opened, opened, offset));
+        CHECK(opened == data);
+    }
+
+    // Un tramo del buffer cifrado por separado coincide con el mismo tramo del flujo
+    std::vector<unsigned char> whole = reference(material, data, 0);
+    std::vector<unsigned char> part(100);
+    CHECK(encryptBuffer(material, {data.data() + 333, 100}, part, 333));
+    CHECK(std::equal(part.begin(), part.end(), whole.begin() + 333));
+
+    std::vector<unsigned char> small(data.size() - 1);
+    CHECK(!encryptBuffer(material, data, small));
+    CHECK(encryptBuffer(material, ByteSpan(), MutableByteSpan()));
+
+    KeyMaterial generated{}, other{};
+    CHECK(generateKey(generated) && generateKey(other));
+    CHECK(std::memcmp(&generated, &other, sizeof(generated)) != 0);
+}
+
+// CtrStream continúa el flujo entre llamadas de cualquier tamaño, también tras moverlo
+static void testStream() {
+    KeyMaterial material = keyMaterial(3);
+    std::vector<unsigned char> data = randomData(20000, 4);
+    for (uint64_t start: {uint64_t(0), uint64_t(37)}) {
+        std::vector<unsigned char> expected = reference(material, data, start);
+        std::vector<unsigned char> output(data.size());
+        CtrStream stream(material, start);
+        CHECK(stream.ready() && stream.position() == start);
+        size_t done = 0;
+        for (size_t step: {size_t(1), size_t(15), size_t(17), size_t(4096), size_t(0), size_t(3)}) {
+            CHECK(stream.update({data.data() + done, step}, {output.data() + done, step}));
+            done += step;
+        }
+        // El resto con un flujo movido
+        CtrStream moved(std::move(stream));
+        CHECK(!stream.ready() && !stream.update({data.data(), 1}, {output.data(), 1}));
+        CtrStream assigned(material);
+        assigned = std::move(moved);
+        CHECK(assigned.position() == start + done);
+        CHECK(assigned.update({data.data() + done, data.size() - done}, {output.data() + done, data.size() - done}));
+        CHECK(output == expected);
+        CHECK(assigned.position() == start + data.size());
+
+        std::vector<unsigned char> small(1);
+        CHECK(!assigned.update({data.data(), 2}, small));
+    }
+}
+
+// aesCrypt prepara la clave en cada llamada: alternar claves y direcciones, también desde varios hilos, da
+// siempre el flujo de la clave de esa llamada
+static void testAesCrypt() {
+    KeyMaterial first = keyMaterial(5), second = keyMaterial(6);
+    std::vector<unsigned char> data = randomData(5000, 7);
+    std::vector<unsigned char> expectedFirst = reference(first, data, 0);
+    std::vector<unsigned char> expectedSecond = reference(second, data, 0);
+
+    auto run = [&](bool &ok) {
+        std::vector<unsigned char> output(data.size());
+        for (int round = 0; round < 20; ++round) {
+            const KeyMaterial &material = round % 2 ? second : first;
+            KeyMaterial copy = material;
+            bool encrypt = round % 3 != 0;
+            ok = aesCrypt(data.data(), static_cast<int>(data.size()), copy.key, copy.iv, output.data(), encrypt) &&
+                 output == (round % 2 ? expectedSecond : expectedFirst) && ok;
+        }
+    };
+    bool ok = true;
+    run(ok);
+    CHECK(ok);
+
+    bool threadOk[4] = {true, true, true, true};
+    std::vector<std::thread> threads;
+    for (bool &result: threadOk) threads.emplace_back(run, std::ref(result));
+    for (std::thread &thread: threads) thread.join();
+    for (bool result: threadOk) CHECK(result);
+}
+
+// Cabecera RSA: la clave y el IV se recuperan con la llave privada, y un fallo de escritura se detecta
+static void testRsaHeader(const TempDir &dir) {
+    EVP_PKEY *pkey = EVP_RSA_gen(2048);
+    CHECK(pkey != nullptr);
+    if (!pkey) return;
+    FILE *publicFile = fopen((dir / "public.pem").c_str(), "wb");
+    FILE *privateFile = fopen((dir / "private.pem").c_str(), "wb");
+    CHECK(publicFile && PEM_write_PUBKEY(publicFile, pkey) == 1);
+    CHECK(privateFile && PEM_write_PrivateKey(privateFile, pkey, nullptr, nullptr, 0, nullptr, nullptr) == 1);
+    if (publicFile) fclose(publicFile);
+    if (privateFile) fclose(privateFile);
+    EVP_PKEY_free(pkey);
+
+    KeyMaterial material = keyMaterial(8);
+    {
+        std::ofstream header(dir / "header.bin", std::ios::binary);
+        CHECK(encryptAESKeyAndIV(dir / "public.pem", material.key, material.iv, header));
+    }
+    KeyMaterial recovered{};
+    std::ifstream header(dir / "header.bin", std::ios::binary);
+    CHECK(decryptAESKeyAndIV(dir / "private.pem", recovered.key, recovered.iv, header));
+    CHECK(std::memcmp(&recovered, &material, sizeof(material)) == 0);
+
+    QuietErrors quiet;
+    std::ofstream unwritable;
+    unwritable.setstate(std::ios::badbit);
+    CHECK(!encryptAESKeyAndIV(dir / "public.pem", material.key, material.iv, unwritable));
+    CHECK(!encryptAESKeyAndIV(dir / "no-existe.pem", material.key, material.iv, unwritable));
+}
+
+// ABI de C: mismos resultados que la API de C++ y -1 con argumentos no válidos
+static void testCAbi(const TempDir &dir) {
+    unsigned char key[ENIGMACORE_KEY_SIZE], iv[ENIGMACORE_IV_SIZE];
+    CHECK(enigmacore_generate_key(key, iv) == 0);
+    CHECK(enigmacore_generate_key(nullptr, iv) == -1);
+    KeyMaterial material;
+    std::memcpy(material.key, key, sizeof(key));
+    std::memcpy(material.iv, iv, sizeof(iv));
+
+    std::vector<unsigned char> data = randomData(9000, 9);
+    std::vector<unsigned char> output(data.size());
+    CHECK(enigmacore_crypt_buffer(key, iv, 100, data.data(), output.data(), data.size()) == 0);
+    CHECK(output == reference(material, data, 100));
+    CHECK(enigmacore_crypt_buffer(key, iv, 100, output.data(), output.data(), output.size()) == 0);
+    CHECK(output == data);
+    CHECK(enigmacore_crypt_buffer(nullptr, iv, 0, data.data(), output.data(), 1) == -1);
+    CHECK(enigmacore_crypt_buffer(key, iv, 0, nullptr, output.data(), 1) == -1);
+    CHECK(enigmacore_crypt_buffer(key, iv, 0, nullptr, nullptr, 0) == 0);
+
+    enigmacore_stream *stream = enigmacore_stream_new(key, iv, 7);
+    CHECK(stream != nullptr);
+    CHECK(enigmacore_stream_update(stream, data.data(), output.data(), 1000) == 0);
+    CHECK(enigmacore_stream_update(stream, data.data() + 1000, output.data() + 1000, data.size() - 1000) == 0);
+    CHECK(output == reference(material, data, 7));
+    CHECK(enigmacore_stream_update(stream, nullptr, output.data(), 1) == -1);
+    CHECK(enigmacore_stream_update(nullptr, data.data(), output.data(), 1) == -1);
+    enigmacore_stream_free(stream);
+    enigmacore_stream_free(nullptr);
+    CHECK(enigmacore_stream_new(nullptr, iv, 0) == nullptr);
+
+    enigmacore_set_verbose(0);
+    CHECK(writeFile(dir / "c.bin", data));
+    CHECK(enigmacore_encrypt_file((dir / "c.bin").c_str(), (dir / "c.enc").c_str()) == 0);
+    CHECK(enigmacore_decrypt_file((dir / "c.enc").c_str(), (dir / "c.out").c_str()) == 0);
+    CHECK(hasContent(dir / "c.out", data));
+    CHECK(enigmacore_encrypt_file(nullptr, (dir / "c.enc").c_str()) == -1);
+    QuietErrors quiet;
+    CHECK(enigmacore_decrypt_file((dir / "no-existe.enc").c_str(), (dir / "c.out").c_str()) == -1);
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("api");
+
+    testBuffers();
+    testStream();
+    testAesCrypt();
+    testRsaHeader(dir);
+    testCAbi(dir);
+    return finish("api");
+}
@@ -0,0 +1,208 @@
+// Pruebas de la API asíncrona: estado y progreso de los trabajos, cancelación, fallos y co_await (con C++20)
+
+#include "test_util.h"
+#include "enigmacore/async.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Número de hilos del proceso
+static size_t threadCount() {
+    std::error_code ec;
+    size_t count = 0;
+    for (std::filesystem::directory_iterator it("/proc/self/task", ec), last; !ec && it != last; it.increment(ec)) {
+        ++count;
+    }
+    return count;
+}
+
+// Un Job construido por defecto se comporta como uno que ya falló
+static void testDefaultJob() {
+    Job job;
+    CHECK(!job.valid());
+    CHECK(job.status() == JobStatus::Failed);
+    CHECK(!job.wait() && !job.future().get());
+    CHECK(job.processedBytes() == 0 && job.totalBytes() == 0 && job.progress() == 0.0);
+    CHECK(!job.continueWith([] {}));
+    job.cancel();
+}
+
+// Estados, progreso publicado por la tarea y continuaciones
+static void testProgress() {
+    Executor executor(1);
+    CHECK(executor.threadCount() == 1);
+    std::promise<void> reached, release;
+    std::shared_future<void> released = release.get_future().share();
+    Job job = submit(executor, [&reached, released](const ProgressCallback &progress) {
+        if (!progress(50, 100)) return false;
+        reached.set_value();
+        released.wait();
+        return progress(100, 100);
+    });
+    CHECK(job.valid());
+    reached.get_future().wait();
+    CHECK(job.status() == JobStatus::Running);
+    CHECK(job.processedBytes() == 50 && job.totalBytes() == 100 && job.progress() == 0.5);
+
+    std::promise<void> continued;
+    CHECK(job.continueWith([&continued] { continued.set_value(); }));
+    release.set_value();
+    CHECK(job.wait() && job.future().get());
+    CHECK(continued.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    CHECK(job.status() == JobStatus::Succeeded && job.progress() == 1.0);
+    CHECK(!job.continueWith([] {}));
+}
+
+// Cancelación de un trabajo en curso (en su siguiente aviso de progreso) y de uno que aún no empezó
+static void testCancel(const TempDir &dir) {
+    Executor executor(1);
+    std::promise<void> started;
+    Job running = submit(executor, [&started](const ProgressCallback &progress) {
+        started.set_value();
+        while (progress(1, 2)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return false;
+    });
+    started.get_future().wait();
+    running.cancel();
+    CHECK(!running.wait());
+    CHECK(running.status() == JobStatus::Cancelled);
+
+    // El único hilo está ocupado: el cifrado queda en cola, se cancela y nunca crea la salida
+    std::vector<unsigned char> data = randomData(100000, 1);
+    CHECK(writeFile(dir / "queued.bin", data));
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    Job blocker = submit(executor, [released](const ProgressCallback &) {
+        released.wait();
+        return true;
+    });
+    Job queued = encryptAsync(executor, dir / "queued.bin", dir / "queued.enc");
+    CHECK(queued.status() == JobStatus::Pending);
+    queued.cancel();
+    release.set_value();
+    CHECK(blocker.wait());
+    CHECK(!queued.wait());
+    CHECK(queued.status() == JobStatus::Cancelled);
+    CHECK(!std::filesystem::exists(dir / "queued.enc"));
+}
+
+// Un trabajo que falla o lanza cualquier excepción termina como Failed, y el hilo del ejecutor sigue trabajando
+static void testFailures(const TempDir &dir) {
+    Executor executor(1);
+    QuietErrors quiet;
+    Job failed = submit(executor, [](const ProgressCallback &) { return false; });
+    Job thrown = submit(executor, [](const ProgressCallback &) -> bool { throw std::runtime_error("prueba"); });
+    Job unknown = submit(executor, [](const ProgressCallback &) -> bool { throw 7; });
+    executor.post([] { throw 7; });
+    Job missing = decryptAsync(executor, dir / "no-existe.enc", dir / "missing.out");
+    Job after = submit(executor, [](const ProgressCallback &) { return true; });
+    for (const Job &job: {failed, thrown, unknown, missing}) {
+        CHECK(!job.wait());
+        CHECK(job.status() == JobStatus::Failed);
+    }
+    CHECK(after.wait() && after.status() == JobStatus::Succeeded);
+}
+
+// Un archivo grande, que encrypt() procesaría por segmentos en varios hilos, se cifra en el hilo del ejecutor
+static void testLargeFile(const TempDir &dir) {
+    TuningProfile previous = tuningProfile();
+    TuningProfile profile = previous;
+    profile.threads = 4;
+    profile.io = "auto";
+    setTuningProfile(profile);
+
+    // Por encima del tamaño a partir del cual "auto" usa segmentos en paralelo (64 MB)
+    std::vector<unsigned char> block = randomData(1 << 20, 2);
+    std::vector<unsigned char> data;
+    for (int i = 0; i < 65; ++i) data.insert(data.end(), block.begin(), block.end());
+    data.resize(data.size() + 12345, 0x5a);
+    CHECK(writeFile(dir / "large.bin", data));
+
+    Executor executor(1);
+    size_t baseline = threadCount();
+    size_t peak = baseline;
+    Job encrypted = encryptAsync(executor, dir / "large.bin", dir / "large.enc");
+    while (encrypted.status() == JobStatus::Pending || encrypted.status() == JobStatus::Running) {
+        peak = std::max(peak, threadCount());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(encrypted.wait());
+    CHECK(peak == baseline);
+    CHECK(encrypted.processedBytes() == data.size() && encrypted.totalBytes() == data.size());
+
+    Job decrypted = decryptAsync(executor, dir / "large.enc", dir / "large.out");
+    CHECK(decrypted.wait());
+    CHECK(hasContent(dir / "large.out", data));
+    setTuningProfile(previous);
+}
+
+#ifdef ENIGMACORE_HAVE_COROUTINES
+// Corrutina mínima que empieza en cuanto se llama y no devuelve nada
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static Detached awaitJob(Job job, std::promise<bool> &result, std::thread::id &resumedOn) {
+    bool ok = co_await job;
+    resumedOn = std::this_thread::get_id();
+    result.set_value(ok);
+}
+
+// co_await de un trabajo pendiente (se reanuda en el hilo del ejecutor) y de uno ya terminado (sin suspender)
+static void testCoroutines() {
+    Executor executor(1);
+    std::promise<std::thread::id> workerId;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    Job pending = submit(executor, [&workerId, released](const ProgressCallback &) {
+        workerId.set_value(std::this_thread::get_id());
+        released.wait();
+        return true;
+    });
+    std::promise<bool> result;
+    std::thread::id resumedOn;
+    awaitJob(pending, result, resumedOn);
+    std::future<bool> awaited = result.get_future();
+    CHECK(awaited.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+    release.set_value();
+    CHECK(awaited.get());
+    CHECK(resumedOn == workerId.get_future().get());
+
+    QuietErrors quiet;
+    Job failed = submit(executor, [](const ProgressCallback &) { return false; });
+    CHECK(!failed.wait());
+    std::promise<bool> immediate;
+    awaitJob(failed, immediate, resumedOn);
+    CHECK(!immediate.get_future().get());
+    CHECK(resumedOn == std::this_thread::get_id());
+}
+#endif
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("async");
+
+    testDefaultJob();
+    testProgress();
+    testCancel(dir);
+    testFailures(dir);
+    testLargeFile(dir);
+#ifdef ENIGMACORE_HAVE_COROUTINES
+    testCoroutines();
+#else
+    std::cout << "async: sin corrutinas (C++20) en este compilador" << std::endl;
+#endif
+    return finish("async");
+}
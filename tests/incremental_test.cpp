@@ -0,0 +1,128 @@
+// Pruebas del cifrado incremental (directorio con manifiesto y fragmentos definidos por contenido)
+
+#include "test_util.h"
+
+#include <set>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Función para obtener los fragmentos guardados en el directorio de salida
+static std::set<std::string> chunkFiles(const std::string &dir) {
+    std::set<std::string> files;
+    std::error_code ec;
+    for (const auto &entry: std::filesystem::recursive_directory_iterator(dir + "/chunks", ec)) {
+        if (entry.is_regular_file()) files.insert(entry.path().string());
+    }
+    return files;
+}
+
+static void testRoundTrip(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(1 << 20, 1);
+    CHECK(writeFile(dir / "plain.bin", data));
+    CHECK(encryptIncremental(dir / "plain.bin", dir / "store", keystore, "key-0"));
+    CHECK(decryptIncremental(dir / "store", dir / "plain.out", keystore));
+    CHECK(hasContent(dir / "plain.out", data));
+    CHECK(chunkFiles(dir / "store").size() > 1);
+
+    // Un archivo vacío no tiene fragmentos
+    CHECK(writeFile(dir / "empty.bin", {}));
+    CHECK(encryptIncremental(dir / "empty.bin", dir / "empty", keystore, "key-1"));
+    CHECK(decryptIncremental(dir / "empty", dir / "empty.out", keystore));
+    CHECK(hasContent(dir / "empty.out", {}));
+}
+
+// Al volver a cifrar tras una edición local solo cambian los fragmentos cercanos y se borran los que sobran
+static void testLocalEdit(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(2 << 20, 2);
+    CHECK(writeFile(dir / "edit.bin", data));
+    CHECK(encryptIncremental(dir / "edit.bin", dir / "edit", keystore, "key-0"));
+    std::set<std::string> before = chunkFiles(dir / "edit");
+
+    for (size_t i = 0; i < 100; ++i) data[data.size() / 2 + i] ^= 0x5a;
+    CHECK(writeFile(dir / "edit.bin", data));
+    CHECK(encryptIncremental(dir / "edit.bin", dir / "edit", keystore, "key-0"));
+    std::set<std::string> after = chunkFiles(dir / "edit");
+    size_t kept = 0;
+    for (const std::string &file: after) kept += before.count(file);
+    CHECK(kept + 3 >= after.size());
+    CHECK(after.size() + 3 >= before.size());
+
+    CHECK(decryptIncremental(dir / "edit", dir / "edit.out", keystore));
+    CHECK(hasContent(dir / "edit.out", data));
+}
+
+// Un fragmento modificado o que falta hace fallar el descifrado, igual que otro almacén, sin dejar salida
+static void testTamper(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(512 << 10, 3);
+    CHECK(writeFile(dir / "tamper.bin", data));
+    CHECK(encryptIncremental(dir / "tamper.bin", dir / "tamper", keystore, "key-0"));
+    std::set<std::string> chunks = chunkFiles(dir / "tamper");
+    CHECK(chunks.size() > 1);
+    if (chunks.size() < 2) return;
+
+    QuietErrors quiet;
+    flipByte(*chunks.begin(), 100);
+    CHECK(!decryptIncremental(dir / "tamper", dir / "tamper.out", keystore));
+    CHECK(!std::filesystem::exists(dir / "tamper.out"));
+    flipByte(*chunks.begin(), 100);
+    CHECK(decryptIncremental(dir / "tamper", dir / "tamper.out", keystore));
+
+    std::filesystem::remove(*chunks.rbegin());
+    CHECK(!decryptIncremental(dir / "tamper", dir / "tamper.out", keystore));
+    CHECK(!std::filesystem::exists(dir / "tamper.out"));
+
+    Keystore other;
+    CHECK(makeKeystore(dir / "other.eks") && other.open(dir / "other.eks"));
+    CHECK(!decryptIncremental(dir / "tamper", dir / "tamper.out", other));
+}
+
+// Manifiestos dañados: se rechazan al descifrar y al volver a cifrar sobre ellos
+static void testMalformedManifest(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(256 << 10, 4);
+    CHECK(writeFile(dir / "bad.bin", data));
+    CHECK(encryptIncremental(dir / "bad.bin", dir / "bad", keystore, "key-1"));
+    std::string manifestPath = dir / "bad/manifest.txt";
+    std::string manifest = readText(manifestPath);
+    size_t chunkLine = manifest.find("chunk ");
+    CHECK(chunkLine != std::string::npos);
+    std::string chunkId = manifest.substr(chunkLine + 6, 64);
+
+    const std::vector<std::string> damaged = {
+            replaceLine(manifest, "ENIGMACORE-CDC", "ENIGMACORE-CDC 9"),
+            replaceLine(manifest, "key-id", "key-id key-7"),
+            replaceLine(manifest, "key-id", "clave key-1"),
+            replaceLine(manifest, "wrapped-key", "wrapped-key abc"),
+            replaceLine(manifest, "wrapped-key", "wrapped-key " + std::string(64, '0')),
+            replaceLine(manifest, "size", "size muchos"),
+            replaceLine(manifest, "chunk", "chunk " + chunkId.substr(0, 10) + " 1024"),
+            replaceLine(manifest, "chunk", "chunk " + chunkId + " 999999999"),
+            replaceLine(manifest, "chunk", "chunk " + std::string(64, 'a') + " 1024"),
+            manifest + "basura x 1\n",
+            "",
+    };
+    QuietErrors quiet;
+    for (const std::string &text: damaged) {
+        CHECK(writeText(manifestPath, text));
+        CHECK(!decryptIncremental(dir / "bad", dir / "bad.out", keystore));
+    }
+
+    // Sobre un manifiesto ilegible no se vuelve a cifrar: se perdería la clave de los fragmentos
+    CHECK(writeText(manifestPath, damaged[0]));
+    CHECK(!encryptIncremental(dir / "bad.bin", dir / "bad", keystore, "key-1"));
+    CHECK(readText(manifestPath) == damaged[0]);
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    Keystore keystore;
+    CHECK(dir.valid() && makeKeystore(dir / "keys.eks") && keystore.open(dir / "keys.eks"));
+    if (failures()) return finish("incremental");
+
+    testRoundTrip(dir, keystore);
+    testLocalEdit(dir, keystore);
+    testTamper(dir, keystore);
+    testMalformedManifest(dir, keystore);
+    return finish("incremental");
+}
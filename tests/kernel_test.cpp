@@ -0,0 +1,183 @@
+// Pruebas del cifrado en el kernel (cipher=kernel, AF_ALG con splice), de su alternativa con OpenSSL y de las
+// instanciaciones del motor de archivos. Sin AF_ALG o sin "ctr(aes)" en el kernel se usa OpenSSL, así que el
+// resultado tiene que ser el mismo en ambos casos: se compara con el formato básico calculado aparte.
+
+#include "test_util.h"
+#include "internal.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Tamaño de la cabecera del formato básico (clave e IV en claro) y periodo de su keystream
+const size_t kHeaderSize = 32 + 16;
+const size_t kPeriod = 4096;
+
+// Función para comprobar que 'container' cifra 'data' en el formato básico: el contador vuelve a empezar en
+// el IV cada 4096 bytes
+static bool isBasicEncryption(const std::vector<unsigned char> &container, const std::vector<unsigned char> &data) {
+    if (container.size() != kHeaderSize + data.size()) return false;
+    std::vector<unsigned char> zeros(kPeriod, 0), keystream(kPeriod);
+    if (!aesCtrAt(zeros.data(), zeros.size(), container.data(), container.data() + 32, 0, keystream.data())) {
+        return false;
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (container[kHeaderSize + i] != (data[i] ^ keystream[i % kPeriod])) return false;
+    }
+    return true;
+}
+
+static TuningProfile profileWith(const std::string &cipher, const std::string &io, size_t chunkSize) {
+    TuningProfile profile;
+    profile.cipher = cipher;
+    profile.io = io;
+    profile.chunk_size = chunkSize;
+    profile.threads = 3;
+    return profile;
+}
+
+// Cifrar con un motor y descifrar con el otro, con segmentos alineados o no con el periodo del keystream
+static void testCrossRoundTrip(const TempDir &dir) {
+    const std::vector<size_t> sizes = {0, 1, kPeriod - 1, kPeriod, 3 * kPeriod + 7, (1 << 20) + 333};
+    for (size_t size: sizes) {
+        std::vector<unsigned char> data = randomData(size, static_cast<uint32_t>(size));
+        CHECK(writeFile(dir / "plain.bin", data));
+        for (const char *io: {"stream", "pread", "mmap", "auto"}) {
+            for (size_t chunkSize: {kPeriod, size_t(5000), size_t(1) << 20}) {
+                for (const char *cipher: {"kernel", "openssl"}) {
+                    const char *other = std::strcmp(cipher, "kernel") == 0 ? "openssl" : "kernel";
+                    setTuningProfile(profileWith(cipher, io, chunkSize));
+                    CHECK(encrypt(dir / "plain.bin", dir / "plain.enc"));
+                    CHECK(isBasicEncryption(readFile(dir / "plain.enc"), data));
+                    setTuningProfile(profileWith(other, io, chunkSize));
+                    CHECK(decrypt(dir / "plain.enc", dir / "plain.out"));
+                    CHECK(hasContent(dir / "plain.out", data));
+                }
+            }
+        }
+    }
+}
+
+// Cada instanciación del motor que se compiló (E/S por bloques, con y sin informe de progreso, pread, mmap y
+// kernel; cifrado y descifrado; cabecera básica y RSA) hace la ida y la vuelta con la de referencia (bloques
+// sin progreso y OpenSSL), de modo que cada dirección se comprueba por separado
+static void testInstantiations(const TempDir &dir) {
+    EVP_PKEY *pkey = EVP_RSA_gen(2048);
+    CHECK(pkey != nullptr);
+    if (!pkey) return;
+    FILE *publicFile = fopen((dir / "public.pem").c_str(), "wb");
+    FILE *privateFile = fopen((dir / "private.pem").c_str(), "wb");
+    CHECK(publicFile && PEM_write_PUBKEY(publicFile, pkey) == 1);
+    CHECK(privateFile && PEM_write_PrivateKey(privateFile, pkey, nullptr, nullptr, 0, nullptr, nullptr) == 1);
+    if (publicFile) fclose(publicFile);
+    if (privateFile) fclose(privateFile);
+    EVP_PKEY_free(pkey);
+
+    std::vector<unsigned char> data = randomData((1 << 20) + 333, 3);
+    CHECK(writeFile(dir / "engine.bin", data));
+    const TuningProfile reference = profileWith("openssl", "stream", 5000);
+    ProgressCallback reporting = [](uint64_t, uint64_t) { return true; };
+    for (const char *io: {"stream", "pread", "mmap"}) {
+        for (const char *cipher: {"openssl", "kernel"}) {
+            const TuningProfile engine = profileWith(cipher, io, 5000);
+            for (const ProgressCallback &progress: {ProgressCallback(), reporting}) {
+                setTuningProfile(engine);
+                CHECK(encrypt(dir / "engine.bin", dir / "engine.enc", progress));
+                CHECK(isBasicEncryption(readFile(dir / "engine.enc"), data));
+                setTuningProfile(reference);
+                CHECK(decrypt(dir / "engine.enc", dir / "engine.out"));
+                CHECK(hasContent(dir / "engine.out", data));
+
+                CHECK(encrypt(dir / "engine.bin", dir / "engine.enc"));
+                setTuningProfile(engine);
+                CHECK(decrypt(dir / "engine.enc", dir / "engine.out", progress));
+                CHECK(hasContent(dir / "engine.out", data));
+            }
+
+            // El formato RSA no informa del progreso
+            setTuningProfile(engine);
+            CHECK(encryptRSA(dir / "engine.bin", dir / "engine.rsa", dir / "public.pem"));
+            setTuningProfile(reference);
+            CHECK(decryptRSA(dir / "engine.rsa", dir / "engine.out", dir / "private.pem"));
+            CHECK(hasContent(dir / "engine.out", data));
+
+            CHECK(encryptRSA(dir / "engine.bin", dir / "engine.rsa", dir / "public.pem"));
+            setTuningProfile(engine);
+            CHECK(decryptRSA(dir / "engine.rsa", dir / "engine.out", dir / "private.pem"));
+            CHECK(hasContent(dir / "engine.out", data));
+        }
+    }
+}
+
+// Con informe de progreso se cifra con OpenSSL; si se cancela no queda salida
+static void testProgress(const TempDir &dir) {
+    std::vector<unsigned char> data = randomData(5 * kPeriod + 1, 1);
+    CHECK(writeFile(dir / "progress.bin", data));
+    setTuningProfile(profileWith("kernel", "pread", kPeriod));
+    uint64_t reported = 0;
+    CHECK(encrypt(dir / "progress.bin", dir / "progress.enc", [&](uint64_t processed, uint64_t total) {
+        reported = processed;
+        return total == data.size();
+    }));
+    CHECK(reported == data.size());
+    CHECK(isBasicEncryption(readFile(dir / "progress.enc"), data));
+
+    CHECK(!decrypt(dir / "progress.enc", dir / "progress.out", [](uint64_t, uint64_t) { return false; }));
+    CHECK(!std::filesystem::exists(dir / "progress.out"));
+}
+
+// El formato no está autenticado: un byte modificado cambia solo ese byte. Las cabeceras incompletas no se
+// descifran con ningún motor.
+static void testTamper(const TempDir &dir) {
+    std::vector<unsigned char> data = randomData(10 * kPeriod + 3, 2);
+    CHECK(writeFile(dir / "tamper.bin", data));
+    for (const char *cipher: {"kernel", "openssl"}) {
+        setTuningProfile(profileWith(cipher, "pread", kPeriod));
+        CHECK(encrypt(dir / "tamper.bin", dir / "tamper.enc"));
+        flipByte(dir / "tamper.enc", kHeaderSize + 7 * kPeriod + 5);
+        CHECK(decrypt(dir / "tamper.enc", dir / "tamper.out"));
+        std::vector<unsigned char> expected = data;
+        expected[7 * kPeriod + 5] = static_cast<unsigned char>(~expected[7 * kPeriod + 5]);
+        CHECK(hasContent(dir / "tamper.out", expected));
+
+        std::vector<unsigned char> container = readFile(dir / "tamper.enc");
+        CHECK(writeFile(dir / "short.enc", std::vector<unsigned char>(container.begin(), container.begin() + 40)));
+        QuietErrors quiet;
+        CHECK(!decrypt(dir / "short.enc", dir / "short.out"));
+        CHECK(!decrypt(dir / "no-existe.enc", dir / "short.out"));
+    }
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("kernel");
+
+    // Sin AF_ALG todas las pruebas con cipher=kernel ejercitan la alternativa con OpenSSL
+    if (kernelCryptoAvailable()) {
+        std::cout << "kernel: AF_ALG con ctr(aes) disponible, se prueba el cifrado en el kernel" << std::endl;
+    } else {
+        int fd = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        int error = errno;
+        std::string reason = fd < 0 ? "AF_ALG: " + std::string(std::strerror(error)) + ", errno " +
+                                      std::to_string(error)
+                                    : "sin ctr(aes) o sin compilar";
+        if (fd >= 0) close(fd);
+        std::cout << "kernel: cifrado en el kernel no disponible (" << reason
+                << "), solo se prueba la alternativa con OpenSSL" << std::endl;
+    }
+
+    testCrossRoundTrip(dir);
+    testInstantiations(dir);
+    testProgress(dir);
+    testTamper(dir);
+    setTuningProfile(TuningProfile());
+    return finish("kernel");
+}
@@ -0,0 +1,281 @@
+// Pruebas del formato con llave del almacén (fragmentos AES-256-GCM y resumen del contenido) y de la caché de
+// llaves del almacén
+
+#include "test_util.h"
+
+#include <cstring>
+#include <thread>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Posiciones de una cabecera: tras el magic van el identificador y la envoltura, cada uno con su longitud,
+// y después el tamaño de fragmento y el tamaño original
+struct Layout {
+    size_t idLen, wrappedLen, chunkSize, plainSize, data;
+};
+
+static Layout layoutOf(const std::vector<unsigned char> &container) {
+    Layout layout;
+    layout.idLen = 8;
+    layout.wrappedLen = layout.idLen + 8 + getU64(container, layout.idLen);
+    layout.chunkSize = layout.wrappedLen + 8 + getU64(container, layout.wrappedLen);
+    layout.plainSize = layout.chunkSize + 8;
+    layout.data = layout.plainSize + 8;
+    return layout;
+}
+
+// Fija el tamaño de los fragmentos de los archivos que se cifren a continuación
+static void useChunkSize(size_t chunkSize) {
+    TuningProfile profile;
+    profile.chunk_size = chunkSize;
+    setTuningProfile(profile);
+}
+
+static void testRoundTrip(const TempDir &dir, const Keystore &keystore) {
+    useChunkSize(4096);
+    // Varios fragmentos con el último parcial, un múltiplo exacto y un archivo vacío (solo el resumen)
+    for (size_t size: {10000, 8192, 1, 0}) {
+        std::vector<unsigned char> data = randomData(size, static_cast<uint32_t>(size));
+        CHECK(writeFile(dir / "plain.bin", data));
+        CHECK(encryptKeyed(dir / "plain.bin", dir / "plain.enc", keystore, "key-0"));
+        std::vector<unsigned char> container = readFile(dir / "plain.enc");
+        Layout layout = layoutOf(container);
+        CHECK(std::memcmp(container.data(), "ENIGKEY2", 8) == 0);
+        CHECK(getU64(container, layout.chunkSize) == 4096 && getU64(container, layout.plainSize) == size);
+        CHECK(container.size() == layout.data + size + (size + 4095) / 4096 * 16 + 32 + 16);
+
+        CHECK(decryptKeyed(dir / "plain.enc", dir / "plain.out", keystore));
+        CHECK(hasContent(dir / "plain.out", data));
+        CHECK(verifyKeyed(dir / "plain.enc", dir / "plain.bin", keystore));
+        CHECK(verifyIntegrity(dir / "plain.enc", keystore, false));
+        CHECK(verifyIntegrity(dir / "plain.enc", keystore, true));
+    }
+
+    // Comparación con un original distinto
+    std::vector<unsigned char> data = randomData(10000, 1);
+    CHECK(writeFile(dir / "plain.bin", data));
+    CHECK(encryptKeyed(dir / "plain.bin", dir / "plain.enc", keystore, "key-1"));
+    QuietErrors quiet;
+    data[9999] ^= 1;
+    CHECK(writeFile(dir / "changed.bin", data));
+    CHECK(!verifyKeyed(dir / "plain.enc", dir / "changed.bin", keystore));
+    data.pop_back();
+    CHECK(writeFile(dir / "changed.bin", data));
+    CHECK(!verifyKeyed(dir / "plain.enc", dir / "changed.bin", keystore));
+    CHECK(!verifyKeyed(dir / "plain.enc", dir / "no-existe.bin", keystore));
+
+    // Llave que no está en el almacén, o almacén sin la llave con la que se cifró
+    CHECK(!encryptKeyed(dir / "plain.bin", dir / "unknown.enc", keystore, "key-7"));
+    CHECK(!std::filesystem::exists(dir / "unknown.enc"));
+    Keystore other;
+    CHECK(makeKeystore(dir / "other.eks") && other.open(dir / "other.eks"));
+    CHECK(!decryptKeyed(dir / "plain.enc", dir / "other.out", other));
+    CHECK(!std::filesystem::exists(dir / "other.out"));
+    CHECK(!verifyIntegrity(dir / "plain.enc", other, true));
+}
+
+// Un tamaño de bloque del perfil fuera de lo que acepta la lectura se ajusta al escribir: el archivo siempre se
+// puede descifrar
+static void testChunkLimits(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(5000, 7);
+    CHECK(writeFile(dir / "limits.bin", data));
+    for (uint64_t chunkSize: {uint64_t(1), kMaxChunkSize + 1, uint64_t(1) << 40}) {
+        useChunkSize(static_cast<size_t>(chunkSize));
+        CHECK(encryptKeyed(dir / "limits.bin", dir / "limits.enc", keystore, "key-0"));
+        std::vector<unsigned char> container = readFile(dir / "limits.enc");
+        uint64_t written = getU64(container, layoutOf(container).chunkSize);
+        CHECK(written == (chunkSize == 1 ? 4096 : kMaxChunkSize));
+        CHECK(decryptKeyed(dir / "limits.enc", dir / "limits.out", keystore));
+        CHECK(hasContent(dir / "limits.out", data));
+    }
+}
+
+// Cualquier cambio en los fragmentos, sus etiquetas o el resumen hace fallar el descifrado sin dejar salida
+static void testTamper(const TempDir &dir, const Keystore &keystore) {
+    useChunkSize(4096);
+    std::vector<unsigned char> data = randomData(3 * 4096 + 100, 2);
+    CHECK(writeFile(dir / "tamper.bin", data));
+    CHECK(encryptKeyed(dir / "tamper.bin", dir / "tamper.enc", keystore, "key-0"));
+    const std::vector<unsigned char> container = readFile(dir / "tamper.enc");
+    Layout layout = layoutOf(container);
+    const size_t sealedChunk = 4096 + 16, digest = container.size() - 48;
+
+    std::vector<std::vector<unsigned char>> damaged;
+    for (size_t offset: {layout.data + 10, layout.data + sealedChunk + 4096, layout.data + 3 * sealedChunk + 99,
+                         digest, container.size() - 1}) {
+        std::vector<unsigned char> bytes = container;
+        bytes[offset] ^= 1; // datos, etiqueta del fragmento 1, último fragmento, resumen y etiqueta del resumen
+        damaged.push_back(bytes);
+    }
+    // Fragmentos intercambiados y fragmento quitado
+    std::vector<unsigned char> bytes = container;
+    std::swap_ranges(bytes.begin() + layout.data, bytes.begin() + layout.data + sealedChunk,
+                     bytes.begin() + layout.data + sealedChunk);
+    damaged.push_back(bytes);
+    bytes = container;
+    bytes.erase(bytes.begin() + layout.data + sealedChunk, bytes.begin() + layout.data + 2 * sealedChunk);
+    putU64(bytes, layout.plainSize, data.size() - 4096);
+    damaged.push_back(bytes);
+
+    QuietErrors quiet;
+    for (const std::vector<unsigned char> &variantBytes: damaged) {
+        CHECK(writeFile(dir / "damaged.enc", variantBytes));
+        CHECK(!decryptKeyed(dir / "damaged.enc", dir / "damaged.out", keystore));
+        CHECK(!std::filesystem::exists(dir / "damaged.out"));
+        CHECK(!verifyIntegrity(dir / "damaged.enc", keystore, true));
+        CHECK(!verifyKeyed(dir / "damaged.enc", dir / "tamper.bin", keystore));
+    }
+
+    // La auditoría marca el archivo dañado entre los buenos
+    std::filesystem::create_directories(dir / "audit/sub");
+    std::filesystem::copy_file(dir / "tamper.enc", dir / "audit/a.enc");
+    std::filesystem::copy_file(dir / "tamper.enc", dir / "audit/sub/b.enc");
+    AuditOptions options;
+    options.check_digest = true;
+    CHECK(auditFiles({dir / "audit"}, keystore, options));
+    CHECK(writeFile(dir / "audit/sub/c.enc", damaged[0]));
+    CHECK(!auditFiles({dir / "audit"}, keystore, options));
+}
+
+// Cabeceras dañadas: se rechazan antes de reservar memoria o crear la salida
+static void testMalformed(const TempDir &dir, const Keystore &keystore) {
+    useChunkSize(4096);
+    std::vector<unsigned char> data = randomData(10000, 3);
+    CHECK(writeFile(dir / "bad.bin", data));
+    CHECK(encryptKeyed(dir / "bad.bin", dir / "bad.enc", keystore, "key-1"));
+    const std::vector<unsigned char> container = readFile(dir / "bad.enc");
+    Layout layout = layoutOf(container);
+
+    std::vector<std::vector<unsigned char>> damaged;
+    auto variant = [&](size_t offset, uint64_t value) {
+        std::vector<unsigned char> bytes = container;
+        putU64(bytes, offset, value);
+        damaged.push_back(bytes);
+    };
+    std::vector<unsigned char> bytes = container;
+    bytes[7] = 'X'; // magic
+    damaged.push_back(bytes);
+    bytes = container;
+    bytes[layout.idLen + 8 + 4] = '9'; // llave "key-9", que no está en el almacén
+    damaged.push_back(bytes);
+    variant(layout.idLen, 2000);              // identificador demasiado largo
+    variant(layout.idLen, 4);
+    variant(layout.idLen, ~0ULL);
+    variant(layout.wrappedLen, 64 * 1024 + 1); // envoltura demasiado larga
+    variant(layout.wrappedLen, getU64(container, layout.wrappedLen) - 1);
+    variant(layout.chunkSize, 1024);           // fragmentos fuera de rango
+    variant(layout.chunkSize, 1ULL << 31);
+    variant(layout.chunkSize, 8192);           // en rango, pero no coincide con el archivo
+    variant(layout.plainSize, ~0ULL);          // tamaños falsos que desbordarían
+    variant(layout.plainSize, ~0ULL - 4095);
+    variant(layout.plainSize, 1ULL << 62);
+    variant(layout.plainSize, data.size() + 1);
+    // Tamaños coherentes con el archivo (dos fragmentos de 5000 y 10016 bytes), pero no los autenticados
+    bytes = container;
+    putU64(bytes, layout.chunkSize, 5000);
+    putU64(bytes, layout.plainSize, data.size() + 16);
+    damaged.push_back(bytes);
+    damaged.emplace_back(container.begin(), container.end() - 1); // truncado
+    damaged.emplace_back(container.begin(), container.begin() + layout.data); // solo la cabecera
+    damaged.emplace_back(container.begin(), container.begin() + layout.plainSize + 3); // cabecera incompleta
+    damaged.emplace_back(container.begin(), container.begin() + 4);
+    bytes = container;
+    bytes.push_back(0); // datos de más
+    damaged.push_back(bytes);
+
+    QuietErrors quiet;
+    for (const std::vector<unsigned char> &variantBytes: damaged) {
+        CHECK(writeFile(dir / "damaged.enc", variantBytes));
+        CHECK(!decryptKeyed(dir / "damaged.enc", dir / "damaged.out", keystore));
+        CHECK(!std::filesystem::exists(dir / "damaged.out"));
+        CHECK(!verifyIntegrity(dir / "damaged.enc", keystore, true));
+    }
+    CHECK(!decryptKeyed(dir / "no-existe.enc", dir / "damaged.out", keystore));
+}
+
+// Archivos grandes: los fragmentos se reparten entre hilos, y un fragmento dañado detiene el reparto
+static void testParallel(const TempDir &dir, const Keystore &keystore) {
+    useChunkSize(1 << 20);
+    std::vector<unsigned char> data = randomData((64 << 20) + 12345, 4);
+    CHECK(writeFile(dir / "large.bin", data));
+    CHECK(encryptKeyed(dir / "large.bin", dir / "large.enc", keystore, "key-0"));
+    CHECK(decryptKeyed(dir / "large.enc", dir / "large.out", keystore));
+    CHECK(hasContent(dir / "large.out", data));
+    CHECK(verifyIntegrity(dir / "large.enc", keystore, true));
+    std::filesystem::remove(dir / "large.out");
+
+    std::vector<unsigned char> container = readFile(dir / "large.enc");
+    flipByte(dir / "large.enc", layoutOf(container).data + 40 * ((1 << 20) + 16) + 5);
+    QuietErrors quiet;
+    CHECK(!decryptKeyed(dir / "large.enc", dir / "large.out", keystore));
+    CHECK(!std::filesystem::exists(dir / "large.out"));
+    CHECK(!verifyIntegrity(dir / "large.enc", keystore, false));
+}
+
+// Cada llave se interpreta una vez y la comparten los hilos que cifran y descifran a la vez. Al abrir otro
+// almacén se olvidan las llaves del anterior, aunque tengan los mismos identificadores.
+static void testKeyCache(const TempDir &dir) {
+    useChunkSize(4096);
+    Keystore keystore;
+    CHECK(makeKeystore(dir / "cache.eks") && keystore.open(dir / "cache.eks"));
+    std::vector<unsigned char> data = randomData(10000, 5);
+    CHECK(writeFile(dir / "cache.bin", data));
+
+    bool threadOk[8] = {true, true, true, true, true, true, true, true};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 8; ++i) {
+        threads.emplace_back([&, i] {
+            std::string name = dir / ("cache-" + std::to_string(i));
+            std::string keyId = "key-" + std::to_string(i % 2);
+            for (int round = 0; round < 10; ++round) {
+                threadOk[i] = encryptKeyed(dir / "cache.bin", name + ".enc", keystore, keyId) &&
+                              decryptKeyed(name + ".enc", name + ".out", keystore) && hasContent(name + ".out", data) &&
+                              threadOk[i];
+            }
+        });
+    }
+    for (std::thread &thread: threads) thread.join();
+    for (bool result: threadOk) CHECK(result);
+
+    CHECK(makeKeystore(dir / "other.eks") && keystore.open(dir / "other.eks"));
+    QuietErrors quiet;
+    CHECK(!decryptKeyed(dir / "cache-0.enc", dir / "cache-0.out", keystore));
+    CHECK(keystore.open(dir / "cache.eks"));
+    CHECK(decryptKeyed(dir / "cache-0.enc", dir / "cache-0.out", keystore) && hasContent(dir / "cache-0.out", data));
+}
+
+// Los archivos de la primera versión del formato, sin autenticar, ya no se aceptan
+static void testVersion1(const TempDir &dir, const Keystore &keystore) {
+    useChunkSize(4096);
+    std::vector<unsigned char> data = randomData(20000, 6);
+    CHECK(writeFile(dir / "v1.bin", data));
+    CHECK(encryptKeyed(dir / "v1.bin", dir / "v1.enc", keystore, "key-1"));
+    std::vector<unsigned char> container = readFile(dir / "v1.enc");
+    std::memcpy(container.data(), "ENIGKEYD", 8);
+    CHECK(writeFile(dir / "v1.enc", container));
+
+    QuietErrors quiet;
+    CHECK(!decryptKeyed(dir / "v1.enc", dir / "v1.out", keystore));
+    CHECK(!std::filesystem::exists(dir / "v1.out"));
+    CHECK(!verifyKeyed(dir / "v1.enc", dir / "v1.bin", keystore));
+    CHECK(!verifyIntegrity(dir / "v1.enc", keystore, false));
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    Keystore keystore;
+    CHECK(dir.valid() && makeKeystore(dir / "keys.eks") && keystore.open(dir / "keys.eks"));
+    if (failures()) return finish("keyed");
+
+    testRoundTrip(dir, keystore);
+    testChunkLimits(dir, keystore);
+    testTamper(dir, keystore);
+    testMalformed(dir, keystore);
+    testParallel(dir, keystore);
+    testKeyCache(dir);
+    testVersion1(dir, keystore);
+    setTuningProfile(TuningProfile());
+    return finish("keyed");
+}
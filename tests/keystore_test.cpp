@@ -0,0 +1,163 @@
+// Pruebas del almacén de claves (cabecera, tabla hash de identificadores y registros con las llaves en DER)
+
+#include "test_util.h"
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <sys/stat.h>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Tamaño de la cabecera (magic, número de llaves y de huecos) y de cada hueco de la tabla (hash y posición)
+const size_t kHeaderSize = 8 + 8 + 8;
+const size_t kSlotSize = 8 + 8;
+
+// Función para comprobar que las vistas DER de una llave se pueden interpretar
+static bool parses(const KeystoreEntry &entry) {
+    const unsigned char *publicDer = entry.public_der.data, *privateDer = entry.private_der.data;
+    EVP_PKEY *publicKey = d2i_PUBKEY(nullptr, &publicDer, static_cast<long>(entry.public_der.size));
+    EVP_PKEY *privateKey = d2i_AutoPrivateKey(nullptr, &privateDer, static_cast<long>(entry.private_der.size));
+    bool ok = publicKey && privateKey && EVP_PKEY_eq(publicKey, privateKey) == 1;
+    EVP_PKEY_free(publicKey);
+    EVP_PKEY_free(privateKey);
+    return ok;
+}
+
+static void testGenerate(const TempDir &dir) {
+    KeygenOptions options;
+    options.type = KeyType::EC;
+    options.prefix = "cliente-";
+    options.threads = 2;
+    CHECK(generateKeystore(dir / "ec.eks", 40, options));
+    CHECK(!std::filesystem::exists(dir / "ec.eks.tmp"));
+    struct stat st;
+    CHECK(stat((dir / "ec.eks").c_str(), &st) == 0 && (st.st_mode & 0777) == 0600);
+
+    Keystore keystore;
+    CHECK(keystore.open(dir / "ec.eks"));
+    CHECK(keystore.size() == 40);
+    for (int i = 0; i < 40; ++i) {
+        KeystoreEntry entry;
+        CHECK(keystore.find("cliente-" + std::to_string(i), entry));
+        CHECK(entry.type == KeyType::EC && parses(entry));
+    }
+    KeystoreEntry entry;
+    CHECK(!keystore.find("cliente-40", entry));
+    CHECK(!keystore.find("key-0", entry));
+    CHECK(!keystore.find("", entry));
+
+    // Un almacén sin abrir no encuentra nada; al abrir otro se sustituye el anterior
+    Keystore closed;
+    CHECK(!closed.find("cliente-0", entry));
+    options = KeygenOptions();
+    CHECK(generateKeystore(dir / "rsa.eks", 1, options));
+    CHECK(keystore.open(dir / "rsa.eks"));
+    CHECK(keystore.size() == 1);
+    CHECK(keystore.find("key-0", entry) && entry.type == KeyType::RSA && parses(entry));
+    CHECK(!keystore.find("cliente-0", entry));
+
+    // Parámetros no válidos: no se crea el archivo
+    QuietErrors quiet;
+    CHECK(!generateKeystore(dir / "none.eks", 0, options));
+    options.rsa_bits = 1024;
+    CHECK(!generateKeystore(dir / "none.eks", 1, options));
+    options = KeygenOptions();
+    options.type = KeyType::EC;
+    options.curve = "curva-inventada";
+    CHECK(!generateKeystore(dir / "none.eks", 2, options));
+    CHECK(!std::filesystem::exists(dir / "none.eks"));
+}
+
+// Cabeceras dañadas: el almacén no se abre
+static void testMalformedHeader(const TempDir &dir) {
+    CHECK(makeKeystore(dir / "bad.eks"));
+    const std::vector<unsigned char> store = readFile(dir / "bad.eks");
+    uint64_t slots = getU64(store, 16);
+
+    std::vector<std::vector<unsigned char>> damaged;
+    auto variant = [&](size_t offset, uint64_t value) {
+        std::vector<unsigned char> bytes = store;
+        putU64(bytes, offset, value);
+        damaged.push_back(bytes);
+    };
+    std::vector<unsigned char> bytes = store;
+    bytes[0] = 'X'; // magic
+    damaged.push_back(bytes);
+    variant(8, slots + 1);    // más llaves que huecos
+    variant(16, 0);           // sin huecos
+    variant(16, slots + 1);   // no es potencia de dos
+    variant(16, 1ULL << 40);  // la tabla no cabe en el archivo
+    variant(16, 1ULL << 63);
+    damaged.emplace_back(store.begin(), store.begin() + kHeaderSize + slots * kSlotSize - 1); // tabla incompleta
+    damaged.emplace_back(store.begin(), store.begin() + kHeaderSize - 1); // cabecera incompleta
+    damaged.emplace_back();
+
+    QuietErrors quiet;
+    for (const std::vector<unsigned char> &variantBytes: damaged) {
+        CHECK(writeFile(dir / "damaged.eks", variantBytes));
+        Keystore keystore;
+        CHECK(!keystore.open(dir / "damaged.eks"));
+        CHECK(keystore.size() == 0);
+    }
+    Keystore keystore;
+    CHECK(!keystore.open(dir / "no-existe.eks"));
+    std::filesystem::create_directory(dir / "directorio.eks");
+    CHECK(!keystore.open(dir / "directorio.eks"));
+}
+
+// Registros dañados: el almacén se abre, pero las llaves afectadas no se encuentran
+static void testMalformedRecords(const TempDir &dir) {
+    CHECK(makeKeystore(dir / "records.eks"));
+    const std::vector<unsigned char> store = readFile(dir / "records.eks");
+    uint64_t slots = getU64(store, 16);
+    std::vector<size_t> records;
+    for (uint64_t slot = 0; slot < slots; ++slot) {
+        uint64_t offset = getU64(store, kHeaderSize + slot * kSlotSize + 8);
+        if (offset) records.push_back(kHeaderSize + slot * kSlotSize + 8);
+    }
+    CHECK(records.size() == 2);
+
+    // Cambia el campo 'field' de todos los registros, o su posición en la tabla si 'field' es negativo
+    auto damage = [&](int field, uint64_t value) {
+        std::vector<unsigned char> bytes = store;
+        for (size_t position: records) {
+            if (field < 0) {
+                putU64(bytes, position, value);
+            } else {
+                putU64(bytes, getU64(store, position) + 8 * field, value);
+            }
+        }
+        return bytes;
+    };
+    const std::vector<std::vector<unsigned char>> damaged = {
+            damage(-1, store.size()),     // registro fuera del archivo
+            damage(-1, store.size() - 8), // registro incompleto
+            damage(-1, ~0ULL),
+            damage(0, store.size()),      // longitud del identificador
+            damage(0, ~0ULL),
+            damage(1, 9),                 // tipo de llave
+            damage(2, ~0ULL - 10),        // longitud de la llave pública
+            damage(3, store.size()),      // longitud de la llave privada
+    };
+    for (const std::vector<unsigned char> &bytes: damaged) {
+        CHECK(writeFile(dir / "damaged.eks", bytes));
+        Keystore keystore;
+        CHECK(keystore.open(dir / "damaged.eks"));
+        KeystoreEntry entry;
+        CHECK(!keystore.find("key-0", entry));
+        CHECK(!keystore.find("key-1", entry));
+    }
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("keystore");
+
+    testGenerate(dir);
+    testMalformedHeader(dir);
+    testMalformedRecords(dir);
+    return finish("keystore");
+}
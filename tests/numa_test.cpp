@@ -0,0 +1,177 @@
+// Pruebas del reparto en paralelo por nodos NUMA (parallelForNodes) con su conjunto persistente de hilos. En un
+// equipo de un solo nodo comprueban el funcionamiento, no la afinidad.
+
+#include "test_util.h"
+#include "internal.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Número de hilos del proceso
+static size_t threadCount() {
+    std::error_code ec;
+    size_t count = 0;
+    for (std::filesystem::directory_iterator it("/proc/self/task", ec), last; !ec && it != last; it.increment(ec)) {
+        ++count;
+    }
+    return count;
+}
+
+// Función para comprobar que cada índice se procesa exactamente una vez
+static bool coversOnce(size_t count, size_t threads) {
+    std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[count + 1]);
+    for (size_t i = 0; i <= count; ++i) visits[i] = 0;
+    bool ok = parallelForNodes(count, threads, [&](size_t index) {
+        ++visits[index];
+        return true;
+    });
+    for (size_t i = 0; i < count; ++i) ok = ok && visits[i] == 1;
+    return ok && visits[count] == 0;
+}
+
+// Los hilos se crean en la primera llamada y se reutilizan en las siguientes
+static void testPersistentPool() {
+    size_t baseline = threadCount();
+    CHECK(coversOnce(100, 4));
+    size_t created = threadCount();
+    // Quien llama trabaja como uno de los cuatro: tres ayudantes
+    CHECK(created == baseline + 3);
+    CHECK(coversOnce(1000, 4));
+    CHECK(coversOnce(50, 2));
+    CHECK(threadCount() == created);
+}
+
+static void testCoverage() {
+    CHECK(!numaNodes().empty());
+    for (size_t count: {size_t(0), size_t(1), size_t(7), size_t(1000)}) {
+        for (size_t threads: {size_t(1), size_t(3), size_t(8)}) CHECK(coversOnce(count, threads));
+    }
+
+    // Cada hilo tiene su propio buffer, del tamaño pedido
+    const size_t bytes = 64 << 10;
+    std::mutex mutex;
+    std::set<unsigned char *> buffers;
+    CHECK(parallelForNodes(200, 4, [&](size_t index) {
+        unsigned char *buffer = workerBuffer(bytes);
+        std::memset(buffer, static_cast<int>(index), bytes);
+        for (size_t i = 0; i < bytes; i += 4096) {
+            if (buffer[i] != static_cast<unsigned char>(index)) return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.insert(buffer);
+        return true;
+    }, bytes));
+    CHECK(!buffers.empty() && buffers.size() <= 4);
+}
+
+// Una tarea que falla o lanza una excepción detiene el reparto y la llamada devuelve false
+static void testFailures() {
+    std::atomic<size_t> calls{0};
+    CHECK(!parallelForNodes(10000, 4, [&](size_t index) {
+        ++calls;
+        return index != 10;
+    }));
+    CHECK(calls < 10000);
+
+    QuietErrors quiet;
+    CHECK(!parallelForNodes(100, 4, [](size_t index) -> bool {
+        if (index == 50) throw std::runtime_error("prueba");
+        return true;
+    }));
+    CHECK(!parallelForNodes(100, 1, [](size_t) -> bool { throw 7; }));
+    // El conjunto sigue funcionando después
+    CHECK(coversOnce(100, 4));
+}
+
+// Con WorkerLimit las tareas se quedan en el hilo de quien llama, y un límite anidado no amplía el exterior
+static void testWorkerLimit() {
+    WorkerLimit limit(1);
+    CHECK(workerCount(8) == 1);
+    {
+        WorkerLimit wider(4);
+        CHECK(workerCount(8) == 1);
+    }
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> elsewhere{false};
+    CHECK(parallelForNodes(100, 8, [&](size_t) {
+        if (std::this_thread::get_id() != caller) elsewhere = true;
+        return true;
+    }));
+    CHECK(!elsewhere);
+}
+
+// Con límite de memoria los buffers nunca pasan del límite: quien llama espera a tener el suyo en lugar de
+// seguir sin reserva, los ayudantes sin sitio no trabajan, las llamadas anidadas usan la reserva exterior y al
+// terminar no queda nada reservado
+static void testBudget() {
+    TuningProfile previous = tuningProfile();
+    TuningProfile profile = previous;
+    profile.max_memory = 4 << 20;
+    setTuningProfile(profile);
+    const size_t bytes = 1 << 20;
+    auto fill = [&](size_t) {
+        std::memset(workerBuffer(bytes), 1, bytes);
+        return true;
+    };
+
+    {
+        // Solo queda sitio para un buffer: todo lo hace quien llama
+        MemoryReservation held(3 << 20);
+        std::thread::id caller = std::this_thread::get_id();
+        std::atomic<bool> elsewhere{false};
+        CHECK(parallelForNodes(200, 4, [&](size_t index) {
+            if (std::this_thread::get_id() != caller) elsewhere = true;
+            return fill(index);
+        }, bytes));
+        CHECK(!elsewhere);
+    }
+    {
+        // Sin sitio, quien llama espera a que se libere memoria
+        std::unique_ptr<MemoryReservation> held(new MemoryReservation(4 << 20));
+        std::atomic<size_t> done{0};
+        std::thread waiting([&] {
+            CHECK(parallelForNodes(50, 4, [&](size_t index) {
+                ++done;
+                return fill(index);
+            }, bytes));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK(done == 0);
+        held.reset();
+        waiting.join();
+        CHECK(done == 50);
+    }
+
+    // Cada tarea lanza una llamada anidada con el mismo tamaño de buffer
+    std::atomic<size_t> inner{0};
+    CHECK(parallelForNodes(20, 4, [&](size_t) {
+        return parallelForNodes(10, 2, [&](size_t index) {
+            ++inner;
+            return fill(index);
+        }, bytes);
+    }, bytes));
+    CHECK(inner == 200);
+
+    // Ningún hilo, tampoco los que esperan en el conjunto, conserva su reserva
+    CHECK(MemoryReservation(4 << 20, std::chrono::milliseconds(0)).acquired());
+    setTuningProfile(previous);
+}
+
+int main() {
+    setVerbose(false);
+    testPersistentPool();
+    testCoverage();
+    testFailures();
+    testWorkerLimit();
+    testBudget();
+    CHECK(workerCount(8) == 8);
+    return finish("numa");
+}
@@ -0,0 +1,118 @@
+// Pruebas de la restauración en bloque: muchos más archivos que huecos en la cola, de modo que la recuperación
+// de claves de unos se solapa con el descifrado de otros, en los tres formatos
+
+#include "test_util.h"
+#include "enigmacore/keystore.h"
+
+#include <functional>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Con dos hilos caben 16 archivos en la cola: 80 la recorren varias veces
+const size_t kFiles = 80;
+
+// Contenido del archivo 'index': tamaños de cero a varios fragmentos del perfil
+static std::vector<unsigned char> fileData(size_t index) {
+    size_t sizes[] = {0, 1, 4095, 4096, 70000, 3 << 19};
+    return randomData(sizes[index % 6] + index, static_cast<unsigned>(index + 1));
+}
+
+// Ruta relativa del archivo 'index', repartidos en subcarpetas
+static std::string fileName(size_t index) {
+    return "dir-" + std::to_string(index % 3) + "/file-" + std::to_string(index);
+}
+
+// Cifra los originales de 'plain' en 'encrypted' con 'encryptOne' (nombre con ".enc")
+static void encryptAll(const TempDir &dir, const std::string &encrypted,
+                       const std::function<bool(size_t, const std::string &, const std::string &)> &encryptOne) {
+    for (size_t i = 0; i < kFiles; ++i) {
+        std::string input = dir / ("plain/" + fileName(i));
+        std::filesystem::create_directories(std::filesystem::path(input).parent_path());
+        if (!std::filesystem::exists(input)) CHECK(writeFile(input, fileData(i)));
+        std::string output = dir / (encrypted + "/" + fileName(i) + ".enc");
+        std::filesystem::create_directories(std::filesystem::path(output).parent_path());
+        CHECK(encryptOne(i, input, output));
+    }
+}
+
+// Función para comprobar que 'output' tiene todos los originales con su ruta relativa
+static bool restoredAll(const TempDir &dir, const std::string &output) {
+    bool ok = true;
+    for (size_t i = 0; i < kFiles; ++i) ok = hasContent(dir / (output + "/" + fileName(i)), fileData(i)) && ok;
+    return ok;
+}
+
+static RestoreOptions restoreOptions() {
+    RestoreOptions options;
+    options.threads = 2;
+    return options;
+}
+
+// Formato básico: no hay nada que desenvolver y cada archivo va directo al descifrado
+static void testBasic(const TempDir &dir) {
+    encryptAll(dir, "basic", [](size_t, const std::string &input, const std::string &output) {
+        return encrypt(input, output);
+    });
+    CHECK(restoreFiles(dir / "basic", dir / "basic.out", restoreOptions()));
+    CHECK(restoredAll(dir, "basic.out"));
+}
+
+// Formato RSA: una única llave privada, con un contexto OAEP por hilo de desenvoltura
+static void testRsa(const TempDir &dir) {
+    EVP_PKEY *pkey = EVP_RSA_gen(2048);
+    CHECK(pkey != nullptr);
+    if (!pkey) return;
+    FILE *publicFile = fopen((dir / "public.pem").c_str(), "wb");
+    FILE *privateFile = fopen((dir / "private.pem").c_str(), "wb");
+    CHECK(publicFile && PEM_write_PUBKEY(publicFile, pkey) == 1);
+    CHECK(privateFile && PEM_write_PrivateKey(privateFile, pkey, nullptr, nullptr, 0, nullptr, nullptr) == 1);
+    if (publicFile) fclose(publicFile);
+    if (privateFile) fclose(privateFile);
+    EVP_PKEY_free(pkey);
+
+    encryptAll(dir, "rsa", [&](size_t, const std::string &input, const std::string &output) {
+        return encryptRSA(input, output, dir / "public.pem");
+    });
+    RestoreOptions options = restoreOptions();
+    options.private_key = dir / "private.pem";
+    CHECK(restoreFiles(dir / "rsa", dir / "rsa.out", options));
+    CHECK(restoredAll(dir, "rsa.out"));
+}
+
+// Formato con llave: las dos llaves del almacén se interpretan una vez y se reparten entre los archivos. Un
+// archivo que no se autentica hace fallar la restauración sin dejar salida, y los demás se restauran igual.
+static void testKeyed(const TempDir &dir) {
+    Keystore keystore;
+    CHECK(makeKeystore(dir / "keys.eks") && keystore.open(dir / "keys.eks"));
+    encryptAll(dir, "keyed", [&](size_t index, const std::string &input, const std::string &output) {
+        return encryptKeyed(input, output, keystore, "key-" + std::to_string(index % 2));
+    });
+    RestoreOptions options = restoreOptions();
+    options.keystore = dir / "keys.eks";
+    CHECK(restoreFiles(dir / "keyed", dir / "keyed.out", options));
+    CHECK(restoredAll(dir, "keyed.out"));
+
+    std::string tampered = dir / ("keyed/" + fileName(4) + ".enc");
+    flipByte(tampered, readFile(tampered).size() - 1);
+    QuietErrors quiet;
+    CHECK(!restoreFiles(dir / "keyed", dir / "tampered.out", options));
+    CHECK(!std::filesystem::exists(dir / ("tampered.out/" + fileName(4))));
+    for (size_t i = 0; i < kFiles; ++i) {
+        if (i != 4) CHECK(hasContent(dir / ("tampered.out/" + fileName(i)), fileData(i)));
+    }
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("restore");
+
+    testBasic(dir);
+    testRsa(dir);
+    testKeyed(dir);
+    return finish("restore");
+}
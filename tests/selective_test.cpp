@@ -0,0 +1,154 @@
+// Pruebas del cifrado selectivo de imágenes JPEG y TIFF (regiones cifradas in situ y bloque de descifrado al
+// final). Recibe el directorio con las imágenes de ejemplo.
+
+#include "test_util.h"
+
+#include <cstring>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Tamaño de la cola del contenedor: número de regiones, tamaño original y magic
+const size_t kTailSize = 8 + 8 + 8;
+
+// Función para crear un TIFF little-endian mínimo con una tira de 64 bytes
+static std::vector<unsigned char> makeTiff() {
+    std::vector<unsigned char> tiff = {'I', 'I', 42, 0, 8, 0, 0, 0};
+    auto u16 = [&](uint32_t value) {
+        tiff.push_back(static_cast<unsigned char>(value));
+        tiff.push_back(static_cast<unsigned char>(value >> 8));
+    };
+    auto u32 = [&](uint32_t value) {
+        u16(value & 0xFFFF);
+        u16(value >> 16);
+    };
+    auto entry = [&](uint32_t tag, uint32_t type, uint32_t value) {
+        u16(tag);
+        u16(type);
+        u32(1);
+        u32(value);
+    };
+    const uint32_t stripOffset = 8 + 2 + 4 * 12 + 4;
+    u16(4);
+    entry(256, 3, 8);           // ImageWidth
+    entry(257, 3, 8);           // ImageLength
+    entry(273, 4, stripOffset); // StripOffsets
+    entry(279, 4, 64);          // StripByteCounts
+    u32(0);                     // sin más IFD
+    std::vector<unsigned char> strip = randomData(64, 7);
+    tiff.insert(tiff.end(), strip.begin(), strip.end());
+    return tiff;
+}
+
+static void testRoundTrip(const TempDir &dir, const std::string &image) {
+    std::vector<unsigned char> data = readFile(image);
+    CHECK(!data.empty());
+    CHECK(encryptSelective(image, dir / "image.enc"));
+    std::vector<unsigned char> encrypted = readFile(dir / "image.enc");
+
+    // La imagen cifrada sigue empezando como un JPEG y solo cambian parte de sus bytes
+    CHECK(encrypted.size() > data.size() + 48 + kTailSize);
+    CHECK(encrypted.size() >= 2 && encrypted[0] == 0xFF && encrypted[1] == 0xD8);
+    CHECK(getU64(encrypted, encrypted.size() - 16) == data.size());
+    size_t changed = 0;
+    for (size_t i = 0; i < std::min(data.size(), encrypted.size()); ++i) changed += data[i] != encrypted[i];
+    CHECK(changed > data.size() / 2 && changed < data.size());
+
+    CHECK(decryptSelective(dir / "image.enc", dir / "image.out"));
+    CHECK(hasContent(dir / "image.out", data));
+}
+
+static void testTiff(const TempDir &dir) {
+    std::vector<unsigned char> tiff = makeTiff();
+    CHECK(writeFile(dir / "image.tif", tiff));
+    CHECK(encryptSelective(dir / "image.tif", dir / "tiff.enc"));
+    std::vector<unsigned char> encrypted = readFile(dir / "tiff.enc");
+    size_t stripOffset = tiff.size() - 64;
+    // La cabecera y la IFD quedan en claro; la tira se cifra y es la única región
+    CHECK(encrypted.size() == tiff.size() + 48 + 16 + kTailSize);
+    CHECK(std::equal(tiff.begin(), tiff.begin() + stripOffset, encrypted.begin()));
+    CHECK(!std::equal(tiff.begin() + stripOffset, tiff.end(), encrypted.begin() + stripOffset));
+    CHECK(getU64(encrypted, encrypted.size() - kTailSize) == 1);
+    CHECK(getU64(encrypted, tiff.size() + 48) == stripOffset);
+    CHECK(getU64(encrypted, tiff.size() + 56) == 64);
+    CHECK(decryptSelective(dir / "tiff.enc", dir / "tiff.out"));
+    CHECK(hasContent(dir / "tiff.out", tiff));
+
+    // Lo que no es JPEG ni TIFF no se cifra
+    QuietErrors quiet;
+    CHECK(writeFile(dir / "random.bin", randomData(5000, 8)));
+    CHECK(!encryptSelective(dir / "random.bin", dir / "random.enc"));
+    CHECK(!std::filesystem::exists(dir / "random.enc"));
+}
+
+// El formato no está autenticado: un byte cifrado modificado cambia solo ese byte de la imagen
+static void testTamper(const TempDir &dir) {
+    std::vector<unsigned char> tiff = makeTiff();
+    CHECK(writeFile(dir / "tamper.tif", tiff));
+    CHECK(encryptSelective(dir / "tamper.tif", dir / "tamper.enc"));
+    size_t position = tiff.size() - 10;
+    flipByte(dir / "tamper.enc", position);
+    CHECK(decryptSelective(dir / "tamper.enc", dir / "tamper.out"));
+    std::vector<unsigned char> output = readFile(dir / "tamper.out");
+    CHECK(output.size() == tiff.size());
+    size_t differences = 0;
+    for (size_t i = 0; i < std::min(output.size(), tiff.size()); ++i) differences += output[i] != tiff[i];
+    CHECK(differences == 1 && output[position] == static_cast<unsigned char>(~tiff[position]));
+}
+
+// Colas y tablas de regiones dañadas
+static void testMalformed(const TempDir &dir, const std::string &image) {
+    CHECK(encryptSelective(image, dir / "bad.enc"));
+    const std::vector<unsigned char> container = readFile(dir / "bad.enc");
+    size_t size = container.size();
+    uint64_t count = getU64(container, size - kTailSize);
+    uint64_t originalSize = getU64(container, size - 16);
+    size_t table = originalSize + 48;
+    CHECK(count > 0 && table + count * 16 + kTailSize == size);
+
+    std::vector<std::vector<unsigned char>> damaged;
+    auto variant = [&](size_t offset, uint64_t value) {
+        std::vector<unsigned char> bytes = container;
+        putU64(bytes, offset, value);
+        damaged.push_back(bytes);
+    };
+    std::vector<unsigned char> bytes = container;
+    bytes[size - 1] ^= 1; // magic
+    damaged.push_back(bytes);
+    damaged.emplace_back(container.begin(), container.end() - 1); // truncado
+    damaged.emplace_back(container.end() - kTailSize, container.end()); // solo la cola
+    variant(size - kTailSize, count + 1);
+    variant(size - kTailSize, ~0ULL);
+    variant(size - 16, originalSize + 16); // la tabla tendría una región menos
+    variant(size - 16, ~0ULL);
+    variant(size - 16, originalSize - 1);
+    variant(table, originalSize + 1); // región fuera de la imagen
+    variant(table + 8, ~0ULL); // longitud que desbordaría al sumar el desplazamiento
+    variant(table + 8, originalSize);
+
+    QuietErrors quiet;
+    for (const std::vector<unsigned char> &variantBytes: damaged) {
+        CHECK(writeFile(dir / "damaged.enc", variantBytes));
+        CHECK(!decryptSelective(dir / "damaged.enc", dir / "damaged.out"));
+    }
+    CHECK(!decryptSelective(dir / "no-existe.enc", dir / "damaged.out"));
+}
+
+int main(int argc, char **argv) {
+    setVerbose(false);
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " <directorio de imágenes>" << std::endl;
+        return 1;
+    }
+    std::string images = argv[1];
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("selective");
+
+    testRoundTrip(dir, images + "/1.jpeg");
+    testRoundTrip(dir, images + "/2.jpg");
+    testTiff(dir);
+    testTamper(dir);
+    testMalformed(dir, images + "/1.jpeg");
+    return finish("selective");
+}
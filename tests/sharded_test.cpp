@@ -0,0 +1,184 @@
+// Pruebas de la salida fragmentada (directorio con manifiesto y fragmentos con cabecera propia)
+
+#include "test_util.h"
+
+#include <iomanip>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Posiciones de la cabecera de cada fragmento: id del archivo, huella de la clave y campos u64 (índice,
+// número de fragmentos, desplazamiento, longitud y tamaño total)
+const size_t kFileIdOffset = 8;
+const size_t kFingerprintOffset = kFileIdOffset + 16;
+const size_t kFieldsOffset = kFingerprintOffset + 8;
+const size_t kShardHeaderSize = kFieldsOffset + 5 * 8;
+
+static std::string shardName(uint64_t index) {
+    std::ostringstream name;
+    name << "shard-" << std::setw(5) << std::setfill('0') << index << ".bin";
+    return name.str();
+}
+
+static size_t shardFiles(const std::string &dir) {
+    size_t count = 0;
+    for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+        count += entry.path().filename().string().rfind("shard-", 0) == 0;
+    }
+    return count;
+}
+
+static void testRoundTrip(const TempDir &dir, const Keystore &keystore) {
+    // 16 fragmentos completos y uno parcial
+    std::vector<unsigned char> data = randomData((1 << 20) + 123, 1);
+    CHECK(writeFile(dir / "plain.bin", data));
+    CHECK(encryptSharded(dir / "plain.bin", dir / "shards", 64 << 10, keystore, "key-0"));
+    CHECK(shardFiles(dir / "shards") == 17);
+    CHECK(std::filesystem::file_size(dir / ("shards/" + shardName(16))) == kShardHeaderSize + 123);
+    CHECK(readText(dir / "shards/manifest.txt").rfind("ENIGMACORE-SHARDS 2\n", 0) == 0);
+    CHECK(decryptSharded(dir / "shards", dir / "plain.out", keystore));
+    CHECK(hasContent(dir / "plain.out", data));
+
+    // Un solo fragmento y un archivo vacío, sin fragmentos
+    CHECK(encryptSharded(dir / "plain.bin", dir / "single", kDefaultShardSize, keystore, "key-1"));
+    CHECK(shardFiles(dir / "single") == 1);
+    CHECK(decryptSharded(dir / "single", dir / "single.out", keystore));
+    CHECK(hasContent(dir / "single.out", data));
+    CHECK(writeFile(dir / "empty.bin", {}));
+    CHECK(encryptSharded(dir / "empty.bin", dir / "empty", 4096, keystore, "key-0"));
+    CHECK(shardFiles(dir / "empty") == 0);
+    CHECK(decryptSharded(dir / "empty", dir / "empty.out", keystore));
+    CHECK(hasContent(dir / "empty.out", {}));
+
+    QuietErrors quiet;
+    CHECK(!encryptSharded(dir / "plain.bin", dir / "unknown", 4096, keystore, "key-7"));
+}
+
+// El texto cifrado no está autenticado, pero las cabeceras ligan cada fragmento a su archivo y su posición
+static void testTamper(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(100000, 2);
+    CHECK(writeFile(dir / "tamper.bin", data));
+    CHECK(encryptSharded(dir / "tamper.bin", dir / "tamper", 16384, keystore, "key-0"));
+    CHECK(encryptSharded(dir / "tamper.bin", dir / "other", 16384, keystore, "key-0"));
+    std::string shard = dir / ("tamper/" + shardName(2));
+    const std::vector<unsigned char> original = readFile(shard);
+
+    // Un byte cifrado modificado cambia solo ese byte del resultado
+    flipByte(shard, kShardHeaderSize + 10);
+    CHECK(decryptSharded(dir / "tamper", dir / "tamper.out", keystore));
+    std::vector<unsigned char> expected = data;
+    expected[2 * 16384 + 10] = static_cast<unsigned char>(~expected[2 * 16384 + 10]);
+    CHECK(hasContent(dir / "tamper.out", expected));
+
+    std::vector<std::vector<unsigned char>> damaged;
+    auto variant = [&](size_t offset, uint64_t value) {
+        std::vector<unsigned char> bytes = original;
+        putU64(bytes, offset, value);
+        damaged.push_back(bytes);
+    };
+    for (size_t offset: {size_t(0), kFileIdOffset, kFingerprintOffset}) {
+        std::vector<unsigned char> bytes = original;
+        bytes[offset] ^= 1; // magic, id del archivo y huella de la clave
+        damaged.push_back(bytes);
+    }
+    variant(kFieldsOffset, 3);                 // índice
+    variant(kFieldsOffset + 8, 6);             // número de fragmentos
+    variant(kFieldsOffset + 16, 0);            // desplazamiento
+    variant(kFieldsOffset + 24, 16383);        // longitud
+    variant(kFieldsOffset + 32, data.size() + 1); // tamaño total
+    damaged.emplace_back(original.begin(), original.end() - 1); // truncado
+    damaged.emplace_back(original.begin(), original.begin() + 20); // cabecera incompleta
+    damaged.push_back(readFile(dir / ("other/" + shardName(2)))); // fragmento de otro cifrado
+    damaged.push_back(readFile(dir / ("tamper/" + shardName(3)))); // fragmento en otra posición
+
+    QuietErrors quiet;
+    for (const std::vector<unsigned char> &bytes: damaged) {
+        CHECK(writeFile(shard, bytes));
+        CHECK(!decryptSharded(dir / "tamper", dir / "tamper.out", keystore));
+        // No queda un resultado a medias
+        CHECK(!std::filesystem::exists(dir / "tamper.out"));
+    }
+    CHECK(writeFile(shard, original));
+    CHECK(decryptSharded(dir / "tamper", dir / "tamper.out", keystore));
+    CHECK(hasContent(dir / "tamper.out", data));
+
+    std::filesystem::remove(dir / ("tamper/" + shardName(6)));
+    CHECK(!decryptSharded(dir / "tamper", dir / "tamper.out", keystore));
+
+    Keystore other;
+    CHECK(makeKeystore(dir / "other.eks") && other.open(dir / "other.eks"));
+    CHECK(!decryptSharded(dir / "other", dir / "other.out", other));
+    CHECK(!std::filesystem::exists(dir / "other.out"));
+}
+
+// Manifiestos dañados
+static void testMalformedManifest(const TempDir &dir, const Keystore &keystore) {
+    std::vector<unsigned char> data = randomData(50000, 3);
+    CHECK(writeFile(dir / "bad.bin", data));
+    CHECK(encryptSharded(dir / "bad.bin", dir / "bad", 10000, keystore, "key-1"));
+    std::string manifestPath = dir / "bad/manifest.txt";
+    std::string manifest = readText(manifestPath);
+
+    const std::vector<std::string> damaged = {
+            replaceLine(manifest, "ENIGMACORE-SHARDS", "ENIGMACORE-SHARDS 9"),
+            replaceLine(manifest, "file", "file 0123"),
+            replaceLine(manifest, "file", "file " + std::string(32, '0')),
+            replaceLine(manifest, "key-id", "key-id key-7"),
+            replaceLine(manifest, "wrapped-key", "wrapped-key abc"),
+            replaceLine(manifest, "wrapped-key", "wrapped-key " + std::string(64, '0')),
+            replaceLine(manifest, "size", "size muchos"),
+            replaceLine(manifest, "size", "size 50001"),
+            replaceLine(manifest, "shard-size", "shard-size 0"),
+            replaceLine(manifest, "shard-size", "shard-size 25000"),
+            replaceLine(manifest, "shards", "shards 6"),
+            // El redondeo del número de fragmentos desbordaría: 2^64 - 1 en fragmentos de 2 bytes no son 0
+            replaceLine(replaceLine(replaceLine(manifest, "size", "size 18446744073709551615"), "shard-size",
+                                    "shard-size 2"),
+                        "shards", "shards 0"),
+            replaceLine(replaceLine(manifest, "size", "size 9223372036854775807"), "shards", "shards 922337203685478"),
+            "",
+    };
+    QuietErrors quiet;
+    for (const std::string &text: damaged) {
+        CHECK(writeText(manifestPath, text));
+        CHECK(!decryptSharded(dir / "bad", dir / "bad.out", keystore));
+        CHECK(!std::filesystem::exists(dir / "bad.out"));
+    }
+    std::filesystem::remove(manifestPath);
+    CHECK(!decryptSharded(dir / "bad", dir / "bad.out", keystore));
+}
+
+// Tamaños de fragmento no válidos y cifrados que fallan a medias: no queda ningún fragmento ni manifiesto
+static void testFailedEncrypt(const TempDir &dir, const Keystore &keystore) {
+    CHECK(parseSize("64M") == 64ULL << 20 && parseSize("4k") == 4096 && parseSize("1000") == 1000);
+    for (const char *text: {"", "0", "abc", "-1", "12x", "64MB", "17179869184G", "99999999999999999999"}) {
+        CHECK(parseSize(text) == 0);
+    }
+
+    std::vector<unsigned char> data = randomData(40000, 4);
+    CHECK(writeFile(dir / "fail.bin", data));
+    QuietErrors quiet;
+    CHECK(!encryptSharded(dir / "fail.bin", dir / "zero", 0, keystore, "key-0"));
+    CHECK(!std::filesystem::exists(dir / "zero"));
+
+    // Un directorio con el nombre del tercer fragmento impide escribirlo
+    std::filesystem::create_directories(dir / ("fail/" + shardName(2)));
+    CHECK(!encryptSharded(dir / "fail.bin", dir / "fail", 10000, keystore, "key-0"));
+    CHECK(shardFiles(dir / "fail") == 0);
+    CHECK(!std::filesystem::exists(dir / "fail/manifest.txt"));
+    CHECK(!std::filesystem::exists(dir / "fail/manifest.txt.tmp"));
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    Keystore keystore;
+    CHECK(dir.valid() && makeKeystore(dir / "keys.eks") && keystore.open(dir / "keys.eks"));
+    if (failures()) return finish("sharded");
+
+    testRoundTrip(dir, keystore);
+    testTamper(dir, keystore);
+    testMalformedManifest(dir, keystore);
+    testFailedEncrypt(dir, keystore);
+    return finish("sharded");
+}
@@ -0,0 +1,134 @@
+// Pruebas del cifrado de archivos dispersos (contenedor con las extensiones con datos y su tabla al final)
+
+#include "test_util.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Tamaño de la cabecera del contenedor: magic, clave, IV y tamaño original
+const size_t kHeaderSize = 8 + 32 + 16 + 8;
+
+// Función para crear un archivo con datos, bloques a cero escritos y un hueco sin asignar
+static std::vector<unsigned char> writeSparseInput(const std::string &path) {
+    std::vector<unsigned char> data = randomData(64 << 10, 1);
+    data.resize(data.size() + (1 << 20), 0);
+    std::vector<unsigned char> middle = randomData(5000, 2);
+    data.insert(data.end(), middle.begin(), middle.end());
+    writeFile(path, data);
+
+    // Un hueco de 2 MB y una cola que no acaba en un bloque completo
+    std::vector<unsigned char> tail = randomData(10000, 3);
+    uint64_t tailOffset = data.size() + (2 << 20);
+    truncate(path.c_str(), static_cast<off_t>(tailOffset));
+    std::ofstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(tailOffset));
+    file.write(reinterpret_cast<const char *>(tail.data()), static_cast<std::streamsize>(tail.size()));
+    file.close();
+    data.resize(tailOffset, 0);
+    data.insert(data.end(), tail.begin(), tail.end());
+    return data;
+}
+
+static void testRoundTrip(const TempDir &dir) {
+    std::vector<unsigned char> data = writeSparseInput(dir / "sparse.bin");
+    CHECK(hasContent(dir / "sparse.bin", data));
+    CHECK(encryptSparse(dir / "sparse.bin", dir / "sparse.enc"));
+    CHECK(decryptSparse(dir / "sparse.enc", dir / "sparse.out"));
+    CHECK(hasContent(dir / "sparse.out", data));
+
+    // Solo se guardan las extensiones con datos, y al descifrar los ceros quedan como huecos
+    uint64_t dataBytes = (64 << 10) + 5000 + 10000;
+    CHECK(std::filesystem::file_size(dir / "sparse.enc") < dataBytes + 3 * 4096 + 1024);
+    struct stat st;
+    CHECK(stat((dir / "sparse.out").c_str(), &st) == 0 &&
+          static_cast<uint64_t>(st.st_blocks) * 512 < static_cast<uint64_t>(st.st_size) / 2);
+
+    // Archivos vacíos y solo con ceros: sin extensiones
+    CHECK(writeFile(dir / "empty.bin", {}));
+    CHECK(encryptSparse(dir / "empty.bin", dir / "empty.enc"));
+    CHECK(decryptSparse(dir / "empty.enc", dir / "empty.out"));
+    CHECK(hasContent(dir / "empty.out", {}));
+    std::vector<unsigned char> zeros(100000, 0);
+    CHECK(writeFile(dir / "zeros.bin", zeros));
+    CHECK(encryptSparse(dir / "zeros.bin", dir / "zeros.enc"));
+    CHECK(std::filesystem::file_size(dir / "zeros.enc") == kHeaderSize + 16);
+    CHECK(decryptSparse(dir / "zeros.enc", dir / "zeros.out"));
+    CHECK(hasContent(dir / "zeros.out", zeros));
+}
+
+// El formato no está autenticado: un byte cifrado modificado cambia solo ese byte del resultado
+static void testTamper(const TempDir &dir) {
+    std::vector<unsigned char> data = randomData(20000, 4);
+    CHECK(writeFile(dir / "tamper.bin", data));
+    CHECK(encryptSparse(dir / "tamper.bin", dir / "tamper.enc"));
+    flipByte(dir / "tamper.enc", kHeaderSize + 1234);
+    CHECK(decryptSparse(dir / "tamper.enc", dir / "tamper.out"));
+    std::vector<unsigned char> output = readFile(dir / "tamper.out");
+    CHECK(output.size() == data.size());
+    size_t differences = 0;
+    for (size_t i = 0; i < std::min(output.size(), data.size()); ++i) differences += output[i] != data[i];
+    CHECK(differences == 1 && output[1234] == static_cast<unsigned char>(~data[1234]));
+}
+
+// Cabeceras y tablas de extensiones dañadas: se rechazan sin dejar salida
+static void testMalformed(const TempDir &dir) {
+    std::vector<unsigned char> data = writeSparseInput(dir / "bad.bin");
+    CHECK(encryptSparse(dir / "bad.bin", dir / "bad.enc"));
+    const std::vector<unsigned char> container = readFile(dir / "bad.enc");
+    size_t size = container.size();
+    uint64_t count = getU64(container, size - 16);
+    CHECK(count == 3);
+    size_t table = size - 16 - count * 16;
+    uint64_t originalSize = getU64(container, kHeaderSize - 8);
+
+    std::vector<std::vector<unsigned char>> damaged;
+    auto variant = [&](size_t offset, uint64_t value) {
+        std::vector<unsigned char> bytes = container;
+        putU64(bytes, offset, value);
+        damaged.push_back(bytes);
+    };
+    std::vector<unsigned char> bytes = container;
+    bytes[0] = 'X'; // magic inicial
+    damaged.push_back(bytes);
+    bytes = container;
+    bytes[size - 1] = 'X'; // magic final
+    damaged.push_back(bytes);
+    damaged.emplace_back(container.begin(), container.end() - 1); // truncado
+    damaged.emplace_back(container.begin(), container.begin() + kHeaderSize); // sin tabla
+    damaged.emplace_back(container.begin(), container.begin() + 20); // cabecera incompleta
+    variant(size - 16, count + 1); // más extensiones que la tabla
+    variant(size - 16, ~0ULL);
+    variant(size - 16, (size - kHeaderSize) / 16); // la tabla se solaparía con la cabecera
+    variant(table + 8, getU64(container, table + 8) + 1); // longitudes que no suman los datos guardados
+    variant(table, originalSize); // extensión fuera del archivo original
+    variant(table, ~0ULL - 4095); // desplazamiento que desbordaría al sumar la longitud
+    variant(table + 8, ~0ULL);
+    variant(kHeaderSize - 8, 1000); // tamaño original menor que las extensiones
+    variant(kHeaderSize - 8, ~0ULL); // no cabe en off_t: falla después de crear la salida
+
+    QuietErrors quiet;
+    for (size_t i = 0; i < damaged.size(); ++i) {
+        CHECK(writeFile(dir / "damaged.enc", damaged[i]));
+        bool decrypted = decryptSparse(dir / "damaged.enc", dir / "damaged.out");
+        if (decrypted) std::cout << "caso " << i << " aceptado" << std::endl;
+        CHECK(!decrypted);
+    }
+    // Ningún caso deja una salida a medias
+    CHECK(!std::filesystem::exists(dir / "damaged.out"));
+    CHECK(!decryptSparse(dir / "no-existe.enc", dir / "damaged.out"));
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("sparse");
+
+    testRoundTrip(dir);
+    testTamper(dir);
+    testMalformed(dir);
+    return finish("sparse");
+}
@@ -0,0 +1,169 @@
+#ifndef ENIGMACORE_TEST_UTIL_H
+#define ENIGMACORE_TEST_UTIL_H
+
+// Utilidades de las pruebas de libenigmacore. Cada prueba es un ejecutable que trabaja en su propio directorio
+// temporal y termina con código 0 si se cumplen todas sus comprobaciones.
+
+#include "enigmacore/enigmacore.h"
+#include "enigmacore/keystore.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace enigmacore_test {
+
+// Número de comprobaciones que no se cumplieron
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+// Comprueba una condición; si no se cumple muestra la línea y la prueba sigue con el resto de casos
+#define CHECK(condition)                                                                                  \
+    do {                                                                                                  \
+        if (!(condition)) {                                                                               \
+            std::cerr << "❌ [FALLO] " << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; \
+            ++enigmacore_test::failures();                                                                \
+        }                                                                                                 \
+    } while (0)
+
+// Función para terminar la prueba: muestra el resultado y devuelve el código de salida
+inline int finish(const std::string &name) {
+    if (failures()) {
+        std::cerr << name << ": " << failures() << " comprobaciones fallidas" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": OK" << std::endl;
+    return 0;
+}
+
+// Silencia std::cerr mientras vive el objeto, para los casos en los que se espera que la biblioteca muestre
+// un error
+class QuietErrors {
+public:
+    QuietErrors() : previous_(std::cerr.rdbuf(sink_.rdbuf())) {}
+    ~QuietErrors() { std::cerr.rdbuf(previous_); }
+    QuietErrors(const QuietErrors &) = delete;
+    QuietErrors &operator=(const QuietErrors &) = delete;
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *previous_;
+};
+
+// Directorio temporal que se borra al terminar la prueba
+class TempDir {
+public:
+    TempDir() {
+        std::string pattern = (std::filesystem::temp_directory_path() / "enigmacore-test-XXXXXX").string();
+        if (mkdtemp(&pattern[0])) path_ = pattern;
+    }
+    ~TempDir() {
+        std::error_code ec;
+        if (!path_.empty()) std::filesystem::remove_all(path_, ec);
+    }
+    TempDir(const TempDir &) = delete;
+    TempDir &operator=(const TempDir &) = delete;
+
+    bool valid() const { return !path_.empty(); }
+
+    // Ruta de 'name' dentro del directorio
+    std::string operator/(const std::string &name) const { return (path_ / name).string(); }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Función para generar datos pseudoaleatorios reproducibles
+inline std::vector<unsigned char> randomData(size_t size, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::vector<unsigned char> data(size);
+    for (unsigned char &byte: data) byte = static_cast<unsigned char>(generator());
+    return data;
+}
+
+inline bool writeFile(const std::string &path, const std::vector<unsigned char> &data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    file.close();
+    return static_cast<bool>(file);
+}
+
+inline std::vector<unsigned char> readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+inline bool writeText(const std::string &path, const std::string &text) {
+    std::ofstream file(path, std::ios::trunc);
+    file << text;
+    file.close();
+    return static_cast<bool>(file);
+}
+
+inline std::string readText(const std::string &path) {
+    std::ifstream file(path);
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// Función para comprobar que un archivo existe y tiene exactamente 'data'
+inline bool hasContent(const std::string &path, const std::vector<unsigned char> &data) {
+    return std::filesystem::exists(path) && readFile(path) == data;
+}
+
+// Función para invertir los bits de un byte de un archivo
+inline void flipByte(const std::string &path, uint64_t offset) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekg(static_cast<std::streamoff>(offset));
+    char byte = 0;
+    file.get(byte);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.put(static_cast<char>(~byte));
+}
+
+// Función para escribir un entero de 64 bits en little-endian en una posición de un buffer
+inline void putU64(std::vector<unsigned char> &data, size_t offset, uint64_t value) {
+    for (int i = 0; i < 8; ++i) data[offset + i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+inline uint64_t getU64(const std::vector<unsigned char> &data, size_t offset) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(data[offset + i]) << (8 * i);
+    return value;
+}
+
+// Función para sustituir la primera línea que empieza por 'prefix' en un texto
+inline std::string replaceLine(const std::string &text, const std::string &prefix, const std::string &line) {
+    std::istringstream input(text);
+    std::ostringstream output;
+    std::string current;
+    bool replaced = false;
+    while (std::getline(input, current)) {
+        if (!replaced && current.rfind(prefix, 0) == 0) {
+            current = line;
+            replaced = true;
+        }
+        output << current << "\n";
+    }
+    return output.str();
+}
+
+// Función para crear un almacén con dos llaves EC ("key-0" y "key-1"), rápidas de generar
+inline bool makeKeystore(const std::string &path) {
+    enigmacore::KeygenOptions options;
+    options.type = enigmacore::KeyType::EC;
+    return enigmacore::generateKeystore(path, 2, options);
+}
+
+} // namespace enigmacore_test
+
+#endif // ENIGMACORE_TEST_UTIL_H
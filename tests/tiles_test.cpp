@@ -0,0 +1,173 @@
+// Pruebas del cifrado por teselas (contenedor con índice y teselas descifrables por separado). Recibe el
+// directorio con las imágenes de ejemplo.
+
+#include "test_util.h"
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Posiciones de la cabecera del contenedor: campos tras magic, clave e IV, e índice tras los seis campos
+const size_t kFieldsOffset = 8 + 32 + 16;
+const size_t kIndexOffset = kFieldsOffset + 6 * 8;
+
+// Imagen PNM en memoria, con la misma cabecera que escribe la biblioteca
+struct Pnm {
+    uint64_t width, height, channels;
+    std::vector<unsigned char> pixels;
+
+    std::vector<unsigned char> bytes() const {
+        std::string header = std::string(channels == 3 ? "P6" : "P5") + "\n" + std::to_string(width) + " " +
+                             std::to_string(height) + "\n255\n";
+        std::vector<unsigned char> data(header.begin(), header.end());
+        data.insert(data.end(), pixels.begin(), pixels.end());
+        return data;
+    }
+
+    // Recorte de la tesela (tx, ty) de 256 x 256 píxeles como PNM
+    Pnm tile(uint64_t tx, uint64_t ty) const {
+        Pnm crop{std::min<uint64_t>(256, width - tx * 256), std::min<uint64_t>(256, height - ty * 256), channels, {}};
+        for (uint64_t y = 0; y < crop.height; ++y) {
+            auto row = pixels.begin() + ((ty * 256 + y) * width + tx * 256) * channels;
+            crop.pixels.insert(crop.pixels.end(), row, row + crop.width * channels);
+        }
+        return crop;
+    }
+};
+
+static Pnm makePnm(uint64_t width, uint64_t height, uint64_t channels, uint32_t seed) {
+    return {width, height, channels, randomData(width * height * channels, seed)};
+}
+
+static void testRoundTrip(const TempDir &dir) {
+    // Teselas completas y de borde, en color y en gris
+    for (const Pnm &image: {makePnm(600, 300, 3, 1), makePnm(256, 513, 1, 2), makePnm(1, 1, 3, 3)}) {
+        CHECK(writeFile(dir / "image.pnm", image.bytes()));
+        CHECK(encryptTiles(dir / "image.pnm", dir / "image.enc"));
+        uint64_t tiles = ((image.width + 255) / 256) * ((image.height + 255) / 256);
+        CHECK(std::filesystem::file_size(dir / "image.enc") == kIndexOffset + tiles * 16 + image.pixels.size());
+        CHECK(decryptTiles(dir / "image.enc", dir / "image.out"));
+        CHECK(hasContent(dir / "image.out", image.bytes()));
+    }
+
+    // Cada tesela se descifra sola
+    Pnm image = makePnm(600, 300, 3, 4);
+    CHECK(writeFile(dir / "single.pnm", image.bytes()));
+    CHECK(encryptTiles(dir / "single.pnm", dir / "single.enc"));
+    for (uint64_t ty = 0; ty < 2; ++ty) {
+        for (uint64_t tx = 0; tx < 3; ++tx) {
+            CHECK(decryptTile(dir / "single.enc", tx, ty, dir / "tile.out"));
+            CHECK(hasContent(dir / "tile.out", image.tile(tx, ty).bytes()));
+        }
+    }
+    QuietErrors quiet;
+    CHECK(!decryptTile(dir / "single.enc", 3, 0, dir / "tile.out"));
+    CHECK(!decryptTile(dir / "single.enc", 0, 2, dir / "tile.out"));
+
+    // Lo que no es una imagen no se cifra
+    CHECK(writeFile(dir / "random.bin", randomData(5000, 5)));
+    CHECK(!encryptTiles(dir / "random.bin", dir / "random.enc"));
+    CHECK(writeText(dir / "deep.pnm", "P5\n2 2\n65535\n12345678"));
+    CHECK(!encryptTiles(dir / "deep.pnm", dir / "deep.enc"));
+    CHECK(writeText(dir / "huge.pnm", "P6\n16777216 16777216\n255\n....")); // cabecera sin los píxeles
+    CHECK(!encryptTiles(dir / "huge.pnm", dir / "huge.enc"));
+}
+
+// Con libjpeg los JPEG se decodifican; el resultado es un PNM con las dimensiones de la imagen
+static void testJpeg(const TempDir &dir, const std::string &image) {
+    bool encrypted;
+    {
+        QuietErrors quiet;
+        encrypted = encryptTiles(image, dir / "jpeg.enc");
+    }
+    if (!encrypted) {
+        std::cout << "tiles: sin soporte de JPEG, se omite " << image << std::endl;
+        return;
+    }
+    CHECK(decryptTiles(dir / "jpeg.enc", dir / "jpeg.out"));
+    std::vector<unsigned char> output = readFile(dir / "jpeg.out");
+    std::vector<unsigned char> container = readFile(dir / "jpeg.enc");
+    uint64_t width = getU64(container, kFieldsOffset), height = getU64(container, kFieldsOffset + 8);
+    uint64_t channels = getU64(container, kFieldsOffset + 16);
+    std::string header = std::string(channels == 3 ? "P6" : "P5") + "\n" + std::to_string(width) + " " +
+                         std::to_string(height) + "\n255\n";
+    CHECK(output.size() == header.size() + width * height * channels);
+    CHECK(std::equal(header.begin(), header.end(), output.begin()));
+}
+
+// El formato no está autenticado: un byte modificado afecta solo a ese píxel de su tesela
+static void testTamper(const TempDir &dir) {
+    Pnm image = makePnm(512, 256, 1, 6);
+    CHECK(writeFile(dir / "tamper.pnm", image.bytes()));
+    CHECK(encryptTiles(dir / "tamper.pnm", dir / "tamper.enc"));
+    flipByte(dir / "tamper.enc", kIndexOffset + 2 * 16 + 100);
+    CHECK(decryptTile(dir / "tamper.enc", 1, 0, dir / "tile.out"));
+    CHECK(hasContent(dir / "tile.out", image.tile(1, 0).bytes()));
+    CHECK(decryptTile(dir / "tamper.enc", 0, 0, dir / "tile.out"));
+    Pnm expected = image.tile(0, 0);
+    expected.pixels[100] = static_cast<unsigned char>(~expected.pixels[100]);
+    CHECK(hasContent(dir / "tile.out", expected.bytes()));
+}
+
+// Cabeceras e índices dañados
+static void testMalformed(const TempDir &dir) {
+    Pnm image = makePnm(600, 300, 3, 7);
+    CHECK(writeFile(dir / "bad.pnm", image.bytes()));
+    CHECK(encryptTiles(dir / "bad.pnm", dir / "bad.enc"));
+    const std::vector<unsigned char> container = readFile(dir / "bad.enc");
+
+    std::vector<std::vector<unsigned char>> damaged;
+    auto variant = [&](size_t offset, uint64_t value) {
+        std::vector<unsigned char> bytes = container;
+        putU64(bytes, offset, value);
+        damaged.push_back(bytes);
+    };
+    std::vector<unsigned char> bytes = container;
+    bytes[0] = 'X'; // magic
+    damaged.push_back(bytes);
+    damaged.emplace_back(container.begin(), container.end() - 1); // última tesela incompleta
+    damaged.emplace_back(container.begin(), container.begin() + kIndexOffset + 20); // índice incompleto
+    damaged.emplace_back(container.begin(), container.begin() + 30); // cabecera incompleta
+    variant(kFieldsOffset, 0); // ancho
+    variant(kFieldsOffset + 8, ~0ULL); // alto
+    variant(kFieldsOffset + 16, 2); // canales
+    variant(kFieldsOffset + 24, 0); // tamaño de tesela
+    variant(kFieldsOffset + 32, 2); // teselas en X que no corresponden al ancho
+    variant(kFieldsOffset + 40, 3); // teselas en Y
+    // Dimensiones enormes pero coherentes: el índice no cabe en el archivo
+    bytes = container;
+    putU64(bytes, kFieldsOffset, 1 << 24);
+    putU64(bytes, kFieldsOffset + 8, 1 << 24);
+    putU64(bytes, kFieldsOffset + 24, 1);
+    putU64(bytes, kFieldsOffset + 32, 1 << 24);
+    putU64(bytes, kFieldsOffset + 40, 1 << 24);
+    damaged.push_back(bytes);
+    variant(kIndexOffset, getU64(container, kIndexOffset) + 1); // desplazamiento de la primera tesela
+    variant(kIndexOffset + 8, getU64(container, kIndexOffset + 8) - 1); // longitud
+    variant(kIndexOffset + 5 * 16 + 8, ~0ULL);
+
+    QuietErrors quiet;
+    for (const std::vector<unsigned char> &variantBytes: damaged) {
+        CHECK(writeFile(dir / "damaged.enc", variantBytes));
+        CHECK(!decryptTiles(dir / "damaged.enc", dir / "damaged.out"));
+        CHECK(!decryptTile(dir / "damaged.enc", 0, 0, dir / "damaged.out"));
+    }
+    CHECK(!decryptTiles(dir / "no-existe.enc", dir / "damaged.out"));
+}
+
+int main(int argc, char **argv) {
+    setVerbose(false);
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " <directorio de imágenes>" << std::endl;
+        return 1;
+    }
+    std::string images = argv[1];
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("tiles");
+
+    testRoundTrip(dir);
+    testJpeg(dir, images + "/1.jpeg");
+    testTamper(dir);
+    testMalformed(dir);
+    return finish("tiles");
+}
@@ -0,0 +1,133 @@
+// Pruebas de la carpeta vigilada (inotify): los archivos que se dejan en ella aparecen cifrados en la salida
+
+#include "test_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+using namespace enigmacore;
+using namespace enigmacore_test;
+
+// Espera como mucho diez segundos a que se cumpla 'condition'
+static bool waitFor(const std::function<bool()> &condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+// Vigila una carpeta en otro hilo mientras vive el objeto
+class Watcher {
+public:
+    Watcher(const std::string &input_dir, const std::string &output_dir, WatchOptions options) {
+        options.stop = &stop_;
+        options.debounce_ms = 50;
+        options.threads = 2;
+        thread_ = std::thread([this, input_dir, output_dir, options] {
+            result_ = watchFolder(input_dir, output_dir, options);
+        });
+    }
+    ~Watcher() { stopped(); }
+
+    // Detiene la vigilancia y devuelve el resultado de watchFolder
+    bool stopped() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        return result_;
+    }
+
+private:
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> result_{false};
+    std::thread thread_;
+};
+
+// Función para comprobar que 'encrypted' es el cifrado de 'data'
+static bool decryptsTo(const std::string &encrypted, const std::vector<unsigned char> &data) {
+    std::string output = encrypted + ".out";
+    return decrypt(encrypted, output, nullptr) && hasContent(output, data);
+}
+
+// Archivos que ya estaban, escritos durante la vigilancia o movidos a la carpeta; los ocultos se ignoran
+static void testDrop(const TempDir &dir) {
+    std::filesystem::create_directories(dir / "in");
+    std::vector<unsigned char> before = randomData(30000, 1);
+    CHECK(writeFile(dir / "in/before.bin", before));
+
+    Watcher watcher(dir / "in", dir / "out", WatchOptions());
+    CHECK(waitFor([&] { return std::filesystem::exists(dir / "out/before.bin.enc"); }));
+
+    std::vector<unsigned char> dropped = randomData(200000, 2);
+    CHECK(writeFile(dir / "in/dropped.bin", dropped));
+    std::vector<unsigned char> moved = randomData(5000, 3);
+    CHECK(writeFile(dir / "in/.moved.tmp", moved));
+    std::filesystem::rename(dir / "in/.moved.tmp", dir / "in/moved.bin");
+    CHECK(writeFile(dir / "in/.hidden", moved));
+
+    CHECK(waitFor([&] {
+        return std::filesystem::exists(dir / "out/dropped.bin.enc") &&
+               std::filesystem::exists(dir / "out/moved.bin.enc");
+    }));
+    CHECK(watcher.stopped());
+
+    CHECK(decryptsTo(dir / "out/before.bin.enc", before));
+    CHECK(decryptsTo(dir / "out/dropped.bin.enc", dropped));
+    CHECK(decryptsTo(dir / "out/moved.bin.enc", moved));
+    CHECK(!std::filesystem::exists(dir / "out/.hidden.enc"));
+    CHECK(!std::filesystem::exists(dir / "out/dropped.bin.enc.part"));
+    // Por defecto los originales se conservan
+    CHECK(hasContent(dir / "in/dropped.bin", dropped));
+}
+
+// Tras cifrar y verificar, los originales se borran o se mueven
+static void testAfterSuccess(const TempDir &dir) {
+    std::filesystem::create_directories(dir / "delete");
+    std::filesystem::create_directories(dir / "move");
+    std::vector<unsigned char> data = randomData(50000, 4);
+
+    WatchOptions deleting;
+    deleting.after = WatchOptions::DeleteOriginals;
+    WatchOptions moving;
+    moving.after = WatchOptions::MoveOriginals;
+    moving.move_dir = dir / "done";
+    Watcher deleter(dir / "delete", dir / "deleted.out", deleting);
+    Watcher mover(dir / "move", dir / "moved.out", moving);
+
+    CHECK(writeFile(dir / "delete/file.bin", data));
+    CHECK(writeFile(dir / "move/file.bin", data));
+    CHECK(waitFor([&] {
+        return !std::filesystem::exists(dir / "delete/file.bin") && !std::filesystem::exists(dir / "move/file.bin");
+    }));
+    CHECK(deleter.stopped() && mover.stopped());
+
+    CHECK(decryptsTo(dir / "deleted.out/file.bin.enc", data));
+    CHECK(decryptsTo(dir / "moved.out/file.bin.enc", data));
+    CHECK(hasContent(dir / "done/file.bin", data));
+}
+
+// Carpetas que no se pueden vigilar
+static void testInvalid(const TempDir &dir) {
+    QuietErrors quiet;
+    std::atomic<bool> stop{true};
+    WatchOptions options;
+    options.stop = &stop;
+    CHECK(!watchFolder(dir / "no-existe", dir / "salida", options));
+    std::filesystem::create_directories(dir / "same");
+    CHECK(!watchFolder(dir / "same", dir / "same", options));
+}
+
+int main() {
+    setVerbose(false);
+    TempDir dir;
+    CHECK(dir.valid());
+    if (failures()) return finish("watch");
+
+    testDrop(dir);
+    testAfterSuccess(dir);
+    testInvalid(dir);
+    return finish("watch");
+}